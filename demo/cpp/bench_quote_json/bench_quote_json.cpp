@@ -0,0 +1,141 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/common_struct.h"
+#include "common/converter.h"
+#include "common/quote_json.h"
+#include "common/price_tick.h"
+#include "common/enum.h"
+
+using namespace babeltrader;
+
+// compare the specialized quote encoder with the rapidjson path of converter
+// usage: bench_quote_json [msgs] [instruments]
+
+static int64_t NowNs()
+{
+	auto t = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(t).count();
+}
+
+static void FillQuote(Quote &quote, int idx)
+{
+	memset(&quote, 0, sizeof(quote));
+	quote.market = Market_CTP;
+	quote.exchange = Exchange_SHFE;
+	quote.type = ProductType_Future;
+	quote.info1 = QuoteInfo1_MarketData;
+	quote.info2 = QuoteInfo2_Unknown;
+	snprintf(quote.symbol, sizeof(quote.symbol), "rb");
+	snprintf(quote.contract, sizeof(quote.contract), "%d", 1801 + idx);
+	snprintf(quote.contract_id, sizeof(quote.contract_id), "%d", 1801 + idx);
+}
+
+static void FillMarketData(QuoteMarketData &msg, int idx, int seq)
+{
+	memset(&msg, 0, sizeof(msg));
+	msg.quote_type = QuoteBlockType_MarketData;
+	FillQuote(msg.quote, idx);
+
+	MarketData &md = msg.market_data;
+	double base = 3500.0 + idx + (seq % 100) * 0.5;
+	md.ts = 1514736000000 + seq;
+	md.last = base;
+	md.bid_ask_len = 5;
+	for (int i = 0; i < md.bid_ask_len; i++) {
+		md.bids[i].price = base - (i + 1) * 0.5;
+		md.bids[i].vol = 10 + (seq + i) % 500;
+		md.asks[i].price = base + (i + 1) * 0.5;
+		md.asks[i].vol = 20 + (seq + i) % 300;
+	}
+	md.vol = 123456 + seq;
+	md.turnover = md.vol * base * 10.0;
+	md.avg_price = base * 10.0 + 0.123;
+	md.pre_settlement = 3480.0;
+	md.pre_close = 3479.5;
+	md.pre_open_interest = 2345678;
+	md.settlement = 0.0;
+	md.close = 0.0;
+	md.open_interest = 2345678 + seq % 1000;
+	md.upper_limit = 3758.0;
+	md.lower_limit = 3201.0;
+	md.open = 3490.0;
+	md.high = base + 10.0;
+	md.low = base - 10.0;
+	snprintf(md.trading_day, sizeof(md.trading_day), "20180101");
+	snprintf(md.action_day, sizeof(md.action_day), "20171231");
+}
+
+static void SerializeRapidjson(rapidjson::StringBuffer &s, const QuoteMarketData &msg, std::string &rec)
+{
+	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	s.Clear();
+	SerializeQuoteBegin(writer, msg.quote);
+	SerializeMarketData(writer, msg.market_data);
+	SerializeQuoteEnd(writer, msg.quote);
+	rec.assign(s.GetString(), s.GetSize());
+}
+
+int main(int argc, char *argv[])
+{
+	int cnt = argc > 1 ? atoi(argv[1]) : 1000000;
+	int instruments = argc > 2 ? atoi(argv[2]) : 100;
+	if (cnt <= 0 || instruments <= 0) {
+		fprintf(stderr, "usage: %s [msgs] [instruments]\n", argv[0]);
+		return 1;
+	}
+
+	// prepared up front, so only the serialization is measured
+	const int pool = 4096;
+	std::vector<QuoteMarketData> msgs(pool);
+	for (int i = 0; i < pool; i++) {
+		FillMarketData(msgs[i], i % instruments, i);
+	}
+
+	rapidjson::StringBuffer s;
+	QuoteJsonEncoder encoder;
+	std::string expect, rec;
+
+	// without quote_price_ticks the service passes its empty table, prices must stay
+	// the same as the converter. with ticks they are fixed point and differ on purpose
+	PriceTickTable no_ticks;
+	const PriceTickTable *tick_tables[] = { nullptr, &no_ticks };
+	for (const PriceTickTable *ticks : tick_tables) {
+		for (int i = 0; i < pool; i++) {
+			SerializeRapidjson(s, msgs[i], expect);
+			encoder.Encode((const QuoteBlockCommon*)&msgs[i], rec, ticks);
+			if (rec != expect) {
+				fprintf(stderr, "output mismatch at %d, %s tick table\nrapidjson: %s\nencoder:   %s\n",
+					i, ticks ? "empty" : "no", expect.c_str(), rec.c_str());
+				return 1;
+			}
+		}
+	}
+
+	size_t bytes = 0;
+	int64_t start = NowNs();
+	for (int i = 0; i < cnt; i++) {
+		SerializeRapidjson(s, msgs[i % pool], rec);
+		bytes += rec.size();
+	}
+	int64_t rapidjson_ns = NowNs() - start;
+
+	start = NowNs();
+	for (int i = 0; i < cnt; i++) {
+		encoder.Encode((const QuoteBlockCommon*)&msgs[i % pool], rec, &no_ticks);
+		bytes += rec.size();
+	}
+	int64_t encoder_ns = NowNs() - start;
+
+	printf("msgs: %d, instruments: %d, avg bytes: %zu\n", cnt, instruments, bytes / cnt / 2);
+	printf("rapidjson: %.1f ns/msg\n", (double)rapidjson_ns / cnt);
+	printf("encoder:   %.1f ns/msg\n", (double)encoder_ns / cnt);
+	printf("speedup:   %.2fx\n", encoder_ns > 0 ? (double)rapidjson_ns / encoder_ns : 0.0);
+
+	return 0;
+}
@@ -21,8 +21,6 @@ namespace babeltrader
 #define BIDASK_MAX_LEN 10
 #define QUOTE_DATETIME_LEN 32
 
-#define QuoteBlockSize 1024
-
 struct Quote
 {
 	uint8_t market;		// MarketEnum
@@ -161,12 +159,6 @@ struct QuoteBlockCommon
 	Quote quote;
 };
 
-struct QuoteBlock
-{
-	uint8_t quote_type;
-	char buf[QuoteBlockSize];
-};
-
 //////////////////////////
 // trade
 
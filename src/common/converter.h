@@ -6,11 +6,16 @@
 #include "rapidjson/stringbuffer.h"
 
 #include "common/common_struct.h"
+#include "common/price_tick.h"
 
 namespace babeltrader
 {
 
 
+// writer.Double, except nan and inf are written as null like QuoteJsonEncoder does.
+// rapidjson refuses them and leaves a truncated document
+void SerializeDouble(rapidjson::Writer<rapidjson::StringBuffer> &writer, double d);
+
 void SerializeQuoteBegin(rapidjson::Writer<rapidjson::StringBuffer> &writer, const Quote &quote);
 void SerializeQuoteEnd(rapidjson::Writer<rapidjson::StringBuffer> &writer, const Quote &quote);
 
@@ -19,9 +24,9 @@ void SerializeOrderBook(rapidjson::Writer<rapidjson::StringBuffer> &writer, cons
 void SerializeKline(rapidjson::Writer<rapidjson::StringBuffer> &writer, const Kline &kline);
 void SerializeLevel2(rapidjson::Writer<rapidjson::StringBuffer> &writer, const OrderBookLevel2 &level2);
 
-void SerializeOrder(rapidjson::Writer<rapidjson::StringBuffer> &writer, const Order &order);
+void SerializeOrder(rapidjson::Writer<rapidjson::StringBuffer> &writer, const Order &order, const PriceTick *tick = nullptr);
 void SerializeOrderStatus(rapidjson::Writer<rapidjson::StringBuffer> &writer, const OrderStatusNotify &order_status);
-void SerializeOrderDeal(rapidjson::Writer<rapidjson::StringBuffer> &writer, const OrderDealNotify &order_deal);
+void SerializeOrderDeal(rapidjson::Writer<rapidjson::StringBuffer> &writer, const OrderDealNotify &order_deal, const PriceTick *tick = nullptr);
 void SerializeOrderQuery(rapidjson::Writer<rapidjson::StringBuffer> &writer, const OrderQuery &order_query);
 void SerializeTradeQuery(rapidjson::Writer<rapidjson::StringBuffer> &writer, const TradeQuery &trade_query);
 void SerializePositionQuery(rapidjson::Writer<rapidjson::StringBuffer> &writer, const PositionQuery &position_query);
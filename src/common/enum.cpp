@@ -93,6 +93,10 @@ const char *g_order_type[OrderType_Max] = {
 	"market",
 	"best"
 };
+OrderTypeEnum getOrderTypeEnum(const char *order_type)
+{
+	GET_ENUM_BY_STR(order_type, g_order_type, OrderTypeEnum, OrderType_Max);
+}
 
 const char *g_order_flag1[OrderFlag1_Max] = {
 	"",
@@ -101,6 +105,10 @@ const char *g_order_flag1[OrderFlag1_Max] = {
 	"hedge",
 	"marketmaker"
 };
+OrderFlag1Enum getOrderFlag1Enum(const char *order_flag1)
+{
+	GET_ENUM_BY_STR(order_flag1, g_order_flag1, OrderFlag1Enum, OrderFlag1_Max);
+}
 
 const char *g_order_action[OrderAction_Max] = {
 	"",
@@ -114,6 +122,10 @@ const char *g_order_action[OrderAction_Max] = {
 	"borrow",
 	"lend"
 };
+OrderActionEnum getOrderActionEnum(const char *order_action)
+{
+	GET_ENUM_BY_STR(order_action, g_order_action, OrderActionEnum, OrderAction_Max);
+}
 
 const char *g_order_dir[OrderDir_Max] = {
 	"",
@@ -121,6 +133,10 @@ const char *g_order_dir[OrderDir_Max] = {
 	"long",
 	"short"
 };
+OrderDirEnum getOrderDirEnum(const char *order_dir)
+{
+	GET_ENUM_BY_STR(order_dir, g_order_dir, OrderDirEnum, OrderDir_Max);
+}
 
 const char *g_account_type[AccountType_Max] = {
 	"",
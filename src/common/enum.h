@@ -85,6 +85,7 @@ enum OrderTypeEnum
 	OrderType_Max,
 };
 extern const char *g_order_type[OrderType_Max];
+OrderTypeEnum getOrderTypeEnum(const char *order_type);
 
 
 enum OrderFlag1Enum
@@ -97,6 +98,7 @@ enum OrderFlag1Enum
 	OrderFlag1_Max,
 };
 extern const char *g_order_flag1[OrderFlag1_Max];
+OrderFlag1Enum getOrderFlag1Enum(const char *order_flag1);
 
 enum OrderActionEnum
 {
@@ -113,6 +115,7 @@ enum OrderActionEnum
 	OrderAction_Max,
 };
 extern const char *g_order_action[OrderAction_Max];
+OrderActionEnum getOrderActionEnum(const char *order_action);
 
 enum OrderDirEnum
 {
@@ -123,6 +126,7 @@ enum OrderDirEnum
 	OrderDir_Max,
 };
 extern const char *g_order_dir[OrderDir_Max];
+OrderDirEnum getOrderDirEnum(const char *order_dir);
 
 enum AccountTypeEnum
 {
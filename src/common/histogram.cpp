@@ -0,0 +1,99 @@
+#include "histogram.h"
+
+namespace babeltrader
+{
+
+
+static int BucketIndex(uint64_t v)
+{
+	int i = 0;
+	while (v) {
+		v >>= 1;
+		i++;
+	}
+	return i;
+}
+
+uint64_t HistogramSnapshot::Percentile(double p) const
+{
+	if (count == 0) {
+		return 0;
+	}
+
+	uint64_t rank = (uint64_t)(p * count);
+	if (rank >= count) {
+		rank = count - 1;
+	}
+
+	uint64_t seen = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		seen += buckets[i];
+		if (seen > rank) {
+			uint64_t upper = i == 0 ? 0 : (i >= 64 ? UINT64_MAX : ((uint64_t)1 << i) - 1);
+			return upper < max ? upper : max;
+		}
+	}
+	return max;
+}
+
+Histogram::Histogram()
+	: count_(0)
+	, sum_(0)
+	, min_(UINT64_MAX)
+	, max_(0)
+{
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		buckets_[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void Histogram::Record(uint64_t v)
+{
+	buckets_[BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+	count_.fetch_add(1, std::memory_order_relaxed);
+	sum_.fetch_add(v, std::memory_order_relaxed);
+
+	uint64_t cur = min_.load(std::memory_order_relaxed);
+	while (v < cur && !min_.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+
+	cur = max_.load(std::memory_order_relaxed);
+	while (v > cur && !max_.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+
+void Histogram::Snapshot(HistogramSnapshot &snapshot) const
+{
+	// not an atomic view, good enough for monitor
+	snapshot.count = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+		snapshot.count += snapshot.buckets[i];
+	}
+	snapshot.sum = sum_.load(std::memory_order_relaxed);
+	snapshot.min = snapshot.count > 0 ? min_.load(std::memory_order_relaxed) : 0;
+	snapshot.max = max_.load(std::memory_order_relaxed);
+}
+
+void SerializeHistogram(rapidjson::Writer<rapidjson::StringBuffer> &writer, const HistogramSnapshot &snapshot)
+{
+	writer.StartObject();
+	writer.Key("count");
+	writer.Uint64(snapshot.count);
+	writer.Key("min");
+	writer.Uint64(snapshot.min);
+	writer.Key("max");
+	writer.Uint64(snapshot.max);
+	writer.Key("avg");
+	writer.Double(snapshot.count > 0 ? (double)snapshot.sum / snapshot.count : 0.0);
+	writer.Key("p50");
+	writer.Uint64(snapshot.Percentile(0.5));
+	writer.Key("p90");
+	writer.Uint64(snapshot.Percentile(0.9));
+	writer.Key("p99");
+	writer.Uint64(snapshot.Percentile(0.99));
+	writer.Key("p999");
+	writer.Uint64(snapshot.Percentile(0.999));
+	writer.EndObject();
+}
+
+
+}
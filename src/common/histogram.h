@@ -0,0 +1,54 @@
+#ifndef BABELTRADER_HISTOGRAM_H_
+#define BABELTRADER_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+
+namespace babeltrader
+{
+
+// bucket 0 holds 0, bucket i holds [2^(i-1), 2^i)
+#define HISTOGRAM_BUCKETS 65
+
+struct HistogramSnapshot
+{
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint64_t buckets[HISTOGRAM_BUCKETS];
+
+	// upper bound of the bucket where the p-th (0 ~ 1) value falls, capped by max
+	uint64_t Percentile(double p) const;
+};
+
+// lock free log2 histogram, Record() from any thread
+class Histogram
+{
+public:
+	Histogram();
+
+	Histogram(const Histogram&) = delete;
+	Histogram& operator=(const Histogram&) = delete;
+
+	void Record(uint64_t v);
+	void Snapshot(HistogramSnapshot &snapshot) const;
+
+private:
+	std::atomic<uint64_t> count_;
+	std::atomic<uint64_t> sum_;
+	std::atomic<uint64_t> min_;
+	std::atomic<uint64_t> max_;
+	std::atomic<uint64_t> buckets_[HISTOGRAM_BUCKETS];
+};
+
+// {"count":..,"min":..,"max":..,"avg":..,"p50":..,"p90":..,"p99":..,"p999":..}
+void SerializeHistogram(rapidjson::Writer<rapidjson::StringBuffer> &writer, const HistogramSnapshot &snapshot);
+
+
+}
+
+#endif
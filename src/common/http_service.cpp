@@ -1,6 +1,7 @@
 #include "http_service.h"
 
 #include <assert.h>
+#include <stdlib.h>
 
 #include "glog/logging.h"
 #include "rapidjson/writer.h"
@@ -9,10 +10,59 @@
 #include "rapidjson/error/en.h"
 
 #include "err.h"
+#include "enum.h"
+#include "ws_service.h"
+#include "utils_func.h"
+#include "converter.h"
 
 namespace babeltrader
 {
 
+static void SerializeRingStats(rapidjson::Writer<rapidjson::StringBuffer> &writer, const QuoteRingStats &stats)
+{
+	writer.StartObject();
+	writer.Key("capacity");
+	writer.Uint64(stats.capacity);
+	writer.Key("depth_bytes");
+	writer.Uint64(stats.depth_bytes);
+	writer.Key("depth_records");
+	writer.Uint64(stats.depth_records);
+	writer.Key("peak_bytes");
+	writer.Uint64(stats.peak_bytes);
+	writer.Key("peak_records");
+	writer.Uint64(stats.peak_records);
+	writer.Key("write_records");
+	writer.Uint64(stats.write_records);
+	writer.Key("drop_records");
+	writer.Uint64(stats.drop_records);
+	writer.Key("block_records");
+	writer.Uint64(stats.block_records);
+	writer.EndObject();
+}
+
+// instruments of symbol + contract, or comma separated list of "instruments"
+static void ParseInstrumentKeys(std::map<std::string, std::string> &params, std::vector<std::string> &keys)
+{
+	if (!params["symbol"].empty())
+	{
+		keys.push_back(params["symbol"] + params["contract"]);
+	}
+	const std::string &instruments = params["instruments"];
+	size_t begin = 0;
+	while (begin < instruments.size())
+	{
+		size_t end = instruments.find(',', begin);
+		if (end == std::string::npos)
+		{
+			end = instruments.size();
+		}
+		if (end > begin)
+		{
+			keys.push_back(instruments.substr(begin, end - begin));
+		}
+		begin = end + 1;
+	}
+}
 
 HttpService::HttpService(QuoteService *quote_service, TradeService *trade_service)
 	: quote_(quote_service)
@@ -22,6 +72,15 @@ HttpService::HttpService(QuoteService *quote_service, TradeService *trade_servic
 void HttpService::onMessage(uWS::HttpResponse *res, uWS::HttpRequest &req, char *data, size_t length, size_t remainingBytes)
 {
 	auto url = req.getUrl().toString();
+
+	std::map<std::string, std::string> params;
+	auto pos = url.find('?');
+	if (pos != std::string::npos)
+	{
+		ParseUrlQuery(url.substr(pos + 1), params);
+		url = url.substr(0, pos);
+	}
+
 	if (url == "/topic/get") 
 	{
 		GetSubtopics(res);
@@ -34,6 +93,26 @@ void HttpService::onMessage(uWS::HttpResponse *res, uWS::HttpRequest &req, char
 	{
 		UnsubTopic(res, req, data, length, remainingBytes);
 	}
+	else if (url == "/quote/stats" && quote_)
+	{
+		GetQuoteStats(res);
+	}
+	else if (url == "/quote/snapshot" && quote_)
+	{
+		GetQuoteSnapshot(res, params);
+	}
+	else if (url == "/kline/history" && quote_)
+	{
+		GetKlineHistory(res, params);
+	}
+	else if (url == "/buffer/stats")
+	{
+		GetBufferStats(res);
+	}
+	else if (url == "/ws/stats")
+	{
+		GetWsStats(res);
+	}
 	else
 	{
 		res->getHttpSocket()->terminate();
@@ -86,6 +165,350 @@ void HttpService::GetSubtopics(uWS::HttpResponse *res)
 
 	res->end(s.GetString(), s.GetLength());
 }
+void HttpService::GetQuoteStats(uWS::HttpResponse *res)
+{
+	QuoteRingStats ring_stats;
+	quote_->GetQuoteRingStats(ring_stats);
+
+	std::vector<QuoteRingStats> worker_stats;
+	quote_->GetWorkerRingStats(worker_stats);
+
+	std::vector<QuoteConnStats> conn_stats;
+	quote_->GetConnStats(conn_stats);
+
+	std::vector<QuoteBatchStats> batch_stats;
+	quote_->GetBatchStats(batch_stats);
+
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+
+	writer.StartObject();
+	writer.Key("msg");
+	writer.String("quote_stats");
+
+	writer.Key("data");
+	writer.StartObject();
+
+	writer.Key("ring");
+	SerializeRingStats(writer, ring_stats);
+
+	writer.Key("workers");
+	writer.StartArray();
+	for (auto &worker : worker_stats) {
+		SerializeRingStats(writer, worker);
+	}
+	writer.EndArray();
+
+	writer.Key("conns");
+	writer.StartArray();
+	for (auto &conn : conn_stats) {
+		writer.StartObject();
+		writer.Key("addr");
+		writer.String(conn.addr.c_str());
+		writer.Key("encoding");
+		writer.String(g_quote_encoding[conn.encoding]);
+		writer.Key("batch");
+		writer.String(conn.batch.c_str());
+		writer.Key("sub_all");
+		writer.Bool(conn.sub_all);
+		writer.Key("topics");
+		writer.Int(conn.topics);
+		writer.Key("pending_frames");
+		writer.Int64(conn.pending_frames);
+		writer.Key("pending_bytes");
+		writer.Int64(conn.pending_bytes);
+		writer.Key("peak_bytes");
+		writer.Int64(conn.peak_bytes);
+		writer.Key("sent_frames");
+		writer.Uint64(conn.sent_frames);
+		writer.Key("drop_frames");
+		writer.Uint64(conn.drop_frames);
+		writer.Key("slow_times");
+		writer.Uint64(conn.slow_times);
+		writer.Key("slow");
+		writer.Bool(conn.slow);
+		writer.Key("compress");
+		writer.Bool(conn.compress);
+		writer.Key("compress_frames");
+		writer.Uint64(conn.compress_frames);
+		writer.Key("compress_in_bytes");
+		writer.Uint64(conn.compress_in_bytes);
+		writer.Key("compress_out_bytes");
+		writer.Uint64(conn.compress_out_bytes);
+		writer.Key("compress_ratio");
+		writer.Double(conn.compress_in_bytes > 0 ? (double)conn.compress_out_bytes / conn.compress_in_bytes : 0.0);
+		writer.Key("compress_us");
+		writer.Uint64(conn.compress_us);
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.Key("batch");
+	writer.StartArray();
+	for (auto &batch : batch_stats) {
+		writer.StartObject();
+		writer.Key("name");
+		writer.String(batch.policy.name.c_str());
+		writer.Key("max_msgs");
+		writer.Int(batch.policy.max_msgs);
+		writer.Key("max_bytes");
+		writer.Int64(batch.policy.max_bytes);
+		writer.Key("max_delay_us");
+		writer.Int64(batch.policy.max_delay_us);
+		writer.Key("immediate");
+		writer.Bool(batch.policy.immediate);
+		writer.Key("size");
+		SerializeHistogram(writer, batch.size);
+		writer.Key("delay_us");
+		SerializeHistogram(writer, batch.delay_us);
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.EndObject();  // data end
+
+	writer.EndObject();
+
+	res->end(s.GetString(), s.GetLength());
+}
+void HttpService::GetBufferStats(uWS::HttpResponse *res)
+{
+	std::vector<SerializeBufferStats> buffer_stats;
+	SerializeBuffer::GetStats(buffer_stats);
+
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+
+	writer.StartObject();
+	writer.Key("msg");
+	writer.String("buffer_stats");
+
+	writer.Key("data");
+	writer.StartArray();
+	for (auto &stats : buffer_stats) {
+		writer.StartObject();
+		writer.Key("name");
+		writer.String(stats.name.c_str());
+		writer.Key("threads");
+		writer.Int64(stats.threads);
+		writer.Key("uses");
+		writer.Int64(stats.uses);
+		writer.Key("nested");
+		writer.Int64(stats.nested);
+		writer.Key("grows");
+		writer.Int64(stats.grows);
+		writer.Key("shrinks");
+		writer.Int64(stats.shrinks);
+		writer.Key("high_water");
+		writer.Int64(stats.high_water);
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.EndObject();
+
+	res->end(s.GetString(), s.GetLength());
+}
+void HttpService::GetWsStats(uWS::HttpResponse *res)
+{
+	std::vector<WsMsgStats> msg_stats;
+	std::vector<WsShardStats> shard_stats;
+	std::vector<WsLaneStats> lane_stats;
+	std::vector<WsOutboxStats> outbox_stats;
+	WsService *ws_service = quote_ ? quote_->ws_service_ : (trade_ ? trade_->ws_service_ : nullptr);
+	if (ws_service) {
+		ws_service->GetMsgStats(msg_stats);
+		ws_service->GetShardStats(shard_stats);
+		ws_service->GetLaneStats(lane_stats);
+		ws_service->GetOutboxStats(outbox_stats);
+	}
+
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+
+	writer.StartObject();
+	writer.Key("msg");
+	writer.String("ws_stats");
+
+	writer.Key("data");
+	writer.StartArray();
+	for (auto &stats : msg_stats) {
+		writer.StartObject();
+		writer.Key("msg");
+		writer.String(stats.msg.c_str());
+		writer.Key("parse_ns");
+		SerializeHistogram(writer, stats.parse_ns);
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.Key("shards");
+	writer.StartArray();
+	for (auto &stats : shard_stats) {
+		writer.StartObject();
+		writer.Key("shard");
+		writer.Int(stats.shard);
+		writer.Key("depth");
+		writer.Int64(stats.depth);
+		writer.Key("peak_depth");
+		writer.Int64(stats.peak_depth);
+		writer.Key("processed");
+		writer.Uint64(stats.processed);
+		writer.Key("put_depth");
+		SerializeHistogram(writer, stats.put_depth);
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.Key("lanes");
+	writer.StartArray();
+	for (auto &stats : lane_stats) {
+		writer.StartObject();
+		writer.Key("lane");
+		writer.String(stats.lane.c_str());
+		writer.Key("processed");
+		writer.Uint64(stats.processed);
+		writer.Key("wait_ns");
+		SerializeHistogram(writer, stats.wait_ns);
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.Key("outbox");
+	writer.StartArray();
+	for (auto &stats : outbox_stats) {
+		writer.StartObject();
+		writer.Key("hub");
+		writer.Int(stats.hub);
+		writer.Key("ring");
+		SerializeRingStats(writer, stats.ring);
+		writer.Key("wakeups");
+		writer.Uint64(stats.wakeups);
+		writer.Key("direct_sends");
+		writer.Uint64(stats.direct_sends);
+		writer.Key("large_sends");
+		writer.Uint64(stats.large_sends);
+		writer.Key("batch");
+		SerializeHistogram(writer, stats.batch);
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.EndObject();
+
+	res->end(s.GetString(), s.GetLength());
+}
+// symbol and contract for one instrument, instruments=rb1901,cu1901 for many, nothing for all
+void HttpService::GetQuoteSnapshot(uWS::HttpResponse *res, std::map<std::string, std::string> &params)
+{
+	std::vector<std::string> keys;
+	ParseInstrumentKeys(params, keys);
+
+	std::string records;
+	std::vector<std::string> missing;
+	quote_->GetSnapshots(keys, records, missing);
+
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+
+	writer.StartObject();
+	writer.Key("msg");
+	writer.String("snapshot");
+
+	// records are the same json as ws quote messages, already serialized
+	writer.Key("data");
+	records.insert(0, 1, '[');
+	records.append(1, ']');
+	writer.RawValue(records.data(), records.size(), rapidjson::kArrayType);
+
+	writer.Key("missing");
+	writer.StartArray();
+	for (auto &key : missing) {
+		writer.String(key.c_str());
+	}
+	writer.EndArray();
+
+	writer.EndObject();
+
+	res->end(s.GetString(), s.GetLength());
+}
+void HttpService::GetKlineHistory(uWS::HttpResponse *res, std::map<std::string, std::string> &params)
+{
+	int info2 = QuoteInfo2_1Min;
+	if (!params["interval"].empty())
+	{
+		info2 = getQuoteInfo2Enum(params["interval"].c_str());
+		if (info2 == QuoteInfo2_Unknown)
+		{
+			RestReturn(res, BABELTRADER_ERR_HTTPREQ_FAILED_PARSE, "invalid interval");
+			return;
+		}
+	}
+	int n = atoi(params["n"].c_str());
+
+	std::vector<std::string> keys;
+	ParseInstrumentKeys(params, keys);
+
+	KlineHistoryResult result;
+	quote_->GetKlineHistory(keys, info2, n, result);
+
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+
+	writer.StartObject();
+	writer.Key("msg");
+	writer.String("kline_history");
+
+	writer.Key("data");
+	writer.StartArray();
+	for (auto &series : result.series) {
+		const Quote &quote = series.quote;
+		writer.StartObject();
+		writer.Key("market");
+		writer.String(g_markets[quote.market]);
+		writer.Key("exchange");
+		writer.String(g_exchanges[quote.exchange]);
+		writer.Key("type");
+		writer.String(g_product_types[quote.type]);
+		writer.Key("symbol");
+		writer.String(quote.symbol);
+		writer.Key("contract");
+		writer.String(quote.contract);
+		writer.Key("contract_id");
+		writer.String(quote.contract_id);
+		writer.Key("interval");
+		writer.String(g_quote_info2[quote.info2]);
+
+		// [ts, open, high, low, close, vol], oldest first
+		writer.Key("klines");
+		writer.StartArray();
+		for (size_t i = series.offset; i < series.offset + series.cnt; i++) {
+			const Kline &kline = result.bars[i];
+			writer.StartArray();
+			writer.Int64(kline.ts);
+			SerializeDouble(writer, kline.open);
+			SerializeDouble(writer, kline.high);
+			SerializeDouble(writer, kline.low);
+			SerializeDouble(writer, kline.close);
+			SerializeDouble(writer, kline.vol);
+			writer.EndArray();
+		}
+		writer.EndArray();
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	writer.Key("missing");
+	writer.StartArray();
+	for (auto &key : result.missing) {
+		writer.String(key.c_str());
+	}
+	writer.EndArray();
+
+	writer.EndObject();
+
+	res->end(s.GetString(), s.GetLength());
+}
 void HttpService::SubTopic(uWS::HttpResponse *res, uWS::HttpRequest &req, char *data, size_t length, size_t remainingBytes)
 {
 	Quote msg;
@@ -5,6 +5,7 @@
 #include "common/quote_service.h"
 #include "common/trade_service.h"
 #include "common/common_struct.h"
+#include "common/serialize_buffer.h"
 
 namespace babeltrader
 {
@@ -19,6 +20,11 @@ public:
 
 private:
 	void GetSubtopics(uWS::HttpResponse *res);
+	void GetQuoteStats(uWS::HttpResponse *res);
+	void GetBufferStats(uWS::HttpResponse *res);
+	void GetWsStats(uWS::HttpResponse *res);
+	void GetQuoteSnapshot(uWS::HttpResponse *res, std::map<std::string, std::string> &params);
+	void GetKlineHistory(uWS::HttpResponse *res, std::map<std::string, std::string> &params);
 	void SubTopic(uWS::HttpResponse *res, uWS::HttpRequest &req, char *data, size_t length, size_t remainingBytes);
 	void UnsubTopic(uWS::HttpResponse *res, uWS::HttpRequest &req, char *data, size_t length, size_t remainingBytes);
 
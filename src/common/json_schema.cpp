@@ -0,0 +1,52 @@
+#include "json_schema.h"
+
+#include <stdexcept>
+
+namespace babeltrader
+{
+
+#define JSON_KEY_HASH_MAX_SEED 100000
+
+void JsonKeyHash::Build(const std::vector<const char*> &keys)
+{
+	keys_ = keys;
+	lens_.clear();
+	for (auto key : keys_) {
+		lens_.push_back(strlen(key));
+	}
+
+	// table of at least twice the keys keeps the search short
+	uint32_t size = 1;
+	while (size < keys_.size() * 2) {
+		size <<= 1;
+	}
+
+	while (true) {
+		mask_ = size - 1;
+		for (uint32_t seed = 0; seed < JSON_KEY_HASH_MAX_SEED; seed++) {
+			slots_.assign(size, -1);
+			bool ok = true;
+			for (size_t i = 0; i < keys_.size(); i++) {
+				uint32_t slot = Hash(keys_[i], lens_[i], seed) & mask_;
+				if (slots_[slot] >= 0) {
+					ok = false;
+					break;
+				}
+				slots_[slot] = (int)i;
+			}
+			if (ok) {
+				seed_ = seed;
+				return;
+			}
+		}
+
+		// duplicated keys never fit, anything else does in a bigger table
+		if (size >= (1u << 16)) {
+			throw std::runtime_error("failed build json key hash, duplicated keys?");
+		}
+		size <<= 1;
+	}
+}
+
+
+}
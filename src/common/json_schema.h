@@ -0,0 +1,217 @@
+#ifndef BABELTRADER_JSON_SCHEMA_H_
+#define BABELTRADER_JSON_SCHEMA_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "rapidjson/document.h"
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+
+#include "common/price_tick.h"
+
+namespace babeltrader
+{
+
+// how a member is held and how it goes on the wire. some members keep the
+// historical wire type of the hand written converters, e.g. amount is a double
+// written as an int
+enum JsonFieldTypeEnum
+{
+	JsonFieldType_String = 0,		// std::string
+	JsonFieldType_Double,			// double
+	JsonFieldType_Price,			// double, fixed point with the price tick when known
+	JsonFieldType_DoubleAsInt,		// double, written with Int()
+	JsonFieldType_Int64,			// int64_t
+	JsonFieldType_Int64AsDouble,	// int64_t, written with Double()
+	JsonFieldType_Max,
+};
+
+enum JsonFieldFlagEnum
+{
+	JsonFieldFlag_NoDecode = 1,		// filled by the gateway, ignored in requests
+};
+
+// descriptor of one member, tables of these are constexpr
+template <typename T>
+struct JsonField
+{
+	const char *name;
+	int type;
+	int flags;
+	std::string T::*str;
+	double T::*f64;
+	int64_t T::*i64;
+
+	constexpr JsonField(const char *name, int type, std::string T::*m, int flags)
+		: name(name), type(type), flags(flags), str(m), f64(nullptr), i64(nullptr)
+	{}
+	constexpr JsonField(const char *name, int type, double T::*m, int flags)
+		: name(name), type(type), flags(flags), str(nullptr), f64(m), i64(nullptr)
+	{}
+	constexpr JsonField(const char *name, int type, int64_t T::*m, int flags)
+		: name(name), type(type), flags(flags), str(nullptr), f64(nullptr), i64(m)
+	{}
+};
+
+// keys are always the member name
+#define JSON_FIELD(T, member, type) JsonField<T>(#member, type, &T::member, 0)
+#define JSON_FIELD_FLAGS(T, member, type, flags) JsonField<T>(#member, type, &T::member, flags)
+
+// perfect hash of a key set: seed picked so every key gets its own slot
+class JsonKeyHash
+{
+public:
+	void Build(const std::vector<const char*> &keys);
+
+	// index of the key, -1 if not in the set
+	int Find(const char *key, size_t len) const
+	{
+		int idx = slots_[Hash(key, len, seed_) & mask_];
+		if (idx < 0 || lens_[idx] != len || memcmp(keys_[idx], key, len) != 0) {
+			return -1;
+		}
+		return idx;
+	}
+
+	uint32_t Seed() const { return seed_; }
+	size_t KeyLen(size_t i) const { return lens_[i]; }
+
+	static uint32_t Hash(const char *key, size_t len, uint32_t seed)
+	{
+		uint32_t h = 2166136261u ^ seed;
+		for (size_t i = 0; i < len; i++) {
+			h = (h ^ (uint8_t)key[i]) * 16777619u;
+		}
+		return h ^ (h >> 15);
+	}
+
+private:
+	std::vector<const char*> keys_;
+	std::vector<size_t> lens_;
+	std::vector<int> slots_;
+	uint32_t seed_;
+	uint32_t mask_;
+};
+
+template <typename T>
+class JsonSchema
+{
+public:
+	template <size_t N>
+	explicit JsonSchema(const JsonField<T> (&fields)[N])
+		: fields_(fields)
+		, cnt_(N)
+	{
+		std::vector<const char*> keys;
+		for (size_t i = 0; i < N; i++) {
+			keys.push_back(fields[i].name);
+		}
+		hash_.Build(keys);
+	}
+
+	size_t Size() const { return cnt_; }
+	const JsonField<T>& Field(size_t i) const { return fields_[i]; }
+	size_t KeyLen(size_t i) const { return hash_.KeyLen(i); }
+
+	const JsonField<T>* Find(const char *key, size_t len) const
+	{
+		int idx = hash_.Find(key, len);
+		return idx < 0 ? nullptr : &fields_[idx];
+	}
+
+private:
+	const JsonField<T> *fields_;
+	size_t cnt_;
+	JsonKeyHash hash_;
+};
+
+// every field in table order
+template <typename T>
+void SerializeJsonFields(rapidjson::Writer<rapidjson::StringBuffer> &writer, const JsonSchema<T> &schema, const T &obj, const PriceTick *tick = nullptr)
+{
+	for (size_t i = 0; i < schema.Size(); i++) {
+		const JsonField<T> &field = schema.Field(i);
+		writer.Key(field.name, (rapidjson::SizeType)schema.KeyLen(i));
+		switch (field.type)
+		{
+			case JsonFieldType_String:
+			{
+				const std::string &s = obj.*field.str;
+				writer.String(s.c_str(), (rapidjson::SizeType)s.size());
+			}break;
+			case JsonFieldType_Double:
+			{
+				writer.Double(obj.*field.f64);
+			}break;
+			case JsonFieldType_Price:
+			{
+				SerializePrice(writer, obj.*field.f64, tick);
+			}break;
+			case JsonFieldType_DoubleAsInt:
+			{
+				writer.Int((int)(obj.*field.f64));
+			}break;
+			case JsonFieldType_Int64:
+			{
+				writer.Int64(obj.*field.i64);
+			}break;
+			case JsonFieldType_Int64AsDouble:
+			{
+				writer.Double((double)(obj.*field.i64));
+			}break;
+		}
+	}
+}
+
+// walks the members of msg once, each key is matched with the perfect hash.
+// unknown keys and values of the wrong type are skipped
+template <typename T>
+void ParseJsonFields(rapidjson::Value &msg, const JsonSchema<T> &schema, T &obj)
+{
+	if (!msg.IsObject()) {
+		return;
+	}
+
+	for (auto it = msg.MemberBegin(); it != msg.MemberEnd(); ++it) {
+		const JsonField<T> *field = schema.Find(it->name.GetString(), it->name.GetStringLength());
+		if (field == nullptr || (field->flags & JsonFieldFlag_NoDecode)) {
+			continue;
+		}
+
+		rapidjson::Value &v = it->value;
+		switch (field->type)
+		{
+			case JsonFieldType_String:
+			{
+				if (v.IsString()) {
+					(obj.*field->str).assign(v.GetString(), v.GetStringLength());
+				}
+			}break;
+			case JsonFieldType_Double:
+			case JsonFieldType_Price:
+			case JsonFieldType_DoubleAsInt:
+			{
+				if (v.IsInt()) {
+					obj.*field->f64 = v.GetInt();
+				} else if (v.IsDouble()) {
+					obj.*field->f64 = v.GetDouble();
+				}
+			}break;
+			case JsonFieldType_Int64:
+			case JsonFieldType_Int64AsDouble:
+			{
+				if (v.IsInt64()) {
+					obj.*field->i64 = v.GetInt64();
+				}
+			}break;
+		}
+	}
+}
+
+
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "kline_history.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "quote_snapshot.h"
+
+namespace babeltrader
+{
+
+KlineHistory::KlineHistory(int size)
+	: size_(size > 0 ? (size_t)size : 0)
+{}
+
+void KlineHistory::Update(const QuoteBlockCommon *msg)
+{
+	if (msg->quote_type != QuoteBlockType_Kline || size_ == 0) {
+		return;
+	}
+
+	const QuoteKline *kline = (const QuoteKline*)msg;
+	std::string key = QuoteSnapshotKey(msg->quote);
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	std::map<int, size_t> &intervals = index_[key];
+	auto it = intervals.find(msg->quote.info2);
+	size_t idx = 0;
+	if (it == intervals.end()) {
+		idx = series_.size();
+		KlineSeries series;
+		memcpy(&series.quote, &msg->quote, sizeof(series.quote));
+		series.cnt = 0;
+		series_.push_back(series);
+		bars_.resize(bars_.size() + size_);
+		intervals[msg->quote.info2] = idx;
+	}
+	else {
+		idx = it->second;
+	}
+
+	KlineSeries &series = series_[idx];
+	Kline *ring = &bars_[idx * size_];
+	if (series.cnt > 0) {
+		Kline &newest = ring[(series.cnt - 1) % size_];
+		if (kline->kline.ts < newest.ts) {
+			return;
+		}
+		if (kline->kline.ts == newest.ts) {
+			newest = kline->kline;
+			return;
+		}
+	}
+
+	ring[series.cnt % size_] = kline->kline;
+	series.cnt++;
+	memcpy(&series.quote, &msg->quote, sizeof(series.quote));
+}
+
+void KlineHistory::Get(const std::vector<std::string> &keys, int info2, int n, KlineHistoryResult &result)
+{
+	size_t want = (n <= 0 || (size_t)n > size_) ? size_ : (size_t)n;
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	if (keys.empty()) {
+		for (auto &it : index_) {
+			auto series_it = it.second.find(info2);
+			if (series_it != it.second.end()) {
+				Read(series_it->second, want, result);
+			}
+		}
+		return;
+	}
+
+	for (auto &key : keys) {
+		auto it = index_.find(key);
+		if (it == index_.end()) {
+			result.missing.push_back(key);
+			continue;
+		}
+		auto series_it = it->second.find(info2);
+		if (series_it == it->second.end()) {
+			result.missing.push_back(key);
+			continue;
+		}
+		Read(series_it->second, want, result);
+	}
+}
+
+void KlineHistory::Read(size_t idx, size_t n, KlineHistoryResult &result)
+{
+	const KlineSeries &series = series_[idx];
+	size_t cnt = (size_t)std::min((uint64_t)n, std::min(series.cnt, (uint64_t)size_));
+
+	KlineHistorySeries out;
+	memcpy(&out.quote, &series.quote, sizeof(out.quote));
+	out.offset = result.bars.size();
+	out.cnt = cnt;
+	result.series.push_back(out);
+
+	// oldest wanted bar to the end of the ring, then the wrapped part
+	const Kline *ring = &bars_[idx * size_];
+	size_t first = (size_t)((series.cnt - cnt) % size_);
+	size_t head = std::min(cnt, size_ - first);
+	result.bars.insert(result.bars.end(), ring + first, ring + first + head);
+	result.bars.insert(result.bars.end(), ring, ring + (cnt - head));
+}
+
+
+}
@@ -0,0 +1,75 @@
+#ifndef BABELTRADER_KLINE_HISTORY_H_
+#define BABELTRADER_KLINE_HISTORY_H_
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_struct.h"
+
+namespace babeltrader
+{
+
+#define KLINE_HISTORY_DEFAULT_SIZE 240
+#define KLINE_HISTORY_MAX_SIZE 100000
+
+struct KlineHistorySeries
+{
+	Quote quote;		// instrument of the bars, info2 is the interval
+	size_t offset;		// first bar in KlineHistoryResult::bars
+	size_t cnt;
+};
+
+// bars of every series read, back to back, oldest first in each series
+struct KlineHistoryResult
+{
+	std::vector<KlineHistorySeries> series;
+	std::vector<Kline> bars;
+	std::vector<std::string> missing;
+};
+
+// newest completed bars of every instrument and interval.
+// all bars live in one array, series i owns [i * size, (i + 1) * size) as a ring,
+// so a read copies at most two ranges per series under the lock
+class KlineHistory
+{
+public:
+	// size 0 keeps nothing
+	explicit KlineHistory(int size = KLINE_HISTORY_DEFAULT_SIZE);
+
+	KlineHistory(const KlineHistory&) = delete;
+	KlineHistory& operator=(const KlineHistory&) = delete;
+
+	// only klines are kept, a bar of the same ts as the newest replaces it, older ones are ignored
+	void Update(const QuoteBlockCommon *msg);
+
+	// newest n bars of the interval for instruments of keys (symbol + contract),
+	// n <= 0 means all kept, empty keys means every instrument with the interval
+	void Get(const std::vector<std::string> &keys, int info2, int n, KlineHistoryResult &result);
+
+	int Size() const { return (int)size_; }
+
+private:
+	struct KlineSeries
+	{
+		Quote quote;
+		uint64_t cnt;		// bars ever written, the newest is at (cnt - 1) % size
+	};
+
+	void Read(size_t idx, size_t n, KlineHistoryResult &result);
+
+private:
+	size_t size_;
+	std::mutex mtx_;
+	std::unordered_map<std::string, std::map<int, size_t>> index_;	// instrument -> info2 -> series
+	std::vector<KlineSeries> series_;
+	std::vector<Kline> bars_;
+};
+
+
+}
+
+#endif
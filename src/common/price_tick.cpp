@@ -0,0 +1,139 @@
+#include "price_tick.h"
+
+#include <string.h>
+#include <math.h>
+
+#include "rapidjson/internal/itoa.h"
+
+namespace babeltrader
+{
+
+static const int64_t s_pow10[PRICE_TICK_MAX_DECIMALS + 1] = {
+	1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL
+};
+
+int PriceTickDecimals(double tick)
+{
+	if (!(tick > 0.0) || !isfinite(tick)) {
+		return -1;
+	}
+
+	for (int i = 0; i <= PRICE_TICK_MAX_DECIMALS; i++) {
+		// a tiny tick is close to 0 at every scale, it must reach a whole step
+		double scaled = tick * s_pow10[i];
+		double rounded = floor(scaled + 0.5);
+		if (rounded >= 1.0 && fabs(scaled - rounded) < 1e-6) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+char* WriteTickPrice(char *p, double price, const PriceTick &tick)
+{
+	if (tick.decimals < 0 || !isfinite(price)) {
+		return nullptr;
+	}
+
+	// keep clear of int64 overflow, 9e15 is still exact in a double
+	double scaled = price * tick.scale;
+	if (fabs(scaled) >= 9e15) {
+		return nullptr;
+	}
+	int64_t v = (int64_t)floor(scaled + 0.5);
+
+	if (v < 0) {
+		*p++ = '-';
+		v = -v;
+	}
+	p = rapidjson::internal::u64toa((uint64_t)(v / tick.scale), p);
+	*p++ = '.';
+	if (tick.decimals == 0) {
+		*p++ = '0';
+		return p;
+	}
+
+	int64_t frac = v % tick.scale;
+	for (int i = tick.decimals - 1; i >= 0; i--) {
+		p[i] = (char)('0' + frac % 10);
+		frac /= 10;
+	}
+	return p + tick.decimals;
+}
+
+void SerializePrice(rapidjson::Writer<rapidjson::StringBuffer> &writer, double price, const PriceTick *tick)
+{
+	if (tick) {
+		char buf[32];
+		char *end = WriteTickPrice(buf, price, *tick);
+		if (end) {
+			writer.RawValue(buf, end - buf, rapidjson::kNumberType);
+			return;
+		}
+	}
+	writer.Double(price);
+}
+
+PriceTickTable::PriceTickTable()
+	: version_(0)
+{}
+
+void PriceTickTable::Set(const std::string &symbol, const std::string &contract, double tick)
+{
+	PriceTick price_tick;
+	price_tick.decimals = PriceTickDecimals(tick);
+	if (price_tick.decimals < 0) {
+		return;
+	}
+	price_tick.tick = tick;
+	price_tick.scale = s_pow10[price_tick.decimals];
+
+	std::string key = contract.empty() ? symbol : symbol + "." + contract;
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	auto it = ticks_.find(key);
+	if (it != ticks_.end() && it->second.tick == tick) {
+		return;
+	}
+	ticks_[key] = price_tick;
+	version_.fetch_add(1, std::memory_order_release);
+}
+void PriceTickTable::Load(const std::map<std::string, double> &ticks)
+{
+	for (auto &it : ticks) {
+		auto pos = it.first.find('.');
+		if (pos == std::string::npos) {
+			Set(it.first, "", it.second);
+		} else {
+			Set(it.first.substr(0, pos), it.first.substr(pos + 1), it.second);
+		}
+	}
+}
+
+PriceTick PriceTickTable::Find(const std::string &symbol, const std::string &contract) const
+{
+	// on every order push, nothing to do while no tick is known
+	if (Version() == 0) {
+		return PriceTick();
+	}
+
+	// key buffer keeps its capacity, no allocation after the first lookups
+	static thread_local std::string key;
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	if (!contract.empty()) {
+		key.assign(symbol);
+		key.append(1, '.');
+		key.append(contract);
+		auto it = ticks_.find(key);
+		if (it != ticks_.end()) {
+			return it->second;
+		}
+	}
+
+	auto it = ticks_.find(symbol);
+	return it != ticks_.end() ? it->second : PriceTick();
+}
+
+
+}
@@ -0,0 +1,74 @@
+#ifndef BABELTRADER_PRICE_TICK_H_
+#define BABELTRADER_PRICE_TICK_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+
+namespace babeltrader
+{
+
+#define PRICE_TICK_MAX_DECIMALS 8
+
+struct PriceTick
+{
+	double tick;
+	int decimals;		// digits after the point, -1 means unknown
+	int64_t scale;		// 10^decimals
+
+	PriceTick()
+		: tick(0.0)
+		, decimals(-1)
+		, scale(1)
+	{}
+};
+
+// fewest decimals that represent the tick exactly, -1 if none within PRICE_TICK_MAX_DECIMALS
+int PriceTickDecimals(double tick);
+
+// price scaled to an integer of the tick's decimals, then printed with exactly that many
+// digits after the point (at least one, so it is still a json double).
+// returns nullptr when the price can't be scaled (nan, inf, out of int64 range like
+// the DBL_MAX ctp uses for empty fields), caller formats it as a double instead.
+// needs 32 bytes at p
+char* WriteTickPrice(char *p, double price, const PriceTick &tick);
+
+// writer.Double() unless the tick is known and the price fits
+void SerializePrice(rapidjson::Writer<rapidjson::StringBuffer> &writer, double price, const PriceTick *tick);
+
+// price tick of instruments, keyed by "symbol" for a whole product or "symbol.contract".
+// Find() prefers the contract
+class PriceTickTable
+{
+public:
+	PriceTickTable();
+
+	PriceTickTable(const PriceTickTable&) = delete;
+	PriceTickTable& operator=(const PriceTickTable&) = delete;
+
+	// ignored when tick is not positive
+	void Set(const std::string &symbol, const std::string &contract, double tick);
+	void Load(const std::map<std::string, double> &ticks);
+
+	// decimals is -1 when unknown
+	PriceTick Find(const std::string &symbol, const std::string &contract) const;
+
+	// bumped by every change, lets readers cache lookups
+	uint64_t Version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+	mutable std::mutex mtx_;
+	std::unordered_map<std::string, PriceTick> ticks_;
+	std::atomic<uint64_t> version_;
+};
+
+
+}
+
+#endif
@@ -4,23 +4,23 @@ namespace babeltrader
 {
 
 
-void QueryCache::CacheQryOrder(int req_id, uWS::WebSocket<uWS::SERVER>* ws, OrderQuery &order_qry)
+void QueryCache::CacheQryOrder(int req_id, WsConnHandle conn, OrderQuery &order_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	qry_ws_cache_[req_id] = ws;
+	qry_conn_cache_[req_id] = conn;
 	qry_order_cache_[req_id] = order_qry;
 }
-void QueryCache::GetAndClearCacheQryOrder(int req_id, uWS::WebSocket<uWS::SERVER>** ws, OrderQuery *p_order_qry)
+void QueryCache::GetAndClearCacheQryOrder(int req_id, WsConnHandle *conn, OrderQuery *p_order_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	auto it_ws = qry_ws_cache_.find(req_id);
-	if (it_ws != qry_ws_cache_.end())
+	auto it_conn = qry_conn_cache_.find(req_id);
+	if (it_conn != qry_conn_cache_.end())
 	{
-		if (ws)
+		if (conn)
 		{
-			*ws = it_ws->second;
+			*conn = it_conn->second;
 		}
-		qry_ws_cache_.erase(it_ws);
+		qry_conn_cache_.erase(it_conn);
 	}
 
 	auto it_order_qry = qry_order_cache_.find(req_id);
@@ -34,23 +34,23 @@ void QueryCache::GetAndClearCacheQryOrder(int req_id, uWS::WebSocket<uWS::SERVER
 	}
 }
 
-void QueryCache::CacheQryTrade(int req_id, uWS::WebSocket<uWS::SERVER>* ws, TradeQuery &trade_qry)
+void QueryCache::CacheQryTrade(int req_id, WsConnHandle conn, TradeQuery &trade_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	qry_ws_cache_[req_id] = ws;
+	qry_conn_cache_[req_id] = conn;
 	qry_trade_cache_[req_id] = trade_qry;
 }
-void QueryCache::GetAndClearCacheQryTrade(int req_id, uWS::WebSocket<uWS::SERVER>** ws, TradeQuery *p_trade_qry)
+void QueryCache::GetAndClearCacheQryTrade(int req_id, WsConnHandle *conn, TradeQuery *p_trade_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	auto it_ws = qry_ws_cache_.find(req_id);
-	if (it_ws != qry_ws_cache_.end())
+	auto it_conn = qry_conn_cache_.find(req_id);
+	if (it_conn != qry_conn_cache_.end())
 	{
-		if (ws)
+		if (conn)
 		{
-			*ws = it_ws->second;
+			*conn = it_conn->second;
 		}
-		qry_ws_cache_.erase(it_ws);
+		qry_conn_cache_.erase(it_conn);
 	}
 
 	auto it_trade_qry = qry_trade_cache_.find(req_id);
@@ -64,23 +64,23 @@ void QueryCache::GetAndClearCacheQryTrade(int req_id, uWS::WebSocket<uWS::SERVER
 	}
 }
 
-void QueryCache::CacheQryPosition(int req_id, uWS::WebSocket<uWS::SERVER>* ws, PositionQuery &position_qry)
+void QueryCache::CacheQryPosition(int req_id, WsConnHandle conn, PositionQuery &position_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	qry_ws_cache_[req_id] = ws;
+	qry_conn_cache_[req_id] = conn;
 	qry_position_cache_[req_id] = position_qry;
 }
-void QueryCache::GetAndCleanCacheQryPosition(int req_id, uWS::WebSocket<uWS::SERVER>** ws, PositionQuery *p_position_qry)
+void QueryCache::GetAndCleanCacheQryPosition(int req_id, WsConnHandle *conn, PositionQuery *p_position_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	auto it_ws = qry_ws_cache_.find(req_id);
-	if (it_ws != qry_ws_cache_.end())
+	auto it_conn = qry_conn_cache_.find(req_id);
+	if (it_conn != qry_conn_cache_.end())
 	{
-		if (ws)
+		if (conn)
 		{
-			*ws = it_ws->second;
+			*conn = it_conn->second;
 		}
-		qry_ws_cache_.erase(it_ws);
+		qry_conn_cache_.erase(it_conn);
 	}
 
 	auto it_position_qry = qry_position_cache_.find(req_id);
@@ -94,23 +94,23 @@ void QueryCache::GetAndCleanCacheQryPosition(int req_id, uWS::WebSocket<uWS::SER
 	}
 }
 
-void QueryCache::CacheQryPositionDetail(int req_id, uWS::WebSocket<uWS::SERVER>* ws, PositionQuery &position_qry)
+void QueryCache::CacheQryPositionDetail(int req_id, WsConnHandle conn, PositionQuery &position_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	qry_ws_cache_[req_id] = ws;
+	qry_conn_cache_[req_id] = conn;
 	qry_position_detail_cache_[req_id] = position_qry;
 }
-void QueryCache::GetAndCleanCacheQryPositionDetail(int req_id, uWS::WebSocket<uWS::SERVER>** ws, PositionQuery *p_position_detail_qry)
+void QueryCache::GetAndCleanCacheQryPositionDetail(int req_id, WsConnHandle *conn, PositionQuery *p_position_detail_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	auto it_ws = qry_ws_cache_.find(req_id);
-	if (it_ws != qry_ws_cache_.end())
+	auto it_conn = qry_conn_cache_.find(req_id);
+	if (it_conn != qry_conn_cache_.end())
 	{
-		if (ws)
+		if (conn)
 		{
-			*ws = it_ws->second;
+			*conn = it_conn->second;
 		}
-		qry_ws_cache_.erase(it_ws);
+		qry_conn_cache_.erase(it_conn);
 	}
 
 	auto it_position_detail_qry = qry_position_detail_cache_.find(req_id);
@@ -124,23 +124,23 @@ void QueryCache::GetAndCleanCacheQryPositionDetail(int req_id, uWS::WebSocket<uW
 	}
 }
 
-void QueryCache::CacheQryTradeAccount(int req_id, uWS::WebSocket<uWS::SERVER>* ws, TradeAccountQuery &tradeaccount_qry)
+void QueryCache::CacheQryTradeAccount(int req_id, WsConnHandle conn, TradeAccountQuery &tradeaccount_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	qry_ws_cache_[req_id] = ws;
+	qry_conn_cache_[req_id] = conn;
 	qry_trade_account_cache_[req_id] = tradeaccount_qry;
 }
-void QueryCache::GetAndCleanCacheQryTradeAccount(int req_id, uWS::WebSocket<uWS::SERVER>** ws, TradeAccountQuery *p_tradeaccount_qry)
+void QueryCache::GetAndCleanCacheQryTradeAccount(int req_id, WsConnHandle *conn, TradeAccountQuery *p_tradeaccount_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	auto it_ws = qry_ws_cache_.find(req_id);
-	if (it_ws != qry_ws_cache_.end())
+	auto it_conn = qry_conn_cache_.find(req_id);
+	if (it_conn != qry_conn_cache_.end())
 	{
-		if (ws)
+		if (conn)
 		{
-			*ws = it_ws->second;
+			*conn = it_conn->second;
 		}
-		qry_ws_cache_.erase(it_ws);
+		qry_conn_cache_.erase(it_conn);
 	}
 
 	auto it_trade_account_qry = qry_trade_account_cache_.find(req_id);
@@ -154,23 +154,23 @@ void QueryCache::GetAndCleanCacheQryTradeAccount(int req_id, uWS::WebSocket<uWS:
 	}
 }
 
-void QueryCache::CacheQryProduct(int req_id, uWS::WebSocket<uWS::SERVER>* ws, ProductQuery &product_qry)
+void QueryCache::CacheQryProduct(int req_id, WsConnHandle conn, ProductQuery &product_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	qry_ws_cache_[req_id] = ws;
+	qry_conn_cache_[req_id] = conn;
 	qry_product_cache_[req_id] = product_qry;
 }
-void QueryCache::GetAndCleanCacheQryProduct(int req_id, uWS::WebSocket<uWS::SERVER>** ws, ProductQuery *p_product_qry)
+void QueryCache::GetAndCleanCacheQryProduct(int req_id, WsConnHandle *conn, ProductQuery *p_product_qry)
 {
 	std::unique_lock<std::mutex> lock(qry_cache_mtx_);
-	auto it_ws = qry_ws_cache_.find(req_id);
-	if (it_ws != qry_ws_cache_.end())
+	auto it_conn = qry_conn_cache_.find(req_id);
+	if (it_conn != qry_conn_cache_.end())
 	{
-		if (ws)
+		if (conn)
 		{
-			*ws = it_ws->second;
+			*conn = it_conn->second;
 		}
-		qry_ws_cache_.erase(it_ws);
+		qry_conn_cache_.erase(it_conn);
 	}
 
 	auto it_product_qry = qry_product_cache_.find(req_id);
@@ -0,0 +1,458 @@
+#include "quote_binary.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace babeltrader
+{
+
+
+struct QuoteBinField
+{
+	const char *name;
+	uint8_t type;
+	uint16_t offset;
+};
+
+struct QuoteBinRecordDesc
+{
+	uint8_t type;
+	uint16_t body_len;
+	const QuoteBinField *fields;
+	uint8_t field_cnt;
+};
+
+#define QUOTE_BIN_FIELD(s, f, t) { #f, QuoteBinFieldType_##t, (uint16_t)offsetof(s, f) }
+#define QUOTE_BIN_ARRAY_LEN(a) (uint8_t)(sizeof(a) / sizeof(a[0]))
+
+static const QuoteBinField s_instrument_fields[] = {
+	QUOTE_BIN_FIELD(QuoteBinInstrument, market, U8),
+	QUOTE_BIN_FIELD(QuoteBinInstrument, exchange, U8),
+	QUOTE_BIN_FIELD(QuoteBinInstrument, type, U8),
+	QUOTE_BIN_FIELD(QuoteBinInstrument, symbol, Char16),
+	QUOTE_BIN_FIELD(QuoteBinInstrument, contract, Char16),
+	QUOTE_BIN_FIELD(QuoteBinInstrument, contract_id, Char16),
+};
+static const QuoteBinField s_marketdata_fields[] = {
+	QUOTE_BIN_FIELD(QuoteBinMarketData, ts, I64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, last, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, vol, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, turnover, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, avg_price, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, pre_settlement, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, pre_close, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, pre_open_interest, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, settlement, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, close, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, open_interest, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, upper_limit, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, lower_limit, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, open, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, high, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, low, F64),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, trading_day, U32),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, action_day, U32),
+	QUOTE_BIN_FIELD(QuoteBinMarketData, depth, U8),
+	{ "levels", QuoteBinFieldType_Levels, (uint16_t)sizeof(QuoteBinMarketData) },
+};
+static const QuoteBinField s_kline_fields[] = {
+	QUOTE_BIN_FIELD(QuoteBinKline, ts, I64),
+	QUOTE_BIN_FIELD(QuoteBinKline, open, F64),
+	QUOTE_BIN_FIELD(QuoteBinKline, high, F64),
+	QUOTE_BIN_FIELD(QuoteBinKline, low, F64),
+	QUOTE_BIN_FIELD(QuoteBinKline, close, F64),
+	QUOTE_BIN_FIELD(QuoteBinKline, vol, F64),
+};
+static const QuoteBinField s_orderbook_fields[] = {
+	QUOTE_BIN_FIELD(QuoteBinOrderBook, ts, I64),
+	QUOTE_BIN_FIELD(QuoteBinOrderBook, last, F64),
+	QUOTE_BIN_FIELD(QuoteBinOrderBook, vol, F64),
+	QUOTE_BIN_FIELD(QuoteBinOrderBook, depth, U8),
+	{ "levels", QuoteBinFieldType_Levels, (uint16_t)sizeof(QuoteBinOrderBook) },
+};
+static const QuoteBinField s_level2_fields[] = {
+	QUOTE_BIN_FIELD(QuoteBinLevel2, ts, I64),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, seq, I64),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, action, U8),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, dir, U8),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, order_type, U8),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, trade_flag, U8),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, channel_no, I64),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, action_seq, I64),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, price, F64),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, vol, F64),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, bid_no, I64),
+	QUOTE_BIN_FIELD(QuoteBinLevel2, ask_no, I64),
+};
+static const QuoteBinField s_gap_fields[] = {
+	QUOTE_BIN_FIELD(QuoteBinGap, drop_frames, U64),
+};
+static const QuoteBinField s_seq_fields[] = {
+	QUOTE_BIN_FIELD(QuoteBinSeq, seq, U64),
+};
+
+static const QuoteBinField s_marketdata_delta_fields[] = {
+	QUOTE_BIN_FIELD(QuoteBinMarketDataDelta, seq, U64),
+	QUOTE_BIN_FIELD(QuoteBinMarketDataDelta, flags, U8),
+	QUOTE_BIN_FIELD(QuoteBinMarketDataDelta, depth, U8),
+	QUOTE_BIN_FIELD(QuoteBinMarketDataDelta, bid_mask, U16),
+	QUOTE_BIN_FIELD(QuoteBinMarketDataDelta, ask_mask, U16),
+	QUOTE_BIN_FIELD(QuoteBinMarketDataDelta, field_mask, U32),
+	{ "values", QuoteBinFieldType_Masked, (uint16_t)sizeof(QuoteBinMarketDataDelta) },
+};
+
+static const QuoteBinRecordDesc s_record_descs[] = {
+	{ QuoteBinRecordType_Instrument, sizeof(QuoteBinInstrument), s_instrument_fields, QUOTE_BIN_ARRAY_LEN(s_instrument_fields) },
+	{ QuoteBinRecordType_MarketData, sizeof(QuoteBinMarketData), s_marketdata_fields, QUOTE_BIN_ARRAY_LEN(s_marketdata_fields) },
+	{ QuoteBinRecordType_Kline, sizeof(QuoteBinKline), s_kline_fields, QUOTE_BIN_ARRAY_LEN(s_kline_fields) },
+	{ QuoteBinRecordType_OrderBook, sizeof(QuoteBinOrderBook), s_orderbook_fields, QUOTE_BIN_ARRAY_LEN(s_orderbook_fields) },
+	{ QuoteBinRecordType_Level2, sizeof(QuoteBinLevel2), s_level2_fields, QUOTE_BIN_ARRAY_LEN(s_level2_fields) },
+	{ QuoteBinRecordType_Gap, sizeof(QuoteBinGap), s_gap_fields, QUOTE_BIN_ARRAY_LEN(s_gap_fields) },
+	{ QuoteBinRecordType_MarketDataDelta, sizeof(QuoteBinMarketDataDelta), s_marketdata_delta_fields, QUOTE_BIN_ARRAY_LEN(s_marketdata_delta_fields) },
+	{ QuoteBinRecordType_Seq, sizeof(QuoteBinSeq), s_seq_fields, QUOTE_BIN_ARRAY_LEN(s_seq_fields) },
+};
+
+static void AppendFrameHead(std::string &frame, uint8_t frame_type)
+{
+	QuoteBinFrameHead head;
+	head.magic = QUOTE_BIN_MAGIC;
+	head.version = QUOTE_BIN_VERSION;
+	head.frame_type = frame_type;
+	head.count = 0;
+	frame.append((const char*)&head, sizeof(head));
+}
+
+static void AppendRecord(std::string &rec, uint8_t type, uint8_t info2, uint32_t instrument_id, const void *body, size_t body_len, const QuoteBinLevel *levels, int level_cnt)
+{
+	QuoteBinRecordHead head;
+	head.type = type;
+	head.info2 = info2;
+	head.len = (uint16_t)(sizeof(head) + body_len + sizeof(QuoteBinLevel) * level_cnt);
+	head.instrument_id = instrument_id;
+
+	rec.append((const char*)&head, sizeof(head));
+	rec.append((const char*)body, body_len);
+	if (level_cnt > 0) {
+		rec.append((const char*)levels, sizeof(QuoteBinLevel) * level_cnt);
+	}
+}
+
+static int FillLevels(const PriceVol *bids, const PriceVol *asks, int len, QuoteBinLevel *levels)
+{
+	if (len < 0) {
+		len = 0;
+	}
+	if (len > BIDASK_MAX_LEN) {
+		len = BIDASK_MAX_LEN;
+	}
+
+	for (int i = 0; i < len; i++) {
+		levels[i].bid_price = bids[i].price;
+		levels[i].bid_vol = bids[i].vol;
+		levels[i].ask_price = asks[i].price;
+		levels[i].ask_vol = asks[i].vol;
+	}
+	return len;
+}
+
+QuoteInstrumentTable::QuoteInstrumentTable()
+	: next_id_(1)
+{}
+
+uint32_t QuoteInstrumentTable::GetId(const Quote &quote)
+{
+	std::string key;
+	key.reserve(64);
+	key.append(1, (char)quote.market);
+	key.append(1, (char)quote.exchange);
+	key.append(1, (char)quote.type);
+	key.append(quote.symbol, strnlen(quote.symbol, sizeof(quote.symbol)));
+	key.append(1, '\0');
+	key.append(quote.contract, strnlen(quote.contract, sizeof(quote.contract)));
+	key.append(1, '\0');
+	key.append(quote.contract_id, strnlen(quote.contract_id, sizeof(quote.contract_id)));
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	auto it = ids_.find(key);
+	if (it != ids_.end()) {
+		return it->second;
+	}
+
+	uint32_t id = next_id_++;
+	ids_[key] = id;
+
+	QuoteBinInstrument instrument;
+	memset(&instrument, 0, sizeof(instrument));
+	instrument.market = quote.market;
+	instrument.exchange = quote.exchange;
+	instrument.type = quote.type;
+	strncpy(instrument.symbol, quote.symbol, sizeof(instrument.symbol));
+	strncpy(instrument.contract, quote.contract, sizeof(instrument.contract));
+	strncpy(instrument.contract_id, quote.contract_id, sizeof(instrument.contract_id));
+
+	AppendRecord(records_, QuoteBinRecordType_Instrument, 0, id, &instrument, sizeof(instrument), nullptr, 0);
+
+	return id;
+}
+
+void QuoteInstrumentTable::Snapshot(std::string &frame, uint32_t &max_id)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	frame.clear();
+	QuoteBinAppend(frame, records_.data(), records_.size());
+	max_id = next_id_ - 1;
+}
+
+void QuoteInstrumentTable::Append(uint32_t from_id, uint32_t to_id, std::string &frame)
+{
+	const size_t rec_len = sizeof(QuoteBinRecordHead) + sizeof(QuoteBinInstrument);
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	if (to_id > next_id_ - 1) {
+		to_id = next_id_ - 1;
+	}
+	if (from_id >= to_id) {
+		return;
+	}
+	QuoteBinAppend(frame, records_.data() + from_id * rec_len, (to_id - from_id) * rec_len);
+}
+
+void QuoteBinSerialize(QuoteInstrumentTable &table, const QuoteBlockCommon *msg, std::string &rec, uint64_t seq)
+{
+	rec.clear();
+	uint32_t id = table.GetId(msg->quote);
+	QuoteBinLevel levels[BIDASK_MAX_LEN];
+
+	if (seq > 0) {
+		QuoteBinSeq body;
+		body.seq = seq;
+		AppendRecord(rec, QuoteBinRecordType_Seq, msg->quote.info2, id, &body, sizeof(body), nullptr, 0);
+	}
+
+	switch (msg->quote_type)
+	{
+		case QuoteBlockType_MarketData:
+		{
+			const MarketData &md = ((const QuoteMarketData*)msg)->market_data;
+			QuoteBinMarketData body;
+			memset(&body, 0, sizeof(body));
+			body.ts = md.ts;
+			body.last = md.last;
+			body.vol = md.vol;
+			body.turnover = md.turnover;
+			body.avg_price = md.avg_price;
+			body.pre_settlement = md.pre_settlement;
+			body.pre_close = md.pre_close;
+			body.pre_open_interest = md.pre_open_interest;
+			body.settlement = md.settlement;
+			body.close = md.close;
+			body.open_interest = md.open_interest;
+			body.upper_limit = md.upper_limit;
+			body.lower_limit = md.lower_limit;
+			body.open = md.open;
+			body.high = md.high;
+			body.low = md.low;
+			body.trading_day = (uint32_t)strtoul(md.trading_day, nullptr, 10);
+			body.action_day = (uint32_t)strtoul(md.action_day, nullptr, 10);
+			int depth = FillLevels(md.bids, md.asks, md.bid_ask_len, levels);
+			body.depth = (uint8_t)depth;
+			AppendRecord(rec, QuoteBinRecordType_MarketData, msg->quote.info2, id, &body, sizeof(body), levels, depth);
+		}break;
+		case QuoteBlockType_Kline:
+		{
+			const Kline &kline = ((const QuoteKline*)msg)->kline;
+			QuoteBinKline body;
+			body.ts = kline.ts;
+			body.open = kline.open;
+			body.high = kline.high;
+			body.low = kline.low;
+			body.close = kline.close;
+			body.vol = kline.vol;
+			AppendRecord(rec, QuoteBinRecordType_Kline, msg->quote.info2, id, &body, sizeof(body), nullptr, 0);
+		}break;
+		case QuoteBlockType_OrderBook:
+		{
+			const OrderBook &order_book = ((const QuoteOrderBook*)msg)->order_book;
+			QuoteBinOrderBook body;
+			memset(&body, 0, sizeof(body));
+			body.ts = order_book.ts;
+			body.last = order_book.last;
+			body.vol = order_book.vol;
+			int depth = FillLevels(order_book.bids, order_book.asks, order_book.bid_ask_len, levels);
+			body.depth = (uint8_t)depth;
+			AppendRecord(rec, QuoteBinRecordType_OrderBook, msg->quote.info2, id, &body, sizeof(body), levels, depth);
+		}break;
+		case QuoteBlockType_Level2:
+		{
+			const OrderBookLevel2 &level2 = ((const QuoteOrderBookLevel2*)msg)->level2;
+			QuoteBinLevel2 body;
+			memset(&body, 0, sizeof(body));
+			body.ts = level2.ts;
+			body.seq = level2.seq;
+			body.action = (uint8_t)level2.action;
+			if (level2.action == OrderBookL2Action_Entrust) {
+				body.dir = (uint8_t)level2.entrust.dir;
+				body.order_type = (uint8_t)level2.entrust.order_type;
+				body.channel_no = level2.entrust.channel_no;
+				body.action_seq = level2.entrust.seq;
+				body.price = level2.entrust.price;
+				body.vol = level2.entrust.vol;
+			}
+			else if (level2.action == OrderBookL2Action_Trade) {
+				body.trade_flag = (uint8_t)level2.trade.trade_flag;
+				body.channel_no = level2.trade.channel_no;
+				body.action_seq = level2.trade.seq;
+				body.price = level2.trade.price;
+				body.vol = level2.trade.vol;
+				body.bid_no = level2.trade.bid_no;
+				body.ask_no = level2.trade.ask_no;
+			}
+			AppendRecord(rec, QuoteBinRecordType_Level2, msg->quote.info2, id, &body, sizeof(body), nullptr, 0);
+		}break;
+	}
+}
+void QuoteBinSerializeGap(uint64_t drop_frames, std::string &rec)
+{
+	QuoteBinGap body;
+	body.drop_frames = drop_frames;
+
+	rec.clear();
+	AppendRecord(rec, QuoteBinRecordType_Gap, 0, 0, &body, sizeof(body), nullptr, 0);
+}
+
+void QuoteBinSerializeDelta(QuoteInstrumentTable &table, const QuoteMarketData &msg, const QuoteDelta &delta, std::string &rec)
+{
+	rec.clear();
+	uint32_t id = table.GetId(msg.quote);
+	const MarketData &md = msg.market_data;
+
+	QuoteBinMarketDataDelta body;
+	memset(&body, 0, sizeof(body));
+	body.seq = delta.seq;
+	body.flags = delta.snapshot ? QUOTE_BIN_DELTA_FLAG_SNAPSHOT : 0;
+	body.depth = (uint8_t)delta.depth;
+	body.bid_mask = delta.bid_mask;
+	body.ask_mask = delta.ask_mask;
+	body.field_mask = delta.field_mask;
+
+	// fixed 8 bytes per field and 16 bytes per level keep decoding branch free
+	char values[QUOTE_DELTA_FIELD_CNT * 8 + BIDASK_MAX_LEN * 2 * sizeof(PriceVol)];
+	char *p = values;
+	if (delta.field_mask & (1 << QUOTE_DELTA_FIELD_TS)) {
+		memcpy(p, &md.ts, 8);
+		p += 8;
+	}
+	for (int i = 0; i < QUOTE_DELTA_DOUBLE_CNT; i++) {
+		if (delta.field_mask & (1 << (i + 1))) {
+			memcpy(p, &(md.*(g_quote_delta_doubles[i].field)), 8);
+			p += 8;
+		}
+	}
+	if (delta.field_mask & (1 << QUOTE_DELTA_FIELD_TRADING_DAY)) {
+		int64_t day = strtoll(md.trading_day, nullptr, 10);
+		memcpy(p, &day, 8);
+		p += 8;
+	}
+	if (delta.field_mask & (1 << QUOTE_DELTA_FIELD_ACTION_DAY)) {
+		int64_t day = strtoll(md.action_day, nullptr, 10);
+		memcpy(p, &day, 8);
+		p += 8;
+	}
+	for (int i = 0; i < delta.depth; i++) {
+		if (delta.bid_mask & (1 << i)) {
+			memcpy(p, &md.bids[i].price, 8);
+			memcpy(p + 8, &md.bids[i].vol, 8);
+			p += 16;
+		}
+	}
+	for (int i = 0; i < delta.depth; i++) {
+		if (delta.ask_mask & (1 << i)) {
+			memcpy(p, &md.asks[i].price, 8);
+			memcpy(p + 8, &md.asks[i].vol, 8);
+			p += 16;
+		}
+	}
+
+	QuoteBinRecordHead head;
+	head.type = QuoteBinRecordType_MarketDataDelta;
+	head.info2 = msg.quote.info2;
+	head.len = (uint16_t)(sizeof(head) + sizeof(body) + (p - values));
+	head.instrument_id = id;
+
+	rec.append((const char*)&head, sizeof(head));
+	rec.append((const char*)&body, sizeof(body));
+	rec.append(values, p - values);
+}
+
+void QuoteBinAppend(std::string &frame, const char *rec, size_t len)
+{
+	if (frame.empty()) {
+		AppendFrameHead(frame, QuoteBinFrameType_Quote);
+	}
+
+	// rec may hold more than one record, count each of them
+	uint32_t cnt = 0;
+	size_t pos = 0;
+	while (pos + sizeof(QuoteBinRecordHead) <= len) {
+		const QuoteBinRecordHead *head = (const QuoteBinRecordHead*)(rec + pos);
+		if (head->len < sizeof(QuoteBinRecordHead)) {
+			break;
+		}
+		pos += head->len;
+		cnt++;
+	}
+
+	frame.append(rec, len);
+	((QuoteBinFrameHead*)&frame[0])->count += cnt;
+}
+
+uint32_t QuoteBinMaxInstrumentId(const char *frame, size_t len)
+{
+	if (len < sizeof(QuoteBinFrameHead) || ((const QuoteBinFrameHead*)frame)->frame_type != QuoteBinFrameType_Quote) {
+		return 0;
+	}
+
+	uint32_t max_id = 0;
+	size_t pos = sizeof(QuoteBinFrameHead);
+	while (pos + sizeof(QuoteBinRecordHead) <= len) {
+		QuoteBinRecordHead head;
+		memcpy(&head, frame + pos, sizeof(head));
+		if (head.len < sizeof(QuoteBinRecordHead)) {
+			break;
+		}
+		if (head.instrument_id > max_id) {
+			max_id = head.instrument_id;
+		}
+		pos += head.len;
+	}
+	return max_id;
+}
+
+const std::string& QuoteBinSchema()
+{
+	static std::string schema;
+	static std::once_flag flag;
+	std::call_once(flag, [] {
+		AppendFrameHead(schema, QuoteBinFrameType_Schema);
+		for (const auto &desc : s_record_descs) {
+			schema.append(1, (char)desc.type);
+			schema.append(1, (char)desc.field_cnt);
+			schema.append((const char*)&desc.body_len, sizeof(desc.body_len));
+			for (uint8_t i = 0; i < desc.field_cnt; i++) {
+				const QuoteBinField &field = desc.fields[i];
+				uint8_t name_len = (uint8_t)strlen(field.name);
+				schema.append(1, (char)field.type);
+				schema.append(1, (char)name_len);
+				schema.append((const char*)&field.offset, sizeof(field.offset));
+				schema.append(field.name, name_len);
+			}
+		}
+		((QuoteBinFrameHead*)&schema[0])->count = QUOTE_BIN_ARRAY_LEN(s_record_descs);
+	});
+
+	return schema;
+}
+
+
+}
@@ -0,0 +1,225 @@
+#ifndef BABELTRADER_QUOTE_BINARY_H_
+#define BABELTRADER_QUOTE_BINARY_H_
+
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <mutex>
+
+#include "common/common_struct.h"
+#include "common/quote_delta.h"
+
+namespace babeltrader
+{
+
+// binary quote protocol, served on /ws/bin
+//
+// every websocket binary message is one frame: frame head + records.
+// all integers and doubles are little endian, structs are packed.
+// the first frame of a connection is the schema (frame_type 0), then the
+// instrument table, then quote frames. quote records only carry the id of an
+// instrument, its instrument record reaches a connection before the first of them
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "binary quote protocol only support little endian host"
+#endif
+
+#define QUOTE_BIN_MAGIC 0x5142		// "BQ"
+#define QUOTE_BIN_VERSION 1
+
+enum QuoteBinFrameTypeEnum
+{
+	QuoteBinFrameType_Schema = 0,
+	QuoteBinFrameType_Quote,
+};
+
+enum QuoteBinRecordTypeEnum
+{
+	QuoteBinRecordType_Unknown = 0,
+	QuoteBinRecordType_Instrument,
+	QuoteBinRecordType_MarketData,
+	QuoteBinRecordType_Kline,
+	QuoteBinRecordType_OrderBook,
+	QuoteBinRecordType_Level2,
+	QuoteBinRecordType_Gap,
+	QuoteBinRecordType_MarketDataDelta,
+	QuoteBinRecordType_Seq,
+	QuoteBinRecordType_Max,
+};
+
+enum QuoteBinFieldTypeEnum
+{
+	QuoteBinFieldType_Unknown = 0,
+	QuoteBinFieldType_U8,
+	QuoteBinFieldType_U32,
+	QuoteBinFieldType_I64,
+	QuoteBinFieldType_U64,
+	QuoteBinFieldType_F64,
+	QuoteBinFieldType_Char16,
+	QuoteBinFieldType_Levels,	// depth records follow the fixed part, count in field "depth"
+	QuoteBinFieldType_Masked,	// 8 bytes per set bit of field_mask, then 16 bytes per set bit of bid_mask and ask_mask
+	QuoteBinFieldType_U16,
+};
+
+#pragma pack(push, 1)
+
+struct QuoteBinFrameHead
+{
+	uint16_t magic;
+	uint8_t version;
+	uint8_t frame_type;		// QuoteBinFrameTypeEnum
+	uint32_t count;			// records in frame
+};
+
+struct QuoteBinRecordHead
+{
+	uint8_t type;			// QuoteBinRecordTypeEnum
+	uint8_t info2;			// QuoteInfo2Enum
+	uint16_t len;			// bytes of record, include this head
+	uint32_t instrument_id;
+};
+
+struct QuoteBinInstrument
+{
+	uint8_t market;
+	uint8_t exchange;
+	uint8_t type;
+	uint8_t reserved;
+	char symbol[QUOTE_SYMBOL_LEN];
+	char contract[QUOTE_CONTRACT_LEN];
+	char contract_id[QUOTE_CONTRACT_LEN];
+};
+
+struct QuoteBinLevel
+{
+	double bid_price;
+	int64_t bid_vol;
+	double ask_price;
+	int64_t ask_vol;
+};
+
+struct QuoteBinMarketData
+{
+	int64_t ts;
+	double last;
+	double vol;
+	double turnover;
+	double avg_price;
+	double pre_settlement;
+	double pre_close;
+	double pre_open_interest;
+	double settlement;
+	double close;
+	double open_interest;
+	double upper_limit;
+	double lower_limit;
+	double open;
+	double high;
+	double low;
+	uint32_t trading_day;	// yyyymmdd
+	uint32_t action_day;	// yyyymmdd
+	uint8_t depth;
+	uint8_t reserved[7];
+};
+
+struct QuoteBinKline
+{
+	int64_t ts;
+	double open;
+	double high;
+	double low;
+	double close;
+	double vol;
+};
+
+struct QuoteBinOrderBook
+{
+	int64_t ts;
+	double last;
+	double vol;
+	uint8_t depth;
+	uint8_t reserved[7];
+};
+
+struct QuoteBinLevel2
+{
+	int64_t ts;
+	int64_t seq;
+	uint8_t action;			// OrderBookL2Action
+	uint8_t dir;			// entrust only
+	uint8_t order_type;		// entrust only
+	uint8_t trade_flag;		// trade only
+	uint32_t reserved;
+	int64_t channel_no;
+	int64_t action_seq;
+	double price;
+	double vol;
+	int64_t bid_no;			// trade only
+	int64_t ask_no;			// trade only
+};
+
+struct QuoteBinGap
+{
+	uint64_t drop_frames;
+};
+
+// topic seq of the quote record right after it, same info2 and instrument
+struct QuoteBinSeq
+{
+	uint64_t seq;
+};
+
+#define QUOTE_BIN_DELTA_FLAG_SNAPSHOT 0x01
+
+struct QuoteBinMarketDataDelta
+{
+	uint64_t seq;
+	uint8_t flags;
+	uint8_t depth;
+	uint16_t bid_mask;
+	uint16_t ask_mask;
+	uint16_t reserved;
+	uint32_t field_mask;	// see quote_delta.h
+};
+
+#pragma pack(pop)
+
+// instrument ids are assigned by gateway process and never reused
+class QuoteInstrumentTable
+{
+public:
+	QuoteInstrumentTable();
+
+	// return id of instrument, a new one gets the next id
+	uint32_t GetId(const Quote &quote);
+
+	// a quote frame with all instrument records, max_id is the last of them
+	void Snapshot(std::string &frame, uint32_t &max_id);
+
+	// append instrument records of ids in (from_id, to_id] to a quote frame
+	void Append(uint32_t from_id, uint32_t to_id, std::string &frame);
+
+private:
+	std::mutex mtx_;
+	uint32_t next_id_;
+	std::map<std::string, uint32_t> ids_;
+	std::string records_;	// instrument records in id order, all of the same size
+};
+
+// build record(s) of a quote, the seq record goes first when seq is not 0
+void QuoteBinSerialize(QuoteInstrumentTable &table, const QuoteBlockCommon *msg, std::string &rec, uint64_t seq = 0);
+void QuoteBinSerializeGap(uint64_t drop_frames, std::string &rec);
+void QuoteBinSerializeDelta(QuoteInstrumentTable &table, const QuoteMarketData &msg, const QuoteDelta &delta, std::string &rec);
+
+// append records to a quote frame, start the frame if it's empty
+void QuoteBinAppend(std::string &frame, const char *rec, size_t len);
+
+// largest instrument id in records of a quote frame, 0 for other frames
+uint32_t QuoteBinMaxInstrumentId(const char *frame, size_t len);
+
+const std::string& QuoteBinSchema();
+
+
+}
+
+#endif
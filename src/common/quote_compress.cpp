@@ -0,0 +1,64 @@
+#include "quote_compress.h"
+
+#include <string.h>
+
+namespace babeltrader
+{
+
+
+QuoteDeflate::QuoteDeflate(int level)
+	: ok_(false)
+{
+	memset(&stream_, 0, sizeof(stream_));
+
+	// raw deflate, same as permessage-deflate
+	ok_ = deflateInit2(&stream_, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+QuoteDeflate::~QuoteDeflate()
+{
+	if (ok_) {
+		deflateEnd(&stream_);
+	}
+}
+
+bool QuoteDeflate::Compress(const char *data, size_t len, std::string &out)
+{
+	if (!ok_) {
+		return false;
+	}
+
+	QuoteCompressHead head;
+	head.magic = QUOTE_COMPRESS_MAGIC;
+	head.version = QUOTE_COMPRESS_VERSION;
+	head.reserved = 0;
+	head.raw_len = (uint32_t)len;
+
+	size_t pos = out.size();
+	out.append((const char*)&head, sizeof(head));
+
+	stream_.next_in = (Bytef*)data;
+	stream_.avail_in = (uInt)len;
+
+	// sync flush may need more than the bound when output is full, loop until all is out
+	do {
+		size_t offset = out.size();
+		size_t chunk = deflateBound(&stream_, stream_.avail_in) + 16;
+		out.resize(offset + chunk);
+
+		stream_.next_out = (Bytef*)&out[offset];
+		stream_.avail_out = (uInt)chunk;
+		int ret = deflate(&stream_, Z_SYNC_FLUSH);
+		out.resize(offset + chunk - stream_.avail_out);
+
+		if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			out.resize(pos);
+			ok_ = false;
+			return false;
+		}
+	} while (stream_.avail_in > 0 || stream_.avail_out == 0);
+
+	return true;
+}
+
+
+}
@@ -0,0 +1,54 @@
+#ifndef BABELTRADER_QUOTE_COMPRESS_H_
+#define BABELTRADER_QUOTE_COMPRESS_H_
+
+#include <stdint.h>
+#include <string>
+
+#include "zlib.h"
+
+namespace babeltrader
+{
+
+// compressed quote frame, a websocket binary message:
+// head + raw deflate data ending with a sync flush. the deflate stream of a
+// connection keeps its window across frames, so client must inflate every
+// compressed frame in order with one stream
+
+#define QUOTE_COMPRESS_MAGIC 0x5a51		// "QZ"
+#define QUOTE_COMPRESS_VERSION 1
+#define QUOTE_COMPRESS_DEFAULT_THRESHOLD 1024
+#define QUOTE_COMPRESS_DEFAULT_LEVEL 1
+
+#pragma pack(push, 1)
+
+struct QuoteCompressHead
+{
+	uint16_t magic;
+	uint8_t version;
+	uint8_t reserved;
+	uint32_t raw_len;		// bytes after inflate
+};
+
+#pragma pack(pop)
+
+class QuoteDeflate
+{
+public:
+	QuoteDeflate(int level);
+	~QuoteDeflate();
+
+	QuoteDeflate(const QuoteDeflate&) = delete;
+	QuoteDeflate& operator=(const QuoteDeflate&) = delete;
+
+	// append a compressed frame to out, false if the stream is broken
+	bool Compress(const char *data, size_t len, std::string &out);
+
+private:
+	z_stream stream_;
+	bool ok_;
+};
+
+
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include "quote_conf.h"
+
+#include <string.h>
+#include <stdexcept>
+
+#include "price_tick.h"
+
+namespace babeltrader
+{
+
+
+static void LoadQuoteBatchPolicy(rapidjson::Value &doc, QuoteBatchPolicy &policy)
+{
+	if (doc.HasMember("max_msgs") && doc["max_msgs"].IsInt())
+	{
+		policy.max_msgs = doc["max_msgs"].GetInt();
+	}
+
+	if (doc.HasMember("max_bytes") && doc["max_bytes"].IsInt64())
+	{
+		policy.max_bytes = doc["max_bytes"].GetInt64();
+	}
+
+	if (doc.HasMember("max_delay_us") && doc["max_delay_us"].IsInt64())
+	{
+		policy.max_delay_us = doc["max_delay_us"].GetInt64();
+	}
+
+	if (doc.HasMember("immediate") && doc["immediate"].IsBool())
+	{
+		policy.immediate = doc["immediate"].GetBool();
+	}
+}
+
+void LoadQuoteServiceConf(rapidjson::Value &doc, QuoteServiceConf &conf)
+{
+	if (doc.HasMember("quote_workers") && doc["quote_workers"].IsInt())
+	{
+		conf.workers = doc["quote_workers"].GetInt();
+		if (conf.workers < 1)
+		{
+			throw(std::runtime_error("invalid 'quote_workers' in config file, need positive int"));
+		}
+	}
+
+	if (doc.HasMember("quote_ws_hubs") && doc["quote_ws_hubs"].IsInt())
+	{
+		conf.ws_hubs = doc["quote_ws_hubs"].GetInt();
+		if (conf.ws_hubs < 1 || conf.ws_hubs > 16)
+		{
+			throw(std::runtime_error("invalid 'quote_ws_hubs' in config file, need 1 ~ 16"));
+		}
+	}
+
+	if (doc.HasMember("quote_ring_size") && doc["quote_ring_size"].IsUint64())
+	{
+		conf.ring_size = doc["quote_ring_size"].GetUint64();
+		if (conf.ring_size < QUOTE_RING_MIN_SIZE)
+		{
+			throw(std::runtime_error("invalid 'quote_ring_size' in config file, need at least 65536"));
+		}
+	}
+
+	if (doc.HasMember("quote_ring_overflow") && doc["quote_ring_overflow"].IsString())
+	{
+		const char *overflow = doc["quote_ring_overflow"].GetString();
+		if (strcmp(overflow, "block") == 0)
+		{
+			conf.ring_overflow = QuoteRingOverflow_Block;
+		}
+		else if (strcmp(overflow, "drop") == 0)
+		{
+			conf.ring_overflow = QuoteRingOverflow_Drop;
+		}
+		else
+		{
+			throw(std::runtime_error("invalid 'quote_ring_overflow' in config file, need 'drop' or 'block'"));
+		}
+	}
+
+	if (doc.HasMember("quote_slow_frames") && doc["quote_slow_frames"].IsInt64())
+	{
+		conf.slow_frames = doc["quote_slow_frames"].GetInt64();
+	}
+
+	if (doc.HasMember("quote_slow_bytes") && doc["quote_slow_bytes"].IsInt64())
+	{
+		conf.slow_bytes = doc["quote_slow_bytes"].GetInt64();
+	}
+
+	if (doc.HasMember("quote_slow_action") && doc["quote_slow_action"].IsString())
+	{
+		const char *action = doc["quote_slow_action"].GetString();
+		if (strcmp(action, "conflate") == 0)
+		{
+			conf.slow_action = QuoteSlowAction_Conflate;
+		}
+		else if (strcmp(action, "drop") == 0)
+		{
+			conf.slow_action = QuoteSlowAction_Drop;
+		}
+		else if (strcmp(action, "disconnect") == 0)
+		{
+			conf.slow_action = QuoteSlowAction_Disconnect;
+		}
+		else
+		{
+			throw(std::runtime_error("invalid 'quote_slow_action' in config file, need 'conflate', 'drop' or 'disconnect'"));
+		}
+	}
+
+	if (doc.HasMember("quote_delta_snapshot_interval") && doc["quote_delta_snapshot_interval"].IsInt())
+	{
+		conf.delta_snapshot_interval = doc["quote_delta_snapshot_interval"].GetInt();
+	}
+
+	if (doc.HasMember("quote_replay_size") && doc["quote_replay_size"].IsInt())
+	{
+		conf.replay_size = doc["quote_replay_size"].GetInt();
+		if (conf.replay_size < 1 || conf.replay_size > QUOTE_REPLAY_MAX_SIZE)
+		{
+			throw(std::runtime_error("invalid 'quote_replay_size' in config file, need 1 ~ 65536"));
+		}
+	}
+
+	if (doc.HasMember("quote_kline_history_size") && doc["quote_kline_history_size"].IsInt())
+	{
+		conf.kline_history_size = doc["quote_kline_history_size"].GetInt();
+		if (conf.kline_history_size < 0 || conf.kline_history_size > KLINE_HISTORY_MAX_SIZE)
+		{
+			throw(std::runtime_error("invalid 'quote_kline_history_size' in config file, need 0 ~ 100000"));
+		}
+	}
+
+	if (doc.HasMember("quote_compress_threshold") && doc["quote_compress_threshold"].IsInt64())
+	{
+		conf.compress_threshold = doc["quote_compress_threshold"].GetInt64();
+	}
+
+	if (doc.HasMember("quote_compress_level") && doc["quote_compress_level"].IsInt())
+	{
+		conf.compress_level = doc["quote_compress_level"].GetInt();
+		if (conf.compress_level < 1 || conf.compress_level > 9)
+		{
+			throw(std::runtime_error("invalid 'quote_compress_level' in config file, need 1 ~ 9"));
+		}
+	}
+
+	if (doc.HasMember("quote_batch") && doc["quote_batch"].IsObject())
+	{
+		LoadQuoteBatchPolicy(doc["quote_batch"], conf.batch);
+	}
+
+	if (doc.HasMember("quote_batch_profiles") && doc["quote_batch_profiles"].IsObject())
+	{
+		for (auto it = doc["quote_batch_profiles"].MemberBegin(); it != doc["quote_batch_profiles"].MemberEnd(); ++it)
+		{
+			if (!it->value.IsObject())
+			{
+				throw(std::runtime_error("invalid 'quote_batch_profiles' in config file, profile need object"));
+			}
+			if (strcmp(it->name.GetString(), QUOTE_BATCH_DEFAULT_NAME) == 0)
+			{
+				throw(std::runtime_error("invalid 'quote_batch_profiles' in config file, 'default' is reserved for 'quote_batch'"));
+			}
+
+			QuoteBatchPolicy policy;
+			policy.name = it->name.GetString();
+			LoadQuoteBatchPolicy(it->value, policy);
+			conf.batch_profiles.push_back(policy);
+		}
+	}
+
+	if (doc.HasMember("quote_price_ticks") && doc["quote_price_ticks"].IsObject())
+	{
+		for (auto it = doc["quote_price_ticks"].MemberBegin(); it != doc["quote_price_ticks"].MemberEnd(); ++it)
+		{
+			if (!it->value.IsNumber() || PriceTickDecimals(it->value.GetDouble()) < 0)
+			{
+				throw(std::runtime_error(std::string("invalid 'quote_price_ticks' in config file, bad tick of ") + it->name.GetString()));
+			}
+			conf.price_ticks[it->name.GetString()] = it->value.GetDouble();
+		}
+	}
+}
+
+
+}
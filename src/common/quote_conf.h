@@ -0,0 +1,105 @@
+#ifndef BABELTRADER_QUOTE_CONF_H_
+#define BABELTRADER_QUOTE_CONF_H_
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "rapidjson/document.h"
+
+#include "common/quote_ring.h"
+#include "common/quote_delta.h"
+#include "common/quote_compress.h"
+#include "common/quote_replay.h"
+#include "common/kline_history.h"
+
+namespace babeltrader
+{
+
+
+enum QuoteSlowActionEnum
+{
+	QuoteSlowAction_Conflate = 0,	// keep newest update per topic, flush when client catches up
+	QuoteSlowAction_Drop,			// drop frames, send a gap notice when client catches up
+	QuoteSlowAction_Disconnect,		// close the connection
+	QuoteSlowAction_Max,
+};
+
+#define QUOTE_BATCH_DEFAULT_NAME "default"
+#define QUOTE_BATCH_DEFAULT_MAX_MSGS 1024
+#define QUOTE_BATCH_DEFAULT_MAX_BYTES (1024 * 1024)
+
+// how the async loop cuts quotes into frames
+struct QuoteBatchPolicy
+{
+	std::string name;
+	int max_msgs;			// records per frame, 0 means no limit
+	int64_t max_bytes;		// bytes per frame, 0 means no limit
+	int64_t max_delay_us;	// longest wait of the first record for more, 0 means send whatever is read
+	bool immediate;			// every record goes out as its own frame
+
+	QuoteBatchPolicy()
+		: name(QUOTE_BATCH_DEFAULT_NAME)
+		, max_msgs(QUOTE_BATCH_DEFAULT_MAX_MSGS)
+		, max_bytes(QUOTE_BATCH_DEFAULT_MAX_BYTES)
+		, max_delay_us(0)
+		, immediate(false)
+	{}
+};
+
+// quote service options shared by all quote gateways
+struct QuoteServiceConf
+{
+	int workers;			// fan-out threads, instruments are hashed across them
+	int ws_hubs;			// uWS hubs listening on quote port, one loop thread each
+	uint64_t ring_size;		// bytes of hand-off ring of each worker
+	int ring_overflow;		// QuoteRingOverflowEnum
+
+	// a client is slow when unsent frames or bytes reach the threshold, 0 means no check
+	int64_t slow_frames;
+	int64_t slow_bytes;
+	int slow_action;		// QuoteSlowActionEnum
+
+	// delta streams send a full marketdata every n updates of an instrument, 0 means never
+	int delta_snapshot_interval;
+
+	// newest quotes kept per topic, for clients resuming from a seq
+	int replay_size;
+
+	// newest completed bars kept per instrument and interval, for /kline/history, 0 keeps nothing
+	int kline_history_size;
+
+	// frames of a client asked for compression are deflated from this size
+	int64_t compress_threshold;
+	int compress_level;
+
+	// policy of the listener, and named ones a client can pick with url query "batch=name"
+	QuoteBatchPolicy batch;
+	std::vector<QuoteBatchPolicy> batch_profiles;
+
+	// price tick by "symbol" or "symbol.contract", json prices of these are fixed point
+	std::map<std::string, double> price_ticks;
+
+	QuoteServiceConf()
+		: workers(1)
+		, ws_hubs(1)
+		, ring_size(QUOTE_RING_DEFAULT_SIZE)
+		, ring_overflow(QuoteRingOverflow_Drop)
+		, slow_frames(10000)
+		, slow_bytes(16 * 1024 * 1024)
+		, slow_action(QuoteSlowAction_Conflate)
+		, delta_snapshot_interval(QUOTE_DELTA_DEFAULT_SNAPSHOT_INTERVAL)
+		, replay_size(QUOTE_REPLAY_DEFAULT_SIZE)
+		, kline_history_size(KLINE_HISTORY_DEFAULT_SIZE)
+		, compress_threshold(QUOTE_COMPRESS_DEFAULT_THRESHOLD)
+		, compress_level(QUOTE_COMPRESS_DEFAULT_LEVEL)
+	{}
+};
+
+void LoadQuoteServiceConf(rapidjson::Value &doc, QuoteServiceConf &conf);
+
+
+}
+
+#endif
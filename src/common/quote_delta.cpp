@@ -0,0 +1,216 @@
+#include "quote_delta.h"
+
+#include <string.h>
+
+#include "converter.h"
+
+namespace babeltrader
+{
+
+
+const QuoteDeltaDouble g_quote_delta_doubles[QUOTE_DELTA_DOUBLE_CNT] = {
+	{ "last", &MarketData::last },
+	{ "vol", &MarketData::vol },
+	{ "turnover", &MarketData::turnover },
+	{ "avg_price", &MarketData::avg_price },
+	{ "pre_settlement", &MarketData::pre_settlement },
+	{ "pre_close", &MarketData::pre_close },
+	{ "pre_open_interest", &MarketData::pre_open_interest },
+	{ "settlement", &MarketData::settlement },
+	{ "close", &MarketData::close },
+	{ "open_interest", &MarketData::open_interest },
+	{ "upper_limit", &MarketData::upper_limit },
+	{ "lower_limit", &MarketData::lower_limit },
+	{ "open", &MarketData::open },
+	{ "high", &MarketData::high },
+	{ "low", &MarketData::low },
+};
+
+static int ClampDepth(int depth)
+{
+	if (depth < 0) {
+		return 0;
+	}
+	if (depth > BIDASK_MAX_LEN) {
+		return BIDASK_MAX_LEN;
+	}
+	return depth;
+}
+
+// compare bits, so NaN and DBL_MAX placeholders count as unchanged
+static bool SameDouble(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+static bool SameLevel(const PriceVol &a, const PriceVol &b)
+{
+	return SameDouble(a.price, b.price) && a.vol == b.vol;
+}
+
+QuoteDeltaState::QuoteDeltaState(int snapshot_interval)
+	: snapshot_interval_(snapshot_interval)
+{}
+
+void QuoteDeltaState::Update(const QuoteMarketData &msg, QuoteDelta &delta)
+{
+	std::string key(msg.quote.symbol);
+	key.append(1, '.');
+	key.append(msg.quote.contract);
+
+	const MarketData &md = msg.market_data;
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	auto it = entries_.find(key);
+	if (it == entries_.end()) {
+		Entry &entry = entries_[key];
+		entry.last = msg;
+		entry.seq = 1;
+		entry.since_snapshot = 0;
+		FullDelta(md, entry.seq, delta);
+		return;
+	}
+
+	Entry &entry = it->second;
+	entry.seq++;
+	entry.since_snapshot++;
+	if (snapshot_interval_ > 0 && entry.since_snapshot >= snapshot_interval_) {
+		entry.last = msg;
+		entry.since_snapshot = 0;
+		FullDelta(md, entry.seq, delta);
+		return;
+	}
+
+	const MarketData &last = entry.last.market_data;
+	delta.seq = entry.seq;
+	delta.snapshot = false;
+	delta.depth = ClampDepth(md.bid_ask_len);
+	delta.field_mask = 0;
+	delta.bid_mask = 0;
+	delta.ask_mask = 0;
+
+	if (md.ts != last.ts) {
+		delta.field_mask |= 1 << QUOTE_DELTA_FIELD_TS;
+	}
+	for (int i = 0; i < QUOTE_DELTA_DOUBLE_CNT; i++) {
+		double MarketData::*field = g_quote_delta_doubles[i].field;
+		if (!SameDouble(md.*field, last.*field)) {
+			delta.field_mask |= 1 << (i + 1);
+		}
+	}
+	if (strncmp(md.trading_day, last.trading_day, sizeof(md.trading_day)) != 0) {
+		delta.field_mask |= 1 << QUOTE_DELTA_FIELD_TRADING_DAY;
+	}
+	if (strncmp(md.action_day, last.action_day, sizeof(md.action_day)) != 0) {
+		delta.field_mask |= 1 << QUOTE_DELTA_FIELD_ACTION_DAY;
+	}
+
+	int last_depth = ClampDepth(last.bid_ask_len);
+	for (int i = 0; i < delta.depth; i++) {
+		if (i >= last_depth || !SameLevel(md.bids[i], last.bids[i])) {
+			delta.bid_mask |= 1 << i;
+		}
+		if (i >= last_depth || !SameLevel(md.asks[i], last.asks[i])) {
+			delta.ask_mask |= 1 << i;
+		}
+	}
+
+	entry.last = msg;
+}
+
+void QuoteDeltaState::Snapshot(const QuoteMarketData &msg, QuoteDelta &delta)
+{
+	std::string key(msg.quote.symbol);
+	key.append(1, '.');
+	key.append(msg.quote.contract);
+
+	uint64_t seq = 0;
+	{
+		std::unique_lock<std::mutex> lock(mtx_);
+		auto it = entries_.find(key);
+		if (it != entries_.end()) {
+			seq = it->second.seq;
+		}
+	}
+
+	FullDelta(msg.market_data, seq, delta);
+}
+
+void QuoteDeltaState::ForEach(const std::function<void(const QuoteMarketData&, uint64_t seq)> &fn)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	for (auto &it : entries_) {
+		fn(it.second.last, it.second.seq);
+	}
+}
+
+void QuoteDeltaState::FullDelta(const MarketData &md, uint64_t seq, QuoteDelta &delta)
+{
+	delta.seq = seq;
+	delta.snapshot = true;
+	delta.depth = ClampDepth(md.bid_ask_len);
+	delta.field_mask = (1 << QUOTE_DELTA_FIELD_CNT) - 1;
+	delta.bid_mask = (uint16_t)((1 << delta.depth) - 1);
+	delta.ask_mask = delta.bid_mask;
+}
+
+void SerializeMarketDataDelta(rapidjson::Writer<rapidjson::StringBuffer> &writer, const MarketData &md, const QuoteDelta &delta)
+{
+	writer.Key("seq");
+	writer.Uint64(delta.seq);
+	writer.Key("snapshot");
+	writer.Bool(delta.snapshot);
+	writer.Key("depth");
+	writer.Int(delta.depth);
+
+	if (delta.field_mask & (1 << QUOTE_DELTA_FIELD_TS)) {
+		writer.Key("ts");
+		writer.Int64(md.ts);
+	}
+	for (int i = 0; i < QUOTE_DELTA_DOUBLE_CNT; i++) {
+		if (delta.field_mask & (1 << (i + 1))) {
+			writer.Key(g_quote_delta_doubles[i].name);
+			SerializeDouble(writer, md.*(g_quote_delta_doubles[i].field));
+		}
+	}
+	if (delta.field_mask & (1 << QUOTE_DELTA_FIELD_TRADING_DAY)) {
+		writer.Key("trading_day");
+		writer.String(md.trading_day);
+	}
+	if (delta.field_mask & (1 << QUOTE_DELTA_FIELD_ACTION_DAY)) {
+		writer.Key("action_day");
+		writer.String(md.action_day);
+	}
+
+	// changed levels as [level, price, vol]
+	if (delta.bid_mask) {
+		writer.Key("bids");
+		writer.StartArray();
+		for (int i = 0; i < delta.depth; i++) {
+			if (delta.bid_mask & (1 << i)) {
+				writer.StartArray();
+				writer.Int(i);
+				SerializeDouble(writer, md.bids[i].price);
+				writer.Int64(md.bids[i].vol);
+				writer.EndArray();
+			}
+		}
+		writer.EndArray();
+	}
+	if (delta.ask_mask) {
+		writer.Key("asks");
+		writer.StartArray();
+		for (int i = 0; i < delta.depth; i++) {
+			if (delta.ask_mask & (1 << i)) {
+				writer.StartArray();
+				writer.Int(i);
+				SerializeDouble(writer, md.asks[i].price);
+				writer.Int64(md.asks[i].vol);
+				writer.EndArray();
+			}
+		}
+		writer.EndArray();
+	}
+}
+
+
+}
@@ -0,0 +1,83 @@
+#ifndef BABELTRADER_QUOTE_DELTA_H_
+#define BABELTRADER_QUOTE_DELTA_H_
+
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <mutex>
+#include <functional>
+
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+
+#include "common/common_struct.h"
+
+namespace babeltrader
+{
+
+// delta encoded marketdata
+//
+// field bits: 0 - ts, 1 ~ 15 - doubles in g_quote_delta_doubles order,
+// 16 - trading_day, 17 - action_day. depth is always sent, bid/ask masks
+// mark the changed levels
+
+#define QUOTE_DELTA_DOUBLE_CNT 15
+#define QUOTE_DELTA_FIELD_TS 0
+#define QUOTE_DELTA_FIELD_TRADING_DAY 16
+#define QUOTE_DELTA_FIELD_ACTION_DAY 17
+#define QUOTE_DELTA_FIELD_CNT 18
+#define QUOTE_DELTA_DEFAULT_SNAPSHOT_INTERVAL 100
+
+struct QuoteDeltaDouble
+{
+	const char *name;
+	double MarketData::*field;
+};
+extern const QuoteDeltaDouble g_quote_delta_doubles[QUOTE_DELTA_DOUBLE_CNT];
+
+struct QuoteDelta
+{
+	uint64_t seq;
+	bool snapshot;
+	int depth;
+	uint32_t field_mask;
+	uint16_t bid_mask;
+	uint16_t ask_mask;
+};
+
+// last sent marketdata of every instrument in one delta stream
+class QuoteDeltaState
+{
+public:
+	// every snapshot_interval updates of an instrument goes out in full, 0 means never
+	QuoteDeltaState(int snapshot_interval);
+
+	// compare with last sent and remember the new one
+	void Update(const QuoteMarketData &msg, QuoteDelta &delta);
+
+	// full state of the instrument with current seq
+	void Snapshot(const QuoteMarketData &msg, QuoteDelta &delta);
+
+	void ForEach(const std::function<void(const QuoteMarketData&, uint64_t seq)> &fn);
+
+	static void FullDelta(const MarketData &md, uint64_t seq, QuoteDelta &delta);
+
+private:
+	struct Entry
+	{
+		QuoteMarketData last;
+		uint64_t seq;
+		int since_snapshot;
+	};
+
+	int snapshot_interval_;
+	std::mutex mtx_;
+	std::map<std::string, Entry> entries_;
+};
+
+void SerializeMarketDataDelta(rapidjson::Writer<rapidjson::StringBuffer> &writer, const MarketData &md, const QuoteDelta &delta);
+
+
+}
+
+#endif
@@ -0,0 +1,514 @@
+#include "quote_json.h"
+
+#include <string.h>
+#include <math.h>
+
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/internal/dtoa.h"
+#include "rapidjson/internal/itoa.h"
+
+#include "enum.h"
+
+namespace babeltrader
+{
+
+#define QUOTE_JSON_LIT(p, s) do { memcpy(p, s, sizeof(s) - 1); p += sizeof(s) - 1; } while (0)
+
+// key of a projected field, comma before every key but the first
+#define QUOTE_JSON_KEY(p, first, k) do { if (!first) { *p++ = ','; } first = false; QUOTE_JSON_LIT(p, "\"" k "\":"); } while (0)
+
+static uint64_t QuoteJsonKeyHash(const Quote &quote)
+{
+	const uint8_t *p = (const uint8_t*)&quote;
+	uint64_t h = 14695981039346656037ULL;
+	for (size_t i = 0; i < QUOTE_JSON_KEY_LEN; i++) {
+		h = (h ^ p[i]) * 1099511628211ULL;
+	}
+	return h;
+}
+
+static inline char* WriteDouble(char *p, double d)
+{
+	// rapidjson refuses nan and inf and leaves a broken document
+	if (!isfinite(d)) {
+		QUOTE_JSON_LIT(p, "null");
+		return p;
+	}
+	return rapidjson::internal::dtoa(d, p);
+}
+
+static inline char* WriteInt64(char *p, int64_t v)
+{
+	return rapidjson::internal::i64toa(v, p);
+}
+
+// same escape as rapidjson::Writer::String
+static char* WriteString(char *p, const char *s, size_t max_len)
+{
+	static const char hex[] = "0123456789ABCDEF";
+
+	*p++ = '"';
+	for (size_t i = 0; i < max_len && s[i]; i++) {
+		unsigned char c = (unsigned char)s[i];
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			*p++ = (char)c;
+			continue;
+		}
+
+		*p++ = '\\';
+		switch (c)
+		{
+			case '"': *p++ = '"'; break;
+			case '\\': *p++ = '\\'; break;
+			case '\b': *p++ = 'b'; break;
+			case '\f': *p++ = 'f'; break;
+			case '\n': *p++ = 'n'; break;
+			case '\r': *p++ = 'r'; break;
+			case '\t': *p++ = 't'; break;
+			default:
+			{
+				*p++ = 'u';
+				*p++ = '0';
+				*p++ = '0';
+				*p++ = hex[c >> 4];
+				*p++ = hex[c & 0xf];
+			}break;
+		}
+	}
+	*p++ = '"';
+	return p;
+}
+
+static inline char* WritePrice(char *p, double price, const PriceTick *tick)
+{
+	if (tick) {
+		char *end = WriteTickPrice(p, price, *tick);
+		if (end) {
+			return end;
+		}
+	}
+	return WriteDouble(p, price);
+}
+
+static char* WritePriceVols(char *p, const PriceVol *price_vols, int len, const PriceTick *tick)
+{
+	*p++ = '[';
+	for (int i = 0; i < len; i++) {
+		if (i > 0) {
+			*p++ = ',';
+		}
+		*p++ = '[';
+		p = WritePrice(p, price_vols[i].price, tick);
+		*p++ = ',';
+		// converter writes vol with Int(), keep the output the same
+		p = rapidjson::internal::i32toa((int)price_vols[i].vol, p);
+		*p++ = ']';
+	}
+	*p++ = ']';
+	return p;
+}
+
+QuoteJsonEncoder::QuoteJsonEncoder()
+{}
+
+void QuoteJsonEncoder::Encode(const QuoteBlockCommon *msg, std::string &rec, const PriceTickTable *ticks, const QuoteProjection *projection, uint64_t seq)
+{
+	// quote is at the same place in every quote block
+	const QuoteJsonPrefix &prefix = GetPrefix(msg->quote, ticks);
+	const PriceTick *tick = (ticks && prefix.tick.decimals >= 0) ? &prefix.tick : nullptr;
+
+	char *p = WriteQuoteBegin(buf_, msg->quote, prefix, seq);
+	switch (msg->quote_type)
+	{
+		case QuoteBlockType_MarketData:
+		{
+			const MarketData &md = ((const QuoteMarketData*)msg)->market_data;
+			p = projection ? WriteMarketDataProjected(p, md, tick, *projection) : WriteMarketData(p, md, tick);
+		}break;
+		case QuoteBlockType_Kline:
+		{
+			p = WriteKline(p, ((const QuoteKline*)msg)->kline, tick);
+		}break;
+		case QuoteBlockType_OrderBook:
+		{
+			const OrderBook &order_book = ((const QuoteOrderBook*)msg)->order_book;
+			p = projection ? WriteOrderBookProjected(p, order_book, tick, *projection) : WriteOrderBook(p, order_book, tick);
+		}break;
+		case QuoteBlockType_Level2:
+		{
+			p = WriteLevel2(p, ((const QuoteOrderBookLevel2*)msg)->level2, tick);
+		}break;
+		default:
+		{
+			rec.clear();
+			return;
+		}
+	}
+	QUOTE_JSON_LIT(p, "}}}");
+
+	rec.assign(buf_, p - buf_);
+}
+
+const QuoteJsonEncoder::QuoteJsonPrefix& QuoteJsonEncoder::GetPrefix(const Quote &quote, const PriceTickTable *ticks)
+{
+	uint64_t h = QuoteJsonKeyHash(quote);
+	auto it = prefixes_.find(h);
+	if (it != prefixes_.end()) {
+		QuoteJsonPrefix &prefix = it->second;
+		if (memcmp(prefix.key, &quote, QUOTE_JSON_KEY_LEN) == 0) {
+			LookupTick(quote, ticks, prefix);
+			return prefix;
+		}
+
+		// hash collision, rare enough to just build it every time
+		BuildPrefix(quote, collision_);
+		LookupTick(quote, ticks, collision_);
+		return collision_;
+	}
+
+	// instruments are bounded, the limit only guards against garbage input
+	if (prefixes_.size() >= QUOTE_JSON_PREFIX_MAX) {
+		prefixes_.clear();
+	}
+
+	QuoteJsonPrefix &prefix = prefixes_[h];
+	BuildPrefix(quote, prefix);
+	LookupTick(quote, ticks, prefix);
+	return prefix;
+}
+
+void QuoteJsonEncoder::BuildPrefix(const Quote &quote, QuoteJsonPrefix &prefix)
+{
+	memcpy(prefix.key, &quote, QUOTE_JSON_KEY_LEN);
+	prefix.tick = PriceTick();
+	prefix.tick_version = UINT64_MAX;
+
+	// only built once per instrument, let rapidjson deal with it.
+	// the quote data object is left open after info2
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	writer.StartObject();
+	writer.Key("msg");
+	writer.String("quote");
+	writer.Key("data");
+	writer.StartObject();
+	writer.Key("market");
+	writer.String(g_markets[quote.market]);
+	writer.Key("exchange");
+	writer.String(g_exchanges[quote.exchange]);
+	writer.Key("type");
+	writer.String(g_product_types[quote.type]);
+	writer.Key("symbol");
+	writer.String(quote.symbol);
+	writer.Key("contract");
+	writer.String(quote.contract);
+	writer.Key("contract_id");
+	writer.String(quote.contract_id);
+	writer.Key("info1");
+	writer.String(g_quote_info1[quote.info1]);
+	writer.Key("info2");
+	writer.String(g_quote_info2[quote.info2]);
+
+	prefix.json.assign(s.GetString(), s.GetSize());
+}
+
+void QuoteJsonEncoder::LookupTick(const Quote &quote, const PriceTickTable *ticks, QuoteJsonPrefix &prefix)
+{
+	// the table only changes when ticks are loaded or queried, look up again after that
+	if (!ticks) {
+		return;
+	}
+	uint64_t version = ticks->Version();
+	if (prefix.tick_version == version) {
+		return;
+	}
+
+	prefix.tick = ticks->Find(
+		std::string(quote.symbol, strnlen(quote.symbol, sizeof(quote.symbol))),
+		std::string(quote.contract, strnlen(quote.contract, sizeof(quote.contract))));
+	prefix.tick_version = version;
+}
+
+char* QuoteJsonEncoder::WriteQuoteBegin(char *p, const Quote &quote, const QuoteJsonPrefix &prefix, uint64_t seq)
+{
+	memcpy(p, prefix.json.data(), prefix.json.size());
+	p += prefix.json.size();
+
+	if (seq > 0) {
+		QUOTE_JSON_LIT(p, ",\"seq\":");
+		p = rapidjson::internal::u64toa(seq, p);
+	}
+
+#if ENABLE_PERFORMANCE_TEST
+	QUOTE_JSON_LIT(p, ",\"ts\":");
+	p = WriteInt64(p, quote.ts);
+#endif
+
+	QUOTE_JSON_LIT(p, ",\"data\":{");
+	return p;
+}
+
+char* QuoteJsonEncoder::WriteMarketData(char *p, const MarketData &md, const PriceTick *tick)
+{
+	int bid_ask_len = md.bid_ask_len;
+	if (bid_ask_len < 0) {
+		bid_ask_len = 0;
+	} else if (bid_ask_len > BIDASK_MAX_LEN) {
+		bid_ask_len = BIDASK_MAX_LEN;
+	}
+
+	QUOTE_JSON_LIT(p, "\"ts\":");
+	p = WriteInt64(p, md.ts);
+	QUOTE_JSON_LIT(p, ",\"last\":");
+	p = WritePrice(p, md.last, tick);
+	QUOTE_JSON_LIT(p, ",\"bids\":");
+	p = WritePriceVols(p, md.bids, bid_ask_len, tick);
+	QUOTE_JSON_LIT(p, ",\"asks\":");
+	p = WritePriceVols(p, md.asks, bid_ask_len, tick);
+	QUOTE_JSON_LIT(p, ",\"vol\":");
+	p = WriteDouble(p, md.vol);
+	QUOTE_JSON_LIT(p, ",\"turnover\":");
+	p = WriteDouble(p, md.turnover);
+	QUOTE_JSON_LIT(p, ",\"avg_price\":");
+	p = WriteDouble(p, md.avg_price);
+	QUOTE_JSON_LIT(p, ",\"pre_settlement\":");
+	p = WritePrice(p, md.pre_settlement, tick);
+	QUOTE_JSON_LIT(p, ",\"pre_close\":");
+	p = WritePrice(p, md.pre_close, tick);
+	QUOTE_JSON_LIT(p, ",\"pre_open_interest\":");
+	p = WriteDouble(p, md.pre_open_interest);
+	QUOTE_JSON_LIT(p, ",\"settlement\":");
+	p = WritePrice(p, md.settlement, tick);
+	QUOTE_JSON_LIT(p, ",\"close\":");
+	p = WritePrice(p, md.close, tick);
+	QUOTE_JSON_LIT(p, ",\"open_interest\":");
+	p = WriteDouble(p, md.open_interest);
+	QUOTE_JSON_LIT(p, ",\"upper_limit\":");
+	p = WritePrice(p, md.upper_limit, tick);
+	QUOTE_JSON_LIT(p, ",\"lower_limit\":");
+	p = WritePrice(p, md.lower_limit, tick);
+	QUOTE_JSON_LIT(p, ",\"open\":");
+	p = WritePrice(p, md.open, tick);
+	QUOTE_JSON_LIT(p, ",\"high\":");
+	p = WritePrice(p, md.high, tick);
+	QUOTE_JSON_LIT(p, ",\"low\":");
+	p = WritePrice(p, md.low, tick);
+	QUOTE_JSON_LIT(p, ",\"trading_day\":");
+	p = WriteString(p, md.trading_day, sizeof(md.trading_day));
+	QUOTE_JSON_LIT(p, ",\"action_day\":");
+	p = WriteString(p, md.action_day, sizeof(md.action_day));
+	return p;
+}
+
+char* QuoteJsonEncoder::WriteOrderBook(char *p, const OrderBook &order_book, const PriceTick *tick)
+{
+	// converter writes every level of the order book, not only bid_ask_len
+	QUOTE_JSON_LIT(p, "\"ts\":");
+	p = WriteInt64(p, order_book.ts);
+	QUOTE_JSON_LIT(p, ",\"last\":");
+	p = WritePrice(p, order_book.last, tick);
+	QUOTE_JSON_LIT(p, ",\"bids\":");
+	p = WritePriceVols(p, order_book.bids, BIDASK_MAX_LEN, tick);
+	QUOTE_JSON_LIT(p, ",\"asks\":");
+	p = WritePriceVols(p, order_book.asks, BIDASK_MAX_LEN, tick);
+	QUOTE_JSON_LIT(p, ",\"vol\":");
+	p = WriteDouble(p, order_book.vol);
+	return p;
+}
+
+char* QuoteJsonEncoder::WriteMarketDataProjected(char *p, const MarketData &md, const PriceTick *tick, const QuoteProjection &projection)
+{
+	int bid_ask_len = md.bid_ask_len;
+	if (bid_ask_len < 0) {
+		bid_ask_len = 0;
+	} else if (bid_ask_len > projection.depth) {
+		bid_ask_len = projection.depth;
+	}
+
+	bool first = true;
+	if (projection.Has(QuoteField_Ts)) {
+		QUOTE_JSON_KEY(p, first, "ts");
+		p = WriteInt64(p, md.ts);
+	}
+	if (projection.Has(QuoteField_Last)) {
+		QUOTE_JSON_KEY(p, first, "last");
+		p = WritePrice(p, md.last, tick);
+	}
+	if (projection.Has(QuoteField_Bids)) {
+		QUOTE_JSON_KEY(p, first, "bids");
+		p = WritePriceVols(p, md.bids, bid_ask_len, tick);
+	}
+	if (projection.Has(QuoteField_Asks)) {
+		QUOTE_JSON_KEY(p, first, "asks");
+		p = WritePriceVols(p, md.asks, bid_ask_len, tick);
+	}
+	if (projection.Has(QuoteField_Vol)) {
+		QUOTE_JSON_KEY(p, first, "vol");
+		p = WriteDouble(p, md.vol);
+	}
+	if (projection.Has(QuoteField_Turnover)) {
+		QUOTE_JSON_KEY(p, first, "turnover");
+		p = WriteDouble(p, md.turnover);
+	}
+	if (projection.Has(QuoteField_AvgPrice)) {
+		QUOTE_JSON_KEY(p, first, "avg_price");
+		p = WriteDouble(p, md.avg_price);
+	}
+	if (projection.Has(QuoteField_PreSettlement)) {
+		QUOTE_JSON_KEY(p, first, "pre_settlement");
+		p = WritePrice(p, md.pre_settlement, tick);
+	}
+	if (projection.Has(QuoteField_PreClose)) {
+		QUOTE_JSON_KEY(p, first, "pre_close");
+		p = WritePrice(p, md.pre_close, tick);
+	}
+	if (projection.Has(QuoteField_PreOpenInterest)) {
+		QUOTE_JSON_KEY(p, first, "pre_open_interest");
+		p = WriteDouble(p, md.pre_open_interest);
+	}
+	if (projection.Has(QuoteField_Settlement)) {
+		QUOTE_JSON_KEY(p, first, "settlement");
+		p = WritePrice(p, md.settlement, tick);
+	}
+	if (projection.Has(QuoteField_Close)) {
+		QUOTE_JSON_KEY(p, first, "close");
+		p = WritePrice(p, md.close, tick);
+	}
+	if (projection.Has(QuoteField_OpenInterest)) {
+		QUOTE_JSON_KEY(p, first, "open_interest");
+		p = WriteDouble(p, md.open_interest);
+	}
+	if (projection.Has(QuoteField_UpperLimit)) {
+		QUOTE_JSON_KEY(p, first, "upper_limit");
+		p = WritePrice(p, md.upper_limit, tick);
+	}
+	if (projection.Has(QuoteField_LowerLimit)) {
+		QUOTE_JSON_KEY(p, first, "lower_limit");
+		p = WritePrice(p, md.lower_limit, tick);
+	}
+	if (projection.Has(QuoteField_Open)) {
+		QUOTE_JSON_KEY(p, first, "open");
+		p = WritePrice(p, md.open, tick);
+	}
+	if (projection.Has(QuoteField_High)) {
+		QUOTE_JSON_KEY(p, first, "high");
+		p = WritePrice(p, md.high, tick);
+	}
+	if (projection.Has(QuoteField_Low)) {
+		QUOTE_JSON_KEY(p, first, "low");
+		p = WritePrice(p, md.low, tick);
+	}
+	if (projection.Has(QuoteField_TradingDay)) {
+		QUOTE_JSON_KEY(p, first, "trading_day");
+		p = WriteString(p, md.trading_day, sizeof(md.trading_day));
+	}
+	if (projection.Has(QuoteField_ActionDay)) {
+		QUOTE_JSON_KEY(p, first, "action_day");
+		p = WriteString(p, md.action_day, sizeof(md.action_day));
+	}
+	return p;
+}
+
+char* QuoteJsonEncoder::WriteOrderBookProjected(char *p, const OrderBook &order_book, const PriceTick *tick, const QuoteProjection &projection)
+{
+	int depth = projection.depth < BIDASK_MAX_LEN ? projection.depth : BIDASK_MAX_LEN;
+
+	bool first = true;
+	if (projection.Has(QuoteField_Ts)) {
+		QUOTE_JSON_KEY(p, first, "ts");
+		p = WriteInt64(p, order_book.ts);
+	}
+	if (projection.Has(QuoteField_Last)) {
+		QUOTE_JSON_KEY(p, first, "last");
+		p = WritePrice(p, order_book.last, tick);
+	}
+	if (projection.Has(QuoteField_Bids)) {
+		QUOTE_JSON_KEY(p, first, "bids");
+		p = WritePriceVols(p, order_book.bids, depth, tick);
+	}
+	if (projection.Has(QuoteField_Asks)) {
+		QUOTE_JSON_KEY(p, first, "asks");
+		p = WritePriceVols(p, order_book.asks, depth, tick);
+	}
+	if (projection.Has(QuoteField_Vol)) {
+		QUOTE_JSON_KEY(p, first, "vol");
+		p = WriteDouble(p, order_book.vol);
+	}
+	return p;
+}
+
+char* QuoteJsonEncoder::WriteKline(char *p, const Kline &kline, const PriceTick *tick)
+{
+	QUOTE_JSON_LIT(p, "\"ts\":");
+	p = WriteInt64(p, kline.ts);
+	QUOTE_JSON_LIT(p, ",\"open\":");
+	p = WritePrice(p, kline.open, tick);
+	QUOTE_JSON_LIT(p, ",\"high\":");
+	p = WritePrice(p, kline.high, tick);
+	QUOTE_JSON_LIT(p, ",\"low\":");
+	p = WritePrice(p, kline.low, tick);
+	QUOTE_JSON_LIT(p, ",\"close\":");
+	p = WritePrice(p, kline.close, tick);
+	QUOTE_JSON_LIT(p, ",\"vol\":");
+	p = WriteDouble(p, kline.vol);
+	return p;
+}
+
+char* QuoteJsonEncoder::WriteLevel2(char *p, const OrderBookLevel2 &level2, const PriceTick *tick)
+{
+	const char *action = g_orderbookl2_action[level2.action];
+
+	QUOTE_JSON_LIT(p, "\"ts\":");
+	p = WriteInt64(p, level2.ts);
+	QUOTE_JSON_LIT(p, ",\"action\":");
+	p = WriteString(p, action, strlen(action));
+	QUOTE_JSON_LIT(p, ",\"data\":{");
+	switch (level2.action)
+	{
+		case OrderBookL2Action_Entrust:
+		{
+			const char *dir = g_order_dir[level2.entrust.dir];
+			const char *order_type = g_order_type[level2.entrust.order_type];
+
+			QUOTE_JSON_LIT(p, "\"channel_no\":");
+			p = WriteInt64(p, level2.entrust.channel_no);
+			QUOTE_JSON_LIT(p, ",\"seq\":");
+			p = WriteInt64(p, level2.entrust.seq);
+			QUOTE_JSON_LIT(p, ",\"price\":");
+			p = WritePrice(p, level2.entrust.price, tick);
+			QUOTE_JSON_LIT(p, ",\"vol\":");
+			p = WriteDouble(p, level2.entrust.vol);
+			QUOTE_JSON_LIT(p, ",\"dir\":");
+			p = WriteString(p, dir, strlen(dir));
+			QUOTE_JSON_LIT(p, ",\"order_type\":");
+			p = WriteString(p, order_type, strlen(order_type));
+		}break;
+		case OrderBookL2Action_Trade:
+		{
+			const char *trade_flag = g_orderbookl2_trade_flag[level2.trade.trade_flag];
+
+			QUOTE_JSON_LIT(p, "\"channel_no\":");
+			p = WriteInt64(p, level2.trade.channel_no);
+			QUOTE_JSON_LIT(p, ",\"seq\":");
+			p = WriteInt64(p, level2.trade.seq);
+			QUOTE_JSON_LIT(p, ",\"price\":");
+			p = WritePrice(p, level2.trade.price, tick);
+			QUOTE_JSON_LIT(p, ",\"vol\":");
+			p = WriteDouble(p, level2.trade.vol);
+			QUOTE_JSON_LIT(p, ",\"bid_no\":");
+			p = WriteInt64(p, level2.trade.bid_no);
+			QUOTE_JSON_LIT(p, ",\"ask_no\":");
+			p = WriteInt64(p, level2.trade.ask_no);
+			QUOTE_JSON_LIT(p, ",\"trade_flag\":");
+			p = WriteString(p, trade_flag, strlen(trade_flag));
+		}break;
+		default:
+			break;
+	}
+	*p++ = '}';
+	return p;
+}
+
+
+}
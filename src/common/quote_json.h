@@ -0,0 +1,73 @@
+#ifndef BABELTRADER_QUOTE_JSON_H_
+#define BABELTRADER_QUOTE_JSON_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+
+#include "common_struct.h"
+#include "price_tick.h"
+#include "quote_projection.h"
+
+namespace babeltrader
+{
+
+// enough for the biggest quote record, strings are at most 6 bytes per char after escape
+#define QUOTE_JSON_BUF_SIZE 16384
+#define QUOTE_JSON_PREFIX_MAX 65536
+
+// instrument part of Quote, everything before ts
+#define QUOTE_JSON_KEY_LEN (offsetof(Quote, info2) + 1)
+
+// specialized quote encoder, output is the same as the converter Serialize* functions,
+// except non-finite doubles are written as null, and prices of instruments with a
+// known tick are printed as fixed point with the tick's decimals.
+// with a projection, marketdata and orderbook only carry the picked fields and levels.
+// a seq not 0 is written as "seq" after info2.
+// the quote head of every instrument is serialized once and cached, key fragments are
+// memcpy'd and numbers use the same shortest round trip formatter as rapidjson.
+// not thread safe, keep one per thread
+class QuoteJsonEncoder
+{
+public:
+	QuoteJsonEncoder();
+
+	QuoteJsonEncoder(const QuoteJsonEncoder&) = delete;
+	QuoteJsonEncoder& operator=(const QuoteJsonEncoder&) = delete;
+
+	void Encode(const QuoteBlockCommon *msg, std::string &rec, const PriceTickTable *ticks = nullptr, const QuoteProjection *projection = nullptr, uint64_t seq = 0);
+
+	size_t PrefixCacheSize() const { return prefixes_.size(); }
+
+private:
+	struct QuoteJsonPrefix
+	{
+		char key[QUOTE_JSON_KEY_LEN];
+		std::string json;
+		PriceTick tick;
+		uint64_t tick_version;	// table version the tick was looked up at
+	};
+
+	const QuoteJsonPrefix& GetPrefix(const Quote &quote, const PriceTickTable *ticks);
+	void BuildPrefix(const Quote &quote, QuoteJsonPrefix &prefix);
+	void LookupTick(const Quote &quote, const PriceTickTable *ticks, QuoteJsonPrefix &prefix);
+
+	char* WriteQuoteBegin(char *p, const Quote &quote, const QuoteJsonPrefix &prefix, uint64_t seq);
+	char* WriteMarketData(char *p, const MarketData &md, const PriceTick *tick);
+	char* WriteOrderBook(char *p, const OrderBook &order_book, const PriceTick *tick);
+	char* WriteMarketDataProjected(char *p, const MarketData &md, const PriceTick *tick, const QuoteProjection &projection);
+	char* WriteOrderBookProjected(char *p, const OrderBook &order_book, const PriceTick *tick, const QuoteProjection &projection);
+	char* WriteKline(char *p, const Kline &kline, const PriceTick *tick);
+	char* WriteLevel2(char *p, const OrderBookLevel2 &level2, const PriceTick *tick);
+
+private:
+	std::unordered_map<uint64_t, QuoteJsonPrefix> prefixes_;
+	QuoteJsonPrefix collision_;
+	char buf_[QUOTE_JSON_BUF_SIZE];
+};
+
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include "quote_projection.h"
+
+#include <string.h>
+
+namespace babeltrader
+{
+
+
+const char *g_quote_fields[QuoteField_Max] = {
+	"ts",
+	"last",
+	"bids",
+	"asks",
+	"vol",
+	"turnover",
+	"avg_price",
+	"pre_settlement",
+	"pre_close",
+	"pre_open_interest",
+	"settlement",
+	"close",
+	"open_interest",
+	"upper_limit",
+	"lower_limit",
+	"open",
+	"high",
+	"low",
+	"trading_day",
+	"action_day",
+};
+QuoteFieldEnum getQuoteFieldEnum(const char *field)
+{
+	for (int i = 0; i < QuoteField_Max; i++) {
+		if (strcmp(field, g_quote_fields[i]) == 0) {
+			return (QuoteFieldEnum)i;
+		}
+	}
+	return QuoteField_Max;
+}
+
+uint32_t QuoteProjection::Id() const
+{
+	if (IsFull()) {
+		return 0;
+	}
+	return field_mask | ((uint32_t)depth << 24);
+}
+QuoteProjection QuoteProjection::FromId(uint32_t id)
+{
+	QuoteProjection projection;
+	if (id != 0) {
+		projection.field_mask = id & QUOTE_FIELD_ALL;
+		projection.depth = (int)(id >> 24);
+	}
+	return projection;
+}
+
+std::string QuoteProjectedTopic(const std::string &topic, uint32_t projection)
+{
+	if (projection == 0) {
+		return topic;
+	}
+	return topic + "#" + std::to_string(projection);
+}
+
+
+}
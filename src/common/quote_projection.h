@@ -0,0 +1,68 @@
+#ifndef BABELTRADER_QUOTE_PROJECTION_H_
+#define BABELTRADER_QUOTE_PROJECTION_H_
+
+#include <stdint.h>
+#include <string>
+
+#include "common/common_struct.h"
+
+namespace babeltrader
+{
+
+// fields of marketdata and orderbook a json subscription can pick,
+// orderbook only has ts, last, bids, asks and vol
+enum QuoteFieldEnum
+{
+	QuoteField_Ts = 0,
+	QuoteField_Last,
+	QuoteField_Bids,
+	QuoteField_Asks,
+	QuoteField_Vol,
+	QuoteField_Turnover,
+	QuoteField_AvgPrice,
+	QuoteField_PreSettlement,
+	QuoteField_PreClose,
+	QuoteField_PreOpenInterest,
+	QuoteField_Settlement,
+	QuoteField_Close,
+	QuoteField_OpenInterest,
+	QuoteField_UpperLimit,
+	QuoteField_LowerLimit,
+	QuoteField_Open,
+	QuoteField_High,
+	QuoteField_Low,
+	QuoteField_TradingDay,
+	QuoteField_ActionDay,
+	QuoteField_Max,
+};
+extern const char *g_quote_fields[QuoteField_Max];
+QuoteFieldEnum getQuoteFieldEnum(const char *field);
+
+#define QUOTE_FIELD_ALL ((1u << QuoteField_Max) - 1)
+
+// field mask and bid/ask depth of a subscription. the id identifies the projection
+// in topic keys, 0 is the full record
+struct QuoteProjection
+{
+	QuoteProjection()
+		: field_mask(QUOTE_FIELD_ALL)
+		, depth(BIDASK_MAX_LEN)
+	{}
+
+	bool IsFull() const { return field_mask == QUOTE_FIELD_ALL && depth >= BIDASK_MAX_LEN; }
+	bool Has(int field) const { return (field_mask & (1u << field)) != 0; }
+
+	uint32_t Id() const;
+	static QuoteProjection FromId(uint32_t id);
+
+	uint32_t field_mask;
+	int depth;
+};
+
+// topic key of projected subscribers, e.g. rb1901.marketdata#16777231
+std::string QuoteProjectedTopic(const std::string &topic, uint32_t projection);
+
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+#include "quote_replay.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "enum.h"
+
+namespace babeltrader
+{
+
+static size_t QuoteBlockSize(uint8_t quote_type)
+{
+	switch (quote_type)
+	{
+		case QuoteBlockType_MarketData: return sizeof(QuoteMarketData);
+		case QuoteBlockType_Kline: return sizeof(QuoteKline);
+		case QuoteBlockType_OrderBook: return sizeof(QuoteOrderBook);
+		case QuoteBlockType_Level2: return sizeof(QuoteOrderBookLevel2);
+	}
+	return 0;
+}
+
+QuoteReplayTable::QuoteReplayTable(int size)
+	: size_(size > 0 ? (size_t)size : 1)
+{}
+
+uint64_t QuoteReplayTable::Stamp(const QuoteBlockCommon *msg)
+{
+	// same key as QuoteTopicKey
+	const Quote &quote = msg->quote;
+	key_.assign(quote.symbol, strnlen(quote.symbol, sizeof(quote.symbol)));
+	key_.append(quote.contract, strnlen(quote.contract, sizeof(quote.contract)));
+	key_.append(1, '.');
+	if (quote.info1 > QuoteInfo1_Unknown && quote.info1 < QuoteInfo1_Max) {
+		key_.append(g_quote_info1[quote.info1]);
+	}
+
+	QuoteReplayTopic &topic = topics_[key_];
+	if (topic.recs.empty()) {
+		topic.recs.resize(size_);
+	}
+
+	uint64_t seq = ++topic.seq;
+	size_t len = QuoteBlockSize(msg->quote_type);
+	topic.recs[seq % size_].assign((const char*)msg, len);
+
+	QuoteReplayNewest *newest = nullptr;
+	for (auto &it : topic.newest) {
+		if (it.info2 == quote.info2) {
+			newest = &it;
+			break;
+		}
+	}
+	if (newest == nullptr) {
+		topic.newest.push_back(QuoteReplayNewest());
+		newest = &topic.newest.back();
+		newest->info2 = quote.info2;
+	}
+	newest->seq = seq;
+	newest->rec.assign((const char*)msg, len);
+
+	return seq;
+}
+
+uint64_t QuoteReplayTable::LastSeq(const std::string &topic)
+{
+	QuoteReplayTopic *replay = Find(topic);
+	return replay ? replay->seq : 0;
+}
+
+bool QuoteReplayTable::Replay(const std::string &topic, uint64_t seq, const std::function<void(const QuoteBlockCommon*, uint64_t)> &fn)
+{
+	QuoteReplayTopic *replay = Find(topic);
+	uint64_t last = replay ? replay->seq : 0;
+	if (seq > last) {
+		return false;
+	}
+
+	// kept quotes are (last - size_, last]
+	if (last > size_ && seq < last - size_) {
+		return false;
+	}
+
+	for (uint64_t i = seq + 1; i <= last; i++) {
+		const std::string &rec = replay->recs[i % size_];
+		if (rec.empty()) {
+			return false;
+		}
+	}
+	for (uint64_t i = seq + 1; i <= last; i++) {
+		fn((const QuoteBlockCommon*)replay->recs[i % size_].data(), i);
+	}
+	return true;
+}
+
+void QuoteReplayTable::Snapshot(const std::string &topic, const std::function<void(const QuoteBlockCommon*, uint64_t)> &fn)
+{
+	QuoteReplayTopic *replay = Find(topic);
+	if (replay == nullptr) {
+		return;
+	}
+
+	std::vector<const QuoteReplayNewest*> newest;
+	for (auto &it : replay->newest) {
+		newest.push_back(&it);
+	}
+	std::sort(newest.begin(), newest.end(), [](const QuoteReplayNewest *a, const QuoteReplayNewest *b) {
+		return a->seq < b->seq;
+	});
+
+	for (auto it : newest) {
+		fn((const QuoteBlockCommon*)it->rec.data(), it->seq);
+	}
+}
+
+QuoteReplayTable::QuoteReplayTopic* QuoteReplayTable::Find(const std::string &topic)
+{
+	auto it = topics_.find(topic);
+	return it == topics_.end() ? nullptr : &it->second;
+}
+
+
+}
@@ -0,0 +1,74 @@
+#ifndef BABELTRADER_QUOTE_REPLAY_H_
+#define BABELTRADER_QUOTE_REPLAY_H_
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_struct.h"
+
+namespace babeltrader
+{
+
+#define QUOTE_REPLAY_DEFAULT_SIZE 64
+#define QUOTE_REPLAY_MAX_SIZE 65536
+
+// sequence numbers of topics, and the newest records of every topic.
+// a topic's seq starts from 1 and goes up by 1 for every quote of the topic.
+// owned by one fan-out worker, all quotes of an instrument go through the same worker,
+// so there is no lock
+class QuoteReplayTable
+{
+public:
+	explicit QuoteReplayTable(int size = QUOTE_REPLAY_DEFAULT_SIZE);
+
+	QuoteReplayTable(const QuoteReplayTable&) = delete;
+	QuoteReplayTable& operator=(const QuoteReplayTable&) = delete;
+
+	// next seq of the quote's topic, the quote is kept for replay
+	uint64_t Stamp(const QuoteBlockCommon *msg);
+
+	// seq of the newest quote of topic, 0 if it never had one
+	uint64_t LastSeq(const std::string &topic);
+
+	// quotes after seq up to the newest, in order.
+	// return false and call nothing when some of them are not kept any more
+	bool Replay(const std::string &topic, uint64_t seq, const std::function<void(const QuoteBlockCommon*, uint64_t)> &fn);
+
+	// newest quote of every info2 the topic ever had, in order. kept apart from the
+	// replay ring, so an interval that closes rarely is still there
+	void Snapshot(const std::string &topic, const std::function<void(const QuoteBlockCommon*, uint64_t)> &fn);
+
+private:
+	struct QuoteReplayNewest
+	{
+		uint8_t info2;
+		uint64_t seq;
+		std::string rec;
+	};
+
+	struct QuoteReplayTopic
+	{
+		QuoteReplayTopic()
+			: seq(0)
+		{}
+
+		uint64_t seq;
+		std::vector<std::string> recs;	// quote of seq is at seq % size, strings keep their capacity
+		std::vector<QuoteReplayNewest> newest;	// one per info2, a topic has only a few
+	};
+
+	QuoteReplayTopic* Find(const std::string &topic);
+
+private:
+	size_t size_;
+	std::unordered_map<std::string, QuoteReplayTopic> topics_;
+	std::string key_;	// reused, no allocation for known topics
+};
+
+
+}
+
+#endif
@@ -0,0 +1,222 @@
+#include "quote_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <thread>
+#include <chrono>
+
+namespace babeltrader
+{
+
+#define QUOTE_RING_SPIN 128
+
+static uint64_t RoundUpPowerOfTwo(uint64_t v)
+{
+	uint64_t n = QUOTE_RING_CACHE_LINE;
+	while (n < v) {
+		n <<= 1;
+	}
+	return n;
+}
+
+QuoteRing::QuoteRing(uint64_t capacity, int overflow)
+	: raw_(nullptr)
+	, buf_(nullptr)
+	, capacity_(RoundUpPowerOfTwo(capacity))
+	, mask_(capacity_ - 1)
+	, overflow_(overflow)
+	, write_pos_(0)
+	, write_cnt_(0)
+	, read_pos_(0)
+	, read_cnt_(0)
+	, drop_cnt_(0)
+	, block_cnt_(0)
+	, peak_bytes_(0)
+	, peak_records_(0)
+	, waiting_(false)
+{
+	// keep the data area aligned to cache line, whatever malloc gives back
+	raw_ = (char*)malloc((size_t)capacity_ + QUOTE_RING_CACHE_LINE);
+	if (raw_ == nullptr) {
+		throw std::bad_alloc();
+	}
+	buf_ = (char*)(((uintptr_t)raw_ + QUOTE_RING_CACHE_LINE - 1) & ~(uintptr_t)(QUOTE_RING_CACHE_LINE - 1));
+	memset(buf_, 0, (size_t)capacity_);
+}
+QuoteRing::~QuoteRing()
+{
+	free(raw_);
+}
+
+bool QuoteRing::Write(const void *data, uint32_t len)
+{
+	uint64_t need = (sizeof(RecordHead) + len + QUOTE_RING_ALIGN - 1) & ~(uint64_t)(QUOTE_RING_ALIGN - 1);
+	if (len == 0 || need > capacity_ / 2) {
+		drop_cnt_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	// reserve space
+	uint64_t pos = 0, offset = 0, total = 0;
+	bool blocked = false;
+	while (true) {
+		pos = write_pos_.load(std::memory_order_relaxed);
+		offset = pos & mask_;
+		total = need;
+		if (offset + need > capacity_) {
+			// record never wraps, the tail becomes padding
+			total += capacity_ - offset;
+		}
+
+		if (pos + total - read_pos_.load(std::memory_order_acquire) > capacity_) {
+			if (overflow_ == QuoteRingOverflow_Drop) {
+				drop_cnt_.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			if (!blocked) {
+				blocked = true;
+				block_cnt_.fetch_add(1, std::memory_order_relaxed);
+			}
+			std::this_thread::yield();
+			continue;
+		}
+
+		if (write_pos_.compare_exchange_weak(pos, pos + total, std::memory_order_relaxed)) {
+			break;
+		}
+	}
+
+	if (total != need) {
+		RecordHead *pad = (RecordHead*)(buf_ + offset);
+		pad->len = 0;
+		pad->size.store((uint32_t)(capacity_ - offset), std::memory_order_release);
+		offset = 0;
+	}
+
+	RecordHead *head = (RecordHead*)(buf_ + offset);
+	head->len = len;
+	memcpy((char*)head + sizeof(RecordHead), data, len);
+	head->size.store((uint32_t)need, std::memory_order_release);
+
+	uint64_t end = pos + total;
+	uint64_t cnt = write_cnt_.fetch_add(1, std::memory_order_relaxed) + 1;
+	uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+	uint64_t read_cnt = read_cnt_.load(std::memory_order_relaxed);
+	UpdatePeak(end > read_pos ? end - read_pos : 0, cnt > read_cnt ? cnt - read_cnt : 0);
+
+	// wake up consumer if it sleeps
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waiting_.load(std::memory_order_relaxed)) {
+		std::unique_lock<std::mutex> lock(mtx_);
+		cv_.notify_one();
+	}
+
+	return true;
+}
+
+const void* QuoteRing::Front(uint32_t *len)
+{
+	while (true) {
+		uint64_t pos = read_pos_.load(std::memory_order_relaxed);
+		if (pos == write_pos_.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+
+		RecordHead *head = (RecordHead*)(buf_ + (pos & mask_));
+		uint32_t size = head->size.load(std::memory_order_acquire);
+		if (size == 0) {
+			// reserved but producer not finish copy yet
+			return nullptr;
+		}
+
+		if (head->len == 0) {
+			memset((void*)head, 0, size);
+			read_pos_.store(pos + size, std::memory_order_release);
+			continue;
+		}
+
+		*len = head->len;
+		return (const char*)head + sizeof(RecordHead);
+	}
+}
+void QuoteRing::Pop()
+{
+	uint64_t pos = read_pos_.load(std::memory_order_relaxed);
+	RecordHead *head = (RecordHead*)(buf_ + (pos & mask_));
+	uint32_t size = head->size.load(std::memory_order_relaxed);
+
+	// clear the whole record, a later header may land in the middle of it
+	memset((void*)head, 0, size);
+	read_cnt_.fetch_add(1, std::memory_order_relaxed);
+	read_pos_.store(pos + size, std::memory_order_release);
+}
+bool QuoteRing::Wait(int timeout_ms)
+{
+	return WaitUs((int64_t)timeout_ms * 1000);
+}
+bool QuoteRing::WaitUs(int64_t timeout_us)
+{
+	for (int i = 0; i < QUOTE_RING_SPIN; ++i) {
+		if (Readable()) {
+			return true;
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	waiting_.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	bool ret = cv_.wait_for(lock, std::chrono::microseconds(timeout_us), [this] { return Readable(); });
+	waiting_.store(false, std::memory_order_relaxed);
+
+	return ret;
+}
+
+void QuoteRing::GetStats(QuoteRingStats &stats)
+{
+	uint64_t write_pos = write_pos_.load(std::memory_order_relaxed);
+	uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+	uint64_t write_cnt = write_cnt_.load(std::memory_order_relaxed);
+	uint64_t read_cnt = read_cnt_.load(std::memory_order_relaxed);
+
+	stats.capacity = capacity_;
+	stats.depth_bytes = write_pos >= read_pos ? write_pos - read_pos : 0;
+	stats.depth_records = write_cnt >= read_cnt ? write_cnt - read_cnt : 0;
+	stats.peak_bytes = peak_bytes_.load(std::memory_order_relaxed);
+	stats.peak_records = peak_records_.load(std::memory_order_relaxed);
+	stats.write_records = write_cnt;
+	stats.read_records = read_cnt;
+	stats.drop_records = drop_cnt_.load(std::memory_order_relaxed);
+	stats.block_records = block_cnt_.load(std::memory_order_relaxed);
+}
+
+bool QuoteRing::Readable()
+{
+	uint64_t pos = read_pos_.load(std::memory_order_relaxed);
+	if (pos == write_pos_.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	RecordHead *head = (RecordHead*)(buf_ + (pos & mask_));
+	return head->size.load(std::memory_order_acquire) != 0;
+}
+void QuoteRing::UpdatePeak(uint64_t depth_bytes, uint64_t depth_records)
+{
+	uint64_t peak = peak_bytes_.load(std::memory_order_relaxed);
+	while (depth_bytes > peak) {
+		if (peak_bytes_.compare_exchange_weak(peak, depth_bytes, std::memory_order_relaxed)) {
+			break;
+		}
+	}
+
+	peak = peak_records_.load(std::memory_order_relaxed);
+	while (depth_records > peak) {
+		if (peak_records_.compare_exchange_weak(peak, depth_records, std::memory_order_relaxed)) {
+			break;
+		}
+	}
+}
+
+
+}
@@ -0,0 +1,100 @@
+#ifndef BABELTRADER_QUOTE_RING_H_
+#define BABELTRADER_QUOTE_RING_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace babeltrader
+{
+
+#define QUOTE_RING_CACHE_LINE 64
+#define QUOTE_RING_ALIGN 8
+#define QUOTE_RING_DEFAULT_SIZE (8 * 1024 * 1024)
+#define QUOTE_RING_MIN_SIZE (64 * 1024)
+
+enum QuoteRingOverflowEnum
+{
+	QuoteRingOverflow_Drop = 0,		// drop the incoming record and count it
+	QuoteRingOverflow_Block,		// producer spins until the reader frees space
+	QuoteRingOverflow_Max,
+};
+
+struct QuoteRingStats
+{
+	uint64_t capacity;
+	uint64_t depth_bytes;
+	uint64_t depth_records;
+	uint64_t peak_bytes;
+	uint64_t peak_records;
+	uint64_t write_records;
+	uint64_t read_records;
+	uint64_t drop_records;
+	uint64_t block_records;
+};
+
+// bounded multi producer, single consumer ring with variable length records.
+// the consumer reads records in place: Front() points into the ring and the
+// record stays valid until Pop()
+class QuoteRing
+{
+public:
+	QuoteRing(uint64_t capacity = QUOTE_RING_DEFAULT_SIZE, int overflow = QuoteRingOverflow_Drop);
+	~QuoteRing();
+
+	QuoteRing(const QuoteRing&) = delete;
+	QuoteRing& operator=(const QuoteRing&) = delete;
+
+	// producer side, thread safe. a record never wraps, so one taking more than
+	// half the capacity may not fit even in an empty ring, it is refused
+	bool Write(const void *data, uint32_t len);
+
+	// consumer side, only one thread
+	const void* Front(uint32_t *len);
+	void Pop();
+	bool Wait(int timeout_ms);
+	bool WaitUs(int64_t timeout_us);
+
+	void GetStats(QuoteRingStats &stats);
+
+private:
+	struct RecordHead
+	{
+		std::atomic<uint32_t> size;	// total bytes of record, 0 means not committed
+		uint32_t len;				// payload bytes, 0 means tail padding
+	};
+
+	bool Readable();
+	void UpdatePeak(uint64_t depth_bytes, uint64_t depth_records);
+
+private:
+	char *raw_;
+	char *buf_;
+	uint64_t capacity_;
+	uint64_t mask_;
+	int overflow_;
+
+	// producer and consumer cursors live in separate cache lines
+	char pad0_[QUOTE_RING_CACHE_LINE];
+	std::atomic<uint64_t> write_pos_;
+	std::atomic<uint64_t> write_cnt_;
+	char pad1_[QUOTE_RING_CACHE_LINE];
+	std::atomic<uint64_t> read_pos_;
+	std::atomic<uint64_t> read_cnt_;
+	char pad2_[QUOTE_RING_CACHE_LINE];
+
+	std::atomic<uint64_t> drop_cnt_;
+	std::atomic<uint64_t> block_cnt_;
+	std::atomic<uint64_t> peak_bytes_;
+	std::atomic<uint64_t> peak_records_;
+
+	std::atomic<bool> waiting_;
+	std::mutex mtx_;
+	std::condition_variable cv_;
+};
+
+
+}
+
+#endif
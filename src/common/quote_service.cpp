@@ -1,176 +1,602 @@
 #include "quote_service.h"
 
+#include <string.h>
+#include <algorithm>
+
 #include "glog/logging.h"
 
 #include "converter.h"
 #include "ws_service.h"
 #include "utils_func.h"
+#include "enum.h"
+#include "quote_binary.h"
+#include "quote_json.h"
+#include "serialize_buffer.h"
 
 
 namespace babeltrader
 {
 
+#define QUOTE_ASYNC_WAIT_MS 100
+#define QUOTE_ASYNC_MAX_READ 1024
+#define QUOTE_SLOT_DRAIN_MS 5
+
+// control record of worker ring, not a quote
+#define QUOTE_BLOCK_SUB_JOB 0x80
+
+// a subscription with snapshot or resume, quote is only for routing and topic
+struct QuoteSubJob
+{
+	uint8_t quote_type;		// QUOTE_BLOCK_SUB_JOB
+	Quote quote;
+	WsConnHandle conn;
+	uint32_t projection;
+	int max_rate;
+	bool conflate;
+	bool resume;
+	uint64_t seq;
+};
+
+static int64_t SteadyMs()
+{
+	auto t = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(t).count();
+}
+static int64_t SteadyUs()
+{
+	auto t = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::microseconds>(t).count();
+}
+
+// FNV-1a of symbol and contract
+static uint64_t QuoteInstrumentHash(const Quote &quote)
+{
+	uint64_t h = 14695981039346656037ULL;
+	for (const char *p = quote.symbol; p < quote.symbol + sizeof(quote.symbol) && *p; p++) {
+		h = (h ^ (uint8_t)*p) * 1099511628211ULL;
+	}
+	h = (h ^ (uint8_t)'.') * 1099511628211ULL;
+	for (const char *p = quote.contract; p < quote.contract + sizeof(quote.contract) && *p; p++) {
+		h = (h ^ (uint8_t)*p) * 1099511628211ULL;
+	}
+	return h;
+}
+
+// instrument prefixes and ticks are cached per thread
+static QuoteJsonEncoder& ThreadJsonEncoder()
+{
+	static thread_local QuoteJsonEncoder encoder;
+	return encoder;
+}
+
+// frames built under index lock, sent by the same thread after unlock. a full
+// outbox blocks the sender, and the hub thread must be able to take the index
+// lock meanwhile, or it never drains
+struct QuoteOutFrame
+{
+	int hub;
+	WsConnHandle conn;
+	uWS::OpCode op_code;
+	QuoteConnFlow *flow;		// retained until sent, null for control messages
+	std::shared_ptr<QuoteConnDeflate> deflate;	// compressed right before sent
+	std::string data;
+};
+
+struct QuoteOutFrames
+{
+	QuoteOutFrames()
+		: cnt(0)
+	{}
+
+	std::vector<QuoteOutFrame> frames;	// strings are reused
+	size_t cnt;
+};
+
+static QuoteOutFrames& ThreadOutFrames()
+{
+	static thread_local QuoteOutFrames out;
+	return out;
+}
+
+static void OnQuoteSent(uWS::WebSocket<uWS::SERVER> *ws, void *data, bool cancelled, void *reserved)
+{
+	QuoteConnFlow *flow = (QuoteConnFlow*)data;
+	flow->OnSent();
+	flow->Release();
+}
+
+QuoteService::QuoteService(const QuoteServiceConf &conf)
+	: ws_service_(nullptr)
+	, kline_history_(conf.kline_history_size)
+	, delta_json_(conf.delta_snapshot_interval)
+	, delta_bin_(conf.delta_snapshot_interval)
+	, slow_frames_(conf.slow_frames)
+	, slow_bytes_(conf.slow_bytes)
+	, slow_action_(conf.slow_action)
+	, compress_threshold_(conf.compress_threshold)
+	, compress_level_(conf.compress_level)
+{
+	// the listener policy is always index 0
+	batch_policies_.push_back(conf.batch);
+	batch_policies_[0].name = QUOTE_BATCH_DEFAULT_NAME;
+	batch_policies_.insert(batch_policies_.end(), conf.batch_profiles.begin(), conf.batch_profiles.end());
+
+	price_ticks_.Load(conf.price_ticks);
+
+	for (size_t i = 0; i < batch_policies_.size(); i++) {
+		batch_metrics_.push_back(std::unique_ptr<QuoteBatchMetrics>(new QuoteBatchMetrics()));
+	}
+
+	int workers = conf.workers > 0 ? conf.workers : 1;
+	for (int i = 0; i < workers; i++) {
+		QuoteWorker *worker = new QuoteWorker(conf.ring_size, conf.ring_overflow, conf.replay_size);
+		worker->batch_groups.resize(batch_policies_.size());
+		for (auto &group : worker->batch_groups) {
+			group.cnt = 0;
+		}
+		workers_.push_back(std::unique_ptr<QuoteWorker>(worker));
+	}
+}
+
 void QuoteService::RunAsyncLoop()
 {
-	std::thread th(&QuoteService::AsyncLoop, this);
-	th.detach();
+	for (auto &worker : workers_) {
+		std::thread th(&QuoteService::AsyncLoop, this, worker.get());
+		th.detach();
+	}
 }
 
 void QuoteService::BroadcastMarketData(QuoteMarketData &msg, bool async)
 {
+	msg.quote_type = QuoteBlockType_MarketData;
 	if (async)
 	{
-		static_assert(sizeof(QuoteBlock) >= sizeof(QuoteMarketData), "QuoteBlock size is not enough");
-
-		msg.quote_type = QuoteBlockType_MarketData;
-		QuoteBlock *p_block = (QuoteBlock*)&msg;
-		tunnel_.Write(*p_block);
+		PushRing(&msg, sizeof(msg));
 	}
 	else
 	{
-		SyncBroadcastMarketData(&msg);
+		SyncBroadcast((const QuoteBlockCommon*)&msg);
 	}
-	
 }
 void QuoteService::BroadcastKline(QuoteKline &msg, bool async)
 {
+	msg.quote_type = QuoteBlockType_Kline;
 	if (async)
 	{
-		static_assert(sizeof(QuoteBlock) >= sizeof(QuoteKline), "QuoteBlock size is not enough");
-
-		msg.quote_type = QuoteBlockType_Kline;
-		QuoteBlock *p_block = (QuoteBlock*)&msg;
-		tunnel_.Write(*p_block);
+		PushRing(&msg, sizeof(msg));
 	}
 	else
 	{
-		SyncBroadcastKline(&msg);
+		SyncBroadcast((const QuoteBlockCommon*)&msg);
 	}
 }
 void QuoteService::BroadcastOrderBook(QuoteOrderBook &msg, bool async)
 {
+	msg.quote_type = QuoteBlockType_OrderBook;
 	if (async)
 	{
-		static_assert(sizeof(QuoteBlock) >= sizeof(QuoteOrderBook), "QuoteBlock size is not enough");
-
-		msg.quote_type = QuoteBlockType_OrderBook;
-		QuoteBlock *p_block = (QuoteBlock*)&msg;
-		tunnel_.Write(*p_block);
+		PushRing(&msg, sizeof(msg));
 	}
 	else
 	{
-		SyncBroadcastOrderBook(&msg);
+		SyncBroadcast((const QuoteBlockCommon*)&msg);
 	}
 }
 void QuoteService::BroadcastLevel2(QuoteOrderBookLevel2 &msg, bool async)
 {
+	msg.quote_type = QuoteBlockType_Level2;
 	if (async)
 	{
-		static_assert(sizeof(QuoteBlock) >= sizeof(QuoteOrderBookLevel2), "QuoteBlock size is not enough");
-
-		msg.quote_type = QuoteBlockType_Level2;
-		QuoteBlock *p_block = (QuoteBlock*)&msg;
-		tunnel_.Write(*p_block);
+		PushRing(&msg, sizeof(msg));
 	}
 	else
 	{
-		SyncBroadcastLevel2(&msg);
+		SyncBroadcast((const QuoteBlockCommon*)&msg);
 	}
 }
 
-void QuoteService::AsyncLoop()
+void QuoteService::GetQuoteRingStats(QuoteRingStats &stats)
 {
-#if ENABLE_PERFORMANCE_TEST
-	// cache peak monitor
-	static int64_t max_tunnel_cache = 0;
+	memset(&stats, 0, sizeof(stats));
+	for (auto &worker : workers_) {
+		QuoteRingStats worker_stats;
+		worker->ring.GetStats(worker_stats);
+		stats.capacity += worker_stats.capacity;
+		stats.depth_bytes += worker_stats.depth_bytes;
+		stats.depth_records += worker_stats.depth_records;
+		stats.peak_bytes = std::max(stats.peak_bytes, worker_stats.peak_bytes);
+		stats.peak_records = std::max(stats.peak_records, worker_stats.peak_records);
+		stats.write_records += worker_stats.write_records;
+		stats.read_records += worker_stats.read_records;
+		stats.drop_records += worker_stats.drop_records;
+		stats.block_records += worker_stats.block_records;
+	}
+}
+void QuoteService::GetWorkerRingStats(std::vector<QuoteRingStats> &stats)
+{
+	for (auto &worker : workers_) {
+		QuoteRingStats worker_stats;
+		worker->ring.GetStats(worker_stats);
+		stats.push_back(worker_stats);
+	}
+}
+void QuoteService::GetConnStats(std::vector<QuoteConnStats> &stats)
+{
+	topic_index_.ForEachConn([this, &stats](QuoteConn *conn) {
+		QuoteConnStats conn_stats;
+		conn_stats.addr = conn->addr;
+		conn_stats.encoding = conn->encoding;
+		conn_stats.batch = batch_policies_[conn->batch_policy].name;
+		conn_stats.sub_all = conn->sub_all;
+		conn_stats.topics = (int)conn->topics.size();
+		conn_stats.pending_frames = conn->flow->pending_frames.load(std::memory_order_relaxed);
+		conn_stats.pending_bytes = conn->flow->pending_bytes.load(std::memory_order_relaxed);
+		conn_stats.peak_bytes = conn->flow->peak_bytes.load(std::memory_order_relaxed);
+		conn_stats.sent_frames = conn->flow->sent_frames.load(std::memory_order_relaxed);
+		conn_stats.drop_frames = conn->total_drop_frames;
+		conn_stats.slow_times = conn->slow_times;
+		conn_stats.slow = conn->slow;
+		conn_stats.compress = false;
+		conn_stats.compress_frames = 0;
+		conn_stats.compress_in_bytes = 0;
+		conn_stats.compress_out_bytes = 0;
+		conn_stats.compress_us = 0;
+		if (conn->deflate) {
+			conn_stats.compress = conn->deflate->ok.load(std::memory_order_relaxed);
+			conn_stats.compress_frames = conn->deflate->frames.load(std::memory_order_relaxed);
+			conn_stats.compress_in_bytes = conn->deflate->in_bytes.load(std::memory_order_relaxed);
+			conn_stats.compress_out_bytes = conn->deflate->out_bytes.load(std::memory_order_relaxed);
+			conn_stats.compress_us = conn->deflate->us.load(std::memory_order_relaxed);
+		}
+		stats.push_back(conn_stats);
+	});
+}
 
-	// avg cache pkgs and avg elapsed time monitor
-	static int64_t total_pkg = 0;
-	static int64_t step = 10000;
+void QuoteService::GetBatchStats(std::vector<QuoteBatchStats> &stats)
+{
+	for (size_t i = 0; i < batch_policies_.size(); i++) {
+		QuoteBatchStats batch_stats;
+		batch_stats.policy = batch_policies_[i];
+		batch_metrics_[i]->size.Snapshot(batch_stats.size);
+		batch_metrics_[i]->delay_us.Snapshot(batch_stats.delay_us);
+		stats.push_back(batch_stats);
+	}
+}
+int QuoteService::FindBatchPolicy(const std::string &name)
+{
+	if (name.empty()) {
+		return 0;
+	}
+	for (size_t i = 0; i < batch_policies_.size(); i++) {
+		if (batch_policies_[i].name == name) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
 
-	static int64_t rec_cnt = 0;
+void QuoteService::GetSnapshots(const std::vector<std::string> &keys, std::string &records, std::vector<std::string> &missing)
+{
+	// rest requests run in hub threads, each has its own encoder
+	QuoteJsonEncoder &encoder = ThreadJsonEncoder();
+	if (keys.empty()) {
+		std::vector<std::string> all_keys;
+		snapshots_.GetKeys(all_keys);
+		for (auto &key : all_keys) {
+			snapshots_.Append(key, encoder, &price_ticks_, records);
+		}
+		return;
+	}
 
-	static int64_t total_elapsed_time = 0;
-#endif
+	for (auto &key : keys) {
+		if (!snapshots_.Append(key, encoder, &price_ticks_, records)) {
+			missing.push_back(key);
+		}
+	}
+}
 
-	std::queue<QuoteBlock> queue;
-	while (true) {
-		tunnel_.Read(queue, true);
+void QuoteService::GetKlineHistory(const std::vector<std::string> &keys, int info2, int n, KlineHistoryResult &result)
+{
+	kline_history_.Get(keys, info2, n, result);
+}
 
-#if ENABLE_PERFORMANCE_TEST
-		if (queue.size() > max_tunnel_cache)
-		{
-			max_tunnel_cache = queue.size();
-			LOG(INFO) << "quote service async loop cache peak: " << max_tunnel_cache;
+void QuoteService::OnWsConnection(uWS::WebSocket<uWS::SERVER> *ws, WsConnHandle handle, int hub, int encoding, int batch_policy, bool compress)
+{
+	// schema and known instruments go out before any quote frame. this is the hub
+	// loop thread, it sends them in place before it drains quotes put into its outbox
+	topic_index_.AddConn(handle, ws, encoding, batch_policy, [this, hub, encoding, compress](QuoteConn *conn) {
+		conn->hub = hub;
+		if (compress) {
+			conn->deflate = std::make_shared<QuoteConnDeflate>(compress_level_);
+		}
+		if (!IsBinaryEncoding(encoding)) {
+			return;
 		}
 
-		total_pkg += queue.size();
-		rec_cnt++;
-#endif
+		const std::string &schema = QuoteBinSchema();
+		SendToConn(conn, schema.data(), schema.size());
 
-		if (queue.size() == 0) {
+		std::string instruments;
+		instrument_table_.Snapshot(instruments, conn->instruments_sent);
+		SendToConn(conn, instruments.data(), instruments.size());
+	});
+	SendQueued();
+}
+void QuoteService::OnWsDisconnection(WsConnHandle handle)
+{
+	topic_index_.DelConn(handle);
+}
+void QuoteService::OnReqSub(WsConnHandle conn, rapidjson::Document &doc)
+{
+	std::vector<QuoteSubTopic> topics;
+	bool all = ParseSubTopics(doc, topics);
+
+	// topics are kept by handle, requests of a closed connection find nothing
+
+	// delta clients get the delta base instead, receive-all clients already have everything
+	bool delta = false;
+	topic_index_.WithConn(conn, [&](QuoteConn *quote_conn) {
+		delta = IsDeltaEncoding(quote_conn->encoding);
+	});
+
+	// delta streams number marketdata by themselves, a topic seq can't be resumed there
+	if (delta) {
+		for (auto &topic : topics) {
+			if (topic.resume) {
+				throw std::runtime_error("field \"seq\" not supported by delta connection");
+			}
+		}
+	}
+
+	std::vector<const QuoteSubTopic*> jobs;
+	for (auto &topic : topics) {
+		if (topic.snapshot && !delta && !all) {
+			jobs.push_back(&topic);
 			continue;
 		}
+		topic_index_.Sub(conn, topic.topic, topic.policy, topic.projection);
+	}
+	if (all) {
+		topic_index_.SubAll(conn);
+	}
+	else if (!jobs.empty()) {
+		// topics of jobs are added later by workers, stop receive-all now as Sub does
+		topic_index_.UnsubAll(conn);
+	}
 
-		rapidjson::StringBuffer s;
-		rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	RspSubTopics(conn, "rsp_sub", doc);
 
-		writer.StartArray();
+	for (auto topic : jobs) {
+		if (!PushSubJob(conn, *topic)) {
+			LOG(WARNING) << "failed push sub job, subscribe without snapshot: " << topic->topic;
+			topic_index_.Sub(conn, topic->topic, topic->policy, topic->projection);
+		}
+	}
+
+	// delta clients need a base of every new topic, deltas published between
+	// Sub and here carry seq not greater than the snapshot and get skipped by client
+	topic_index_.WithConn(conn, [&](QuoteConn *quote_conn) {
+		if (!IsDeltaEncoding(quote_conn->encoding)) {
+			return;
+		}
+
+		std::set<std::string> sub_topics;
+		for (auto &topic : topics) {
+			sub_topics.insert(topic.topic);
+		}
+		SendDeltaSnapshot(quote_conn, all ? nullptr : &sub_topics);
+	});
+	SendQueued();
+}
+void QuoteService::OnReqUnsub(WsConnHandle conn, rapidjson::Document &doc)
+{
+	std::vector<QuoteSubTopic> topics;
+	bool all = ParseSubTopics(doc, topics);
+
+	if (all) {
+		topic_index_.UnsubAll(conn);
+	}
+	for (auto &topic : topics) {
+		topic_index_.Unsub(conn, topic.topic);
+	}
 
-		while (queue.size()) {
-			QuoteBlock &msg = queue.front();
+	RspSubTopics(conn, "rsp_unsub", doc);
+}
 
+void QuoteService::PushRing(const void *msg, uint32_t len)
+{
+	// all quotes of an instrument go through the same worker, keep their order
+	QuoteRing &ring = workers_[QuoteInstrumentHash(((const QuoteBlockCommon*)msg)->quote) % workers_.size()]->ring;
+	if (!ring.Write(msg, len))
+	{
+		QuoteRingStats stats;
+		ring.GetStats(stats);
+
+		// only warn on 1, 2, 4, 8 ... drops, avoid flooding log when downstream stuck
+		if ((stats.drop_records & (stats.drop_records - 1)) == 0)
+		{
+			LOG(WARNING) << "quote ring overflow, drop records: " << stats.drop_records
+				<< ", depth bytes: " << stats.depth_bytes
+				<< ", capacity: " << stats.capacity;
+		}
+	}
+}
+
+bool QuoteService::PushSubJob(WsConnHandle conn, const QuoteSubTopic &topic)
+{
+	QuoteSubJob job;
+	memset(&job, 0, sizeof(job));
+	if (topic.symbol.size() >= sizeof(job.quote.symbol) || topic.contract.size() >= sizeof(job.quote.contract)) {
+		return false;
+	}
+
+	job.quote_type = QUOTE_BLOCK_SUB_JOB;
+	job.quote.info1 = (uint8_t)topic.info1;
+	strncpy(job.quote.symbol, topic.symbol.c_str(), sizeof(job.quote.symbol));
+	strncpy(job.quote.contract, topic.contract.c_str(), sizeof(job.quote.contract));
+	job.conn = conn;
+	job.projection = topic.projection;
+	job.max_rate = topic.policy.max_rate;
+	job.conflate = topic.policy.conflate;
+	job.resume = topic.resume;
+	job.seq = topic.seq;
+
+	// same worker as quotes of the instrument
+	QuoteRing &ring = workers_[QuoteInstrumentHash(job.quote) % workers_.size()]->ring;
+	return ring.Write(&job, sizeof(job));
+}
+void QuoteService::HandleSubJob(QuoteWorker *worker, const QuoteSubJob &job)
+{
+	// quotes taken before go out to the old subscribers first, they are in the snapshot
+	for (size_t i = 0; i < worker->batch_groups.size(); i++) {
+		if (worker->batch_groups[i].cnt > 0) {
+			FlushBatch(worker, (int)i);
+		}
+	}
+
+	// this worker is the only publisher of the topic, nothing of it is sent
+	// between Sub and the snapshot, live quotes follow with seq after it
+	std::string topic = QuoteTopicKey(job.quote);
+	QuoteTopicPolicy policy;
+	policy.max_rate = job.max_rate;
+	policy.conflate = job.conflate;
+	topic_index_.Sub(job.conn, topic, policy, job.projection);
+
+	topic_index_.WithConn(job.conn, [&](QuoteConn *conn) {
+		std::string frame, rec;
+		QuoteProjection projection = QuoteProjection::FromId(job.projection);
+		auto append = [&](const QuoteBlockCommon *msg, uint64_t seq) {
+			if (job.projection != 0 && conn->encoding == QuoteEncoding_Json) {
+				ThreadJsonEncoder().Encode(msg, rec, &price_ticks_, &projection, seq);
+			}
+			else {
+				SerializeRecord(conn->encoding, msg, seq, rec);
+			}
+			FrameAppend(conn->encoding, frame, rec.data(), rec.size());
+		};
+
+		bool replay = job.resume && worker->replay.Replay(topic, job.seq, append);
+		if (!replay) {
+			worker->replay.Snapshot(topic, append);
+		}
+
+		SerializeBuffer s(SerializeBuffer_QuoteRsp);
+		auto &writer = s.Writer();
+		writer.StartObject();
+		writer.Key("msg");
+		writer.String("sub_snapshot");
+		writer.Key("data");
+		writer.StartObject();
+		writer.Key("symbol");
+		writer.String(job.quote.symbol);
+		writer.Key("contract");
+		writer.String(job.quote.contract);
+		writer.Key("info1");
+		writer.String(g_quote_info1[job.quote.info1]);
+		writer.Key("seq");
+		writer.Uint64(worker->replay.LastSeq(topic));
+		writer.Key("replay");
+		writer.Bool(replay);
+		writer.EndObject();
+		writer.EndObject();
+		QueueFrame(conn, uWS::OpCode::TEXT, s.GetString(), s.GetLength(), false);
+
+		if (!frame.empty()) {
+			FrameFinish(conn->encoding, frame);
+			SendToConn(conn, frame.data(), frame.size());
+		}
+	});
+	SendQueued();
+}
+
+void QuoteService::AsyncLoop(QuoteWorker *worker)
+{
 #if ENABLE_PERFORMANCE_TEST
-			auto t = std::chrono::system_clock::now().time_since_epoch();
-			auto cur_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t).count();
-			QuoteBlockCommon *p = (QuoteBlockCommon*)&msg;
-			total_elapsed_time += (cur_ms - p->quote.ts);
+	// cache peak monitor
+	static thread_local uint64_t max_ring_depth = 0;
+
+	// avg cache pkgs and avg elapsed time monitor
+	static thread_local int64_t total_pkg = 0;
+	static thread_local int64_t step = 10000;
+
+	static thread_local int64_t rec_cnt = 0;
+
+	static thread_local int64_t total_elapsed_time = 0;
 #endif
 
-			// Dispatch(msg);
-			switch (msg.quote_type)
+	QuoteRing &ring = worker->ring;
+
+	bool slot_pending = false;
+
+	while (true) {
+		// wake up for the earliest batch deadline, or earlier when throttled updates wait for their turn
+		int64_t wait_us = (slot_pending ? QUOTE_SLOT_DRAIN_MS : QUOTE_ASYNC_WAIT_MS) * 1000;
+		int64_t deadline_us = NextBatchDeadline(worker);
+		if (deadline_us >= 0) {
+			wait_us = std::min(wait_us, std::max(deadline_us - SteadyUs(), (int64_t)0));
+		}
+
+		int cnt = 0;
+		if (ring.WaitUs(wait_us)) {
+#if ENABLE_PERFORMANCE_TEST
+			QuoteRingStats stats;
+			ring.GetStats(stats);
+			if (stats.peak_records > max_ring_depth)
 			{
-				case QuoteBlockType_MarketData:
-				{
-					SerializeQuoteBegin(writer, ((const QuoteMarketData*)&msg)->quote);
-					SerializeMarketData(writer, ((const QuoteMarketData*)&msg)->market_data);
-					SerializeQuoteEnd(writer, ((const QuoteMarketData*)&msg)->quote);
-				}break;
-				case QuoteBlockType_Kline:
-				{
-					SerializeQuoteBegin(writer, ((const QuoteKline*)&msg)->quote);
-					SerializeKline(writer, ((const QuoteKline*)&msg)->kline);
-					SerializeQuoteEnd(writer, ((const QuoteKline*)&msg)->quote);
-				}break;
-				case QuoteBlockType_OrderBook:
-				{
-					SerializeQuoteBegin(writer, ((const QuoteOrderBook*)&msg)->quote);
-					SerializeOrderBook(writer, ((const QuoteOrderBook*)&msg)->order_book);
-					SerializeQuoteEnd(writer, ((const QuoteOrderBook*)&msg)->quote);
-				}break;
-				case QuoteBlockType_Level2:
-				{
-					SerializeQuoteBegin(writer, ((const QuoteOrderBookLevel2*)&msg)->quote);
-					SerializeLevel2(writer, ((const QuoteOrderBookLevel2*)&msg)->level2);
-					SerializeQuoteEnd(writer, ((const QuoteOrderBookLevel2*)&msg)->quote);
-				}break;
+				max_ring_depth = stats.peak_records;
+				LOG(INFO) << "quote service async loop ring peak: " << max_ring_depth
+					<< " records, " << stats.peak_bytes << " bytes";
 			}
 
-			queue.pop();
+			rec_cnt++;
+#endif
+
+			// serialize directly from ring memory, the record is released after use
+			const void *p = nullptr;
+			uint32_t len = 0;
+			while (cnt < QUOTE_ASYNC_MAX_READ && (p = ring.Front(&len)) != nullptr) {
+				const QuoteBlockCommon *msg = (const QuoteBlockCommon*)p;
+				if (msg->quote_type == QUOTE_BLOCK_SUB_JOB) {
+					QuoteSubJob job;
+					memcpy(&job, p, sizeof(job));
+					ring.Pop();
+					cnt++;
+					HandleSubJob(worker, job);
+					continue;
+				}
+
+#if ENABLE_PERFORMANCE_TEST
+				auto t = std::chrono::system_clock::now().time_since_epoch();
+				auto cur_ms = std::chrono::duration_cast<std::chrono::milliseconds>(t).count();
+				total_elapsed_time += (cur_ms - msg->quote.ts);
+				total_pkg++;
+#endif
+
+				uint64_t seq = worker->replay.Stamp(msg);
+				snapshots_.Update(msg, seq);
+				kline_history_.Update(msg);
+				AppendBatches(worker, msg, seq);
+
+				ring.Pop();
+				cnt++;
+			}
 		}
 
-		writer.EndArray();
-		uws_hub_.getDefaultGroup<uWS::SERVER>().broadcast(s.GetString(), s.GetLength(), uWS::OpCode::TEXT);
+		// batches without delay go out once the ring is drained
+		bool flushed = FlushBatches(worker);
+		if (cnt > 0 || flushed || slot_pending) {
+			slot_pending = DrainConns();
+		}
 
 #if ENABLE_PERFORMANCE_TEST
 		if (total_pkg >= step)
 		{
-			double avg_tunnel_cache = (double)total_pkg / rec_cnt;
+			double avg_ring_cache = (double)total_pkg / rec_cnt;
 			double avg_elapsed_time = (double)total_elapsed_time / total_pkg;
 			LOG(INFO)
-				<< "tunnel read: " << rec_cnt << " times"
+				<< "ring read: " << rec_cnt << " times"
 				<< ", total pkg: " << total_pkg
-				<< ", avg cache pkg: " << avg_tunnel_cache
+				<< ", avg cache pkg: " << avg_ring_cache
 				<< ", total elapsed mill seconds: " << total_elapsed_time
 				<< ", avg elapsed mill seconds: " << avg_elapsed_time;
 			total_pkg = 0;
@@ -181,89 +607,804 @@ void QuoteService::AsyncLoop()
 
 	}
 }
-// void QuoteService::Dispatch(QuoteBlock &msg)
-// {
-// #if ENABLE_PERFORMANCE_TEST
-// 	static QuoteTransferMonitor monitor;
-// 	monitor.start();
-// #endif
-// 
-// 	switch (msg.quote_type)
-// 	{
-// 	case QuoteBlockType_MarketData:
-// 	{
-// 		SyncBroadcastMarketData((const QuoteMarketData*)&msg);
-// 	}break;
-// 	case QuoteBlockType_Kline:
-// 	{
-// 		SyncBroadcastKline((const QuoteKline*)&msg);
-// 	}break;
-// 	case QuoteBlockType_OrderBook:
-// 	{
-// 		SyncBroadcastOrderBook((const QuoteOrderBook*)&msg);
-// 	}break;
-// 	case QuoteBlockType_Level2:
-// 	{
-// 		SyncBroadcastLevel2((const QuoteOrderBookLevel2*)&msg);
-// 	}break;
-// 	}
-// 
-// #if ENABLE_PERFORMANCE_TEST
-// 	monitor.end("quote service dispatch");
-// #endif
-// }
-
-void QuoteService::SyncBroadcastMarketData(const QuoteMarketData *msg)
-{
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
-
-	writer.StartArray();
-	SerializeQuoteBegin(writer, msg->quote);
-	SerializeMarketData(writer, msg->market_data);
-	SerializeQuoteEnd(writer, msg->quote);
-	writer.EndArray();
-
-	uws_hub_.getDefaultGroup<uWS::SERVER>().broadcast(s.GetString(), s.GetLength(), uWS::OpCode::TEXT);
-}
-void QuoteService::SyncBroadcastKline(const QuoteKline *msg)
-{
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
-
-	writer.StartArray();
-	SerializeQuoteBegin(writer, msg->quote);
-	SerializeKline(writer, msg->kline);
-	SerializeQuoteEnd(writer, msg->quote);
-	writer.EndArray();
-
-	uws_hub_.getDefaultGroup<uWS::SERVER>().broadcast(s.GetString(), s.GetLength(), uWS::OpCode::TEXT);
-}
-void QuoteService::SyncBroadcastOrderBook(const QuoteOrderBook *msg)
-{
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
-
-	writer.StartArray();
-	SerializeQuoteBegin(writer, msg->quote);
-	SerializeOrderBook(writer, msg->order_book);
-	SerializeQuoteEnd(writer, msg->quote);
-	writer.EndArray();
-
-	uws_hub_.getDefaultGroup<uWS::SERVER>().broadcast(s.GetString(), s.GetLength(), uWS::OpCode::TEXT);
-}
-void QuoteService::SyncBroadcastLevel2(const QuoteOrderBookLevel2 *msg)
-{
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
-
-	writer.StartArray();
-	SerializeQuoteBegin(writer, msg->quote);
-	SerializeLevel2(writer, msg->level2);
-	SerializeQuoteEnd(writer, msg->quote);
-	writer.EndArray();
-
-	uws_hub_.getDefaultGroup<uWS::SERVER>().broadcast(s.GetString(), s.GetLength(), uWS::OpCode::TEXT);
+bool QuoteService::StartBatch(QuoteWorker *worker, int batch_policy)
+{
+	// skip serialize when nobody listens, and only group by topic when someone filters
+	// or a slow client needs the newest update of each topic
+	QuoteBatchGroup &group = worker->batch_groups[batch_policy];
+	bool conflate_slow = slow_action_ == QuoteSlowAction_Conflate && topic_index_.HasSlowConn();
+	bool any_active = false;
+	for (int encoding = 0; encoding < QuoteEncoding_Max; encoding++) {
+		QuoteBatch &batch = group.batches[encoding];
+		batch.active = topic_index_.HasConn(encoding, batch_policy);
+		batch.by_topic = batch.active && (conflate_slow || topic_index_.HasTopicSubscriber(encoding));
+		batch.all.clear();
+		batch.topic_msgs.clear();
+		any_active = any_active || batch.active;
+	}
+	if (!any_active) {
+		return false;
+	}
+
+	group.bytes = 0;
+	group.start_us = SteadyUs();
+	return true;
+}
+void QuoteService::AppendBatches(QuoteWorker *worker, const QuoteBlockCommon *msg, uint64_t seq)
+{
+	// serialize once per encoding, batches of every policy share the record
+	bool serialized[QuoteEncoding_Max] = { false };
+	bool has_topic = false;
+	bool has_projection = false;
+
+	for (size_t i = 0; i < worker->batch_groups.size(); i++) {
+		QuoteBatchGroup &group = worker->batch_groups[i];
+		if (group.cnt == 0 && !StartBatch(worker, (int)i)) {
+			continue;
+		}
+
+		for (int encoding = 0; encoding < QuoteEncoding_Max; encoding++) {
+			QuoteBatch &batch = group.batches[encoding];
+			if (!batch.active) {
+				continue;
+			}
+
+			std::string &rec = worker->batch_recs[encoding];
+			std::string &last = worker->batch_lasts[encoding];
+			if (!serialized[encoding]) {
+				SerializeRecord(encoding, msg, seq, rec);
+				last.clear();
+				serialized[encoding] = true;
+			}
+
+			FrameAppend(encoding, batch.all, rec.data(), rec.size());
+			if ((int64_t)batch.all.size() > group.bytes) {
+				group.bytes = (int64_t)batch.all.size();
+			}
+
+			if (batch.by_topic) {
+				if (!has_topic) {
+					worker->batch_topic = QuoteTopicKey(msg->quote);
+					has_topic = true;
+				}
+
+				QuoteTopicMsg &topic_msg = batch.topic_msgs[worker->batch_topic];
+				FrameAppend(encoding, topic_msg.batch, rec.data(), rec.size());
+				if (msg->quote_type != QuoteBlockType_Level2) {
+					if (last.empty()) {
+						SerializeLast(encoding, msg, rec, last);
+					}
+					topic_msg.last = last;
+				}
+
+				// every projection of the topic is serialized once and batched as its own topic
+				if (encoding == QuoteEncoding_Json) {
+					if (!has_projection) {
+						SerializeProjections(msg, seq, worker->batch_topic, worker->projections, worker->projection_topics, worker->projection_recs);
+						has_projection = true;
+					}
+					for (size_t j = 0; j < worker->projections.size(); j++) {
+						const std::string &proj_rec = worker->projection_recs[j];
+						QuoteTopicMsg &proj_msg = batch.topic_msgs[worker->projection_topics[j]];
+						FrameAppend(encoding, proj_msg.batch, proj_rec.data(), proj_rec.size());
+						proj_msg.last = proj_rec;
+						proj_msg.projected = true;
+					}
+				}
+			}
+		}
+
+		group.cnt++;
+
+		const QuoteBatchPolicy &policy = batch_policies_[i];
+		if (policy.immediate ||
+			(policy.max_msgs > 0 && group.cnt >= policy.max_msgs) ||
+			(policy.max_bytes > 0 && group.bytes >= policy.max_bytes)) {
+			FlushBatch(worker, (int)i);
+		}
+	}
+}
+void QuoteService::FlushBatch(QuoteWorker *worker, int batch_policy)
+{
+	QuoteBatchGroup &group = worker->batch_groups[batch_policy];
+	for (int encoding = 0; encoding < QuoteEncoding_Max; encoding++) {
+		QuoteBatch &batch = group.batches[encoding];
+		if (!batch.active) {
+			continue;
+		}
+
+		FrameFinish(encoding, batch.all);
+		for (auto &it : batch.topic_msgs) {
+			FrameFinish(encoding, it.second.batch);
+		}
+		SendQuotes(encoding, batch_policy, batch.all.data(), batch.all.size(), batch.topic_msgs);
+	}
+
+	QuoteBatchMetrics &metrics = *batch_metrics_[batch_policy];
+	metrics.size.Record((uint64_t)group.cnt);
+	metrics.delay_us.Record((uint64_t)(SteadyUs() - group.start_us));
+
+	group.cnt = 0;
+}
+bool QuoteService::FlushBatches(QuoteWorker *worker)
+{
+	bool flushed = false;
+	int64_t now_us = SteadyUs();
+	for (size_t i = 0; i < worker->batch_groups.size(); i++) {
+		QuoteBatchGroup &group = worker->batch_groups[i];
+		if (group.cnt > 0 && group.start_us + batch_policies_[i].max_delay_us <= now_us) {
+			FlushBatch(worker, (int)i);
+			flushed = true;
+		}
+	}
+	return flushed;
+}
+int64_t QuoteService::NextBatchDeadline(QuoteWorker *worker)
+{
+	int64_t deadline_us = -1;
+	for (size_t i = 0; i < worker->batch_groups.size(); i++) {
+		QuoteBatchGroup &group = worker->batch_groups[i];
+		if (group.cnt == 0) {
+			continue;
+		}
+
+		int64_t t = group.start_us + batch_policies_[i].max_delay_us;
+		if (deadline_us < 0 || t < deadline_us) {
+			deadline_us = t;
+		}
+	}
+	return deadline_us;
+}
+void QuoteService::SyncBroadcast(const QuoteBlockCommon *msg)
+{
+	// capacity is kept between calls of the same thread
+	static thread_local std::string rec;
+	static thread_local std::string all;
+	static thread_local std::vector<uint32_t> projections;
+	static thread_local std::vector<std::string> projection_topics;
+	static thread_local std::vector<std::string> projection_recs;
+	snapshots_.Update(msg);
+	kline_history_.Update(msg);
+	for (int encoding = 0; encoding < QuoteEncoding_Max; encoding++) {
+		if (!topic_index_.HasConn(encoding)) {
+			continue;
+		}
+
+		SerializeRecord(encoding, msg, 0, rec);
+
+		all.clear();
+		FrameAppend(encoding, all, rec.data(), rec.size());
+		FrameFinish(encoding, all);
+
+		std::map<std::string, QuoteTopicMsg> topic_msgs;
+		if (topic_index_.HasTopicSubscriber(encoding) ||
+			(slow_action_ == QuoteSlowAction_Conflate && topic_index_.HasSlowConn())) {
+			std::string topic = QuoteTopicKey(msg->quote);
+			QuoteTopicMsg &topic_msg = topic_msgs[topic];
+			topic_msg.batch = all;
+			if (msg->quote_type != QuoteBlockType_Level2) {
+				SerializeLast(encoding, msg, rec, topic_msg.last);
+			}
+
+			if (encoding == QuoteEncoding_Json) {
+				SerializeProjections(msg, 0, topic, projections, projection_topics, projection_recs);
+				for (size_t i = 0; i < projections.size(); i++) {
+					QuoteTopicMsg &proj_msg = topic_msgs[projection_topics[i]];
+					FrameAppend(encoding, proj_msg.batch, projection_recs[i].data(), projection_recs[i].size());
+					FrameFinish(encoding, proj_msg.batch);
+					proj_msg.last = projection_recs[i];
+					proj_msg.projected = true;
+				}
+			}
+		}
+
+		SendQuotes(encoding, -1, all.data(), all.size(), topic_msgs);
+	}
+}
+void QuoteService::SerializeRecord(int encoding, const QuoteBlockCommon *msg, uint64_t seq, std::string &rec)
+{
+	// delta marketdata carries the seq of the delta stream
+	if (IsDeltaEncoding(encoding) && msg->quote_type == QuoteBlockType_MarketData) {
+		const QuoteMarketData &md = *(const QuoteMarketData*)msg;
+		QuoteDelta delta;
+		DeltaState(encoding).Update(md, delta);
+		SerializeDelta(encoding, md, delta, rec);
+		return;
+	}
+
+	if (IsBinaryEncoding(encoding)) {
+		QuoteBinSerialize(instrument_table_, msg, rec, seq);
+		return;
+	}
+
+	ThreadJsonEncoder().Encode(msg, rec, &price_ticks_, nullptr, seq);
+}
+void QuoteService::SerializeProjections(const QuoteBlockCommon *msg, uint64_t seq, const std::string &topic, std::vector<uint32_t> &projections, std::vector<std::string> &topics, std::vector<std::string> &recs)
+{
+	if (msg->quote_type != QuoteBlockType_MarketData && msg->quote_type != QuoteBlockType_OrderBook) {
+		projections.clear();
+		return;
+	}
+
+	topic_index_.GetProjections(QuoteEncoding_Json, topic, projections);
+	if (topics.size() < projections.size()) {
+		topics.resize(projections.size());
+		recs.resize(projections.size());
+	}
+
+	for (size_t i = 0; i < projections.size(); i++) {
+		QuoteProjection projection = QuoteProjection::FromId(projections[i]);
+		ThreadJsonEncoder().Encode(msg, recs[i], &price_ticks_, &projection, seq);
+		topics[i] = QuoteProjectedTopic(topic, projections[i]);
+	}
+}
+void QuoteService::SerializeLast(int encoding, const QuoteBlockCommon *msg, const std::string &rec, std::string &last)
+{
+	// last value replaces the updates before it, so in delta streams it must be full
+	if (IsDeltaEncoding(encoding) && msg->quote_type == QuoteBlockType_MarketData) {
+		const QuoteMarketData &md = *(const QuoteMarketData*)msg;
+		QuoteDelta delta;
+		DeltaState(encoding).Snapshot(md, delta);
+		SerializeDelta(encoding, md, delta, last);
+		return;
+	}
+
+	last = rec;
+}
+void QuoteService::SerializeDelta(int encoding, const QuoteMarketData &msg, const QuoteDelta &delta, std::string &rec)
+{
+	if (IsBinaryEncoding(encoding)) {
+		QuoteBinSerializeDelta(instrument_table_, msg, delta, rec);
+		return;
+	}
+
+	SerializeBuffer s(SerializeBuffer_QuoteDelta);
+	auto &writer = s.Writer();
+	SerializeQuoteBegin(writer, msg.quote);
+	SerializeMarketDataDelta(writer, msg.market_data, delta);
+	SerializeQuoteEnd(writer, msg.quote);
+	rec.assign(s.GetString(), s.GetLength());
+}
+QuoteDeltaState& QuoteService::DeltaState(int encoding)
+{
+	return IsBinaryEncoding(encoding) ? delta_bin_ : delta_json_;
+}
+void QuoteService::SendDeltaSnapshot(QuoteConn *conn, const std::set<std::string> *topics)
+{
+	std::string frame, rec;
+	DeltaState(conn->encoding).ForEach([&](const QuoteMarketData &msg, uint64_t seq) {
+		if (topics && topics->find(QuoteTopicKey(msg.quote)) == topics->end()) {
+			return;
+		}
+
+		QuoteDelta delta;
+		QuoteDeltaState::FullDelta(msg.market_data, seq, delta);
+		SerializeDelta(conn->encoding, msg, delta, rec);
+		FrameAppend(conn->encoding, frame, rec.data(), rec.size());
+	});
+
+	if (!frame.empty()) {
+		FrameFinish(conn->encoding, frame);
+		SendToConn(conn, frame.data(), frame.size());
+	}
+}
+void QuoteService::FrameAppend(int encoding, std::string &frame, const char *rec, size_t len)
+{
+	if (IsBinaryEncoding(encoding)) {
+		QuoteBinAppend(frame, rec, len);
+		return;
+	}
+
+	frame.append(1, frame.empty() ? '[' : ',');
+	frame.append(rec, len);
+}
+void QuoteService::FrameFinish(int encoding, std::string &frame)
+{
+	if (!IsBinaryEncoding(encoding)) {
+		frame.append(1, ']');
+	}
+}
+void QuoteService::FrameGap(int encoding, uint64_t drop_frames, std::string &frame)
+{
+	if (IsBinaryEncoding(encoding)) {
+		std::string rec;
+		QuoteBinSerializeGap(drop_frames, rec);
+		frame.clear();
+		QuoteBinAppend(frame, rec.data(), rec.size());
+		return;
+	}
+
+	frame.assign("{\"msg\":\"gap\",\"data\":{\"drop_frames\":");
+	frame.append(std::to_string(drop_frames));
+	frame.append("}}");
+}
+void QuoteService::SendQuotes(int encoding, int batch_policy, const char *all, size_t len, std::map<std::string, QuoteTopicMsg> &topic_msgs)
+{
+	Publish(encoding, batch_policy, nullptr, all, len, nullptr);
+	for (auto &it : topic_msgs) {
+		Publish(encoding, batch_policy, &it.first, it.second.batch.data(), it.second.batch.size(), &it.second.last);
+	}
+
+	if (slow_action_ == QuoteSlowAction_Conflate && topic_index_.HasSlowConn()) {
+		ConflateSlowConns(encoding, batch_policy, topic_msgs);
+	}
+}
+void QuoteService::Publish(int encoding, int batch_policy, const std::string *topic, const char *msg, size_t len, const std::string *last)
+{
+	uWS::OpCode op_code = IsBinaryEncoding(encoding) ? uWS::OpCode::BINARY : uWS::OpCode::TEXT;
+	int64_t now_ms = 0;
+	uint32_t max_instrument_id = IsBinaryEncoding(encoding) ? QuoteBinMaxInstrumentId(msg, len) : 0;
+
+	// receivers are grouped by hub, every hub frames the message once in its own loop
+	static thread_local std::vector<std::vector<WsOutboxTarget>> hub_targets;
+	hub_targets.resize(ws_service_->Hubs());
+	for (auto &targets : hub_targets) {
+		targets.clear();
+	}
+
+	auto fn = [&](QuoteConn *conn) {
+		if (batch_policy >= 0 && conn->batch_policy != batch_policy) {
+			return;
+		}
+
+		if (conn->slow || CheckSlow(conn)) {
+			OnSlowConn(conn, topic, last);
+			return;
+		}
+
+		if (topic != nullptr && !conn->slots.empty()) {
+			auto it = conn->slots.find(*topic);
+			if (it != conn->slots.end()) {
+				if (!last->empty()) {
+					it->second.pending = *last;
+					if (now_ms == 0) {
+						now_ms = SteadyMs();
+					}
+					TrySendSlot(conn, it->second, now_ms);
+				}
+				return;
+			}
+		}
+
+		// compressed frames are per connection, the deflate window differs.
+		// a connection missing instrument records gets them right before the frame
+		if ((conn->deflate && (int64_t)len >= compress_threshold_) || conn->instruments_sent < max_instrument_id) {
+			SendToConn(conn, msg, len);
+			return;
+		}
+
+		conn->flow->Retain();
+		conn->flow->Sent((uint32_t)len);
+
+		WsOutboxTarget target;
+		target.conn = conn->handle;
+		target.data = conn->flow;
+		hub_targets[conn->hub].push_back(target);
+	};
+
+	if (topic == nullptr) {
+		topic_index_.ForEachSubAll(encoding, fn);
+	}
+	else {
+		topic_index_.ForEachSubscriber(encoding, *topic, fn);
+	}
+
+	// after index unlocked, a full outbox only holds up this worker
+	for (size_t i = 0; i < hub_targets.size(); i++) {
+		std::vector<WsOutboxTarget> &targets = hub_targets[i];
+		ws_service_->Outbox((int)i).Multicast(msg, len, op_code, targets.data(), targets.size(), OnQuoteSent);
+	}
+	SendQueued();
+}
+void QuoteService::SendToConn(QuoteConn *conn, const char *msg, size_t len)
+{
+	uWS::OpCode op_code = IsBinaryEncoding(conn->encoding) ? uWS::OpCode::BINARY : uWS::OpCode::TEXT;
+	if (IsBinaryEncoding(conn->encoding)) {
+		SendInstruments(conn, QuoteBinMaxInstrumentId(msg, len));
+	}
+	QueueFrame(conn, op_code, msg, len, true);
+}
+void QuoteService::SendInstruments(QuoteConn *conn, uint32_t max_id)
+{
+	if (conn->instruments_sent >= max_id) {
+		return;
+	}
+
+	std::string frame;
+	instrument_table_.Append(conn->instruments_sent, max_id, frame);
+	conn->instruments_sent = max_id;
+	if (!frame.empty()) {
+		QueueFrame(conn, uWS::OpCode::BINARY, frame.data(), frame.size(), true);
+	}
+}
+void QuoteService::QueueFrame(QuoteConn *conn, uWS::OpCode op_code, const char *msg, size_t len, bool flow)
+{
+	QuoteOutFrames &out = ThreadOutFrames();
+	if (out.cnt == out.frames.size()) {
+		out.frames.emplace_back();
+	}
+	QuoteOutFrame &frame = out.frames[out.cnt++];
+	frame.hub = conn->hub;
+	frame.conn = conn->handle;
+	frame.op_code = op_code;
+	frame.flow = nullptr;
+	frame.data.assign(msg, len);
+	if (flow) {
+		frame.flow = conn->flow;
+		frame.flow->Retain();
+		if (conn->deflate && (int64_t)len >= compress_threshold_) {
+			frame.deflate = conn->deflate;
+		}
+	}
+}
+void QuoteService::SendQueued()
+{
+	QuoteOutFrames &out = ThreadOutFrames();
+	for (size_t i = 0; i < out.cnt; i++) {
+		QuoteOutFrame &frame = out.frames[i];
+		if (frame.deflate) {
+			SendCompressed(frame);
+			frame.deflate.reset();
+			continue;
+		}
+
+		if (frame.flow) {
+			frame.flow->Sent((uint32_t)frame.data.size());
+		}
+		ws_service_->Outbox(frame.hub).Send(frame.conn, frame.data.data(), frame.data.size(), frame.op_code,
+			frame.flow ? OnQuoteSent : nullptr, frame.flow);
+	}
+	out.cnt = 0;
+}
+void QuoteService::SendCompressed(QuoteOutFrame &frame)
+{
+	static thread_local std::string out;
+	out.clear();
+
+	// deflate and put under the stream lock, frames of a connection reach the outbox in window order
+	QuoteConnDeflate &deflate = *frame.deflate;
+	std::unique_lock<std::mutex> lock(deflate.mtx);
+
+	const std::string *data = &frame.data;
+	uWS::OpCode op_code = frame.op_code;
+	if (deflate.deflate) {
+		int64_t start_us = SteadyUs();
+		if (deflate.deflate->Compress(frame.data.data(), frame.data.size(), out)) {
+			deflate.us.fetch_add((uint64_t)(SteadyUs() - start_us), std::memory_order_relaxed);
+			deflate.frames.fetch_add(1, std::memory_order_relaxed);
+			deflate.in_bytes.fetch_add(frame.data.size(), std::memory_order_relaxed);
+			deflate.out_bytes.fetch_add(out.size(), std::memory_order_relaxed);
+			data = &out;
+			op_code = uWS::OpCode::BINARY;
+		}
+		else {
+			LOG(ERROR) << "quote deflate failed, stop compress for client handle: " << frame.conn;
+			deflate.deflate.reset();
+			deflate.ok.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	frame.flow->Sent((uint32_t)data->size());
+	ws_service_->Outbox(frame.hub).Send(frame.conn, data->data(), data->size(), op_code, OnQuoteSent, frame.flow);
+}
+bool QuoteService::TrySendSlot(QuoteConn *conn, QuoteSlot &slot, int64_t now_ms)
+{
+	if (slot.pending.empty()) {
+		return false;
+	}
+
+	if (slot.policy.max_rate > 0 && now_ms < slot.next_ms) {
+		return true;
+	}
+	if (slot.policy.conflate && conn->flow->pending_frames.load(std::memory_order_relaxed) > 0) {
+		return true;
+	}
+
+	std::string frame;
+	FrameAppend(conn->encoding, frame, slot.pending.data(), slot.pending.size());
+	FrameFinish(conn->encoding, frame);
+	SendToConn(conn, frame.data(), frame.size());
+	slot.pending.clear();
+	if (slot.policy.max_rate > 0) {
+		slot.next_ms = now_ms + 1000 / slot.policy.max_rate;
+	}
+
+	return false;
+}
+bool QuoteService::DrainConns()
+{
+	int64_t now_ms = SteadyMs();
+	bool pending = false;
+	topic_index_.ForEachSlotConn([&](QuoteConn *conn) {
+		if (conn->slow) {
+			return;
+		}
+		for (auto &it : conn->slots) {
+			if (TrySendSlot(conn, it.second, now_ms)) {
+				pending = true;
+			}
+		}
+	});
+
+	if (RecoverSlowConns()) {
+		pending = true;
+	}
+
+	SendQueued();
+	return pending;
+}
+
+bool QuoteService::CheckSlow(QuoteConn *conn)
+{
+	int64_t pending_frames = conn->flow->pending_frames.load(std::memory_order_relaxed);
+	int64_t pending_bytes = conn->flow->pending_bytes.load(std::memory_order_relaxed);
+	if (!((slow_frames_ > 0 && pending_frames >= slow_frames_) || (slow_bytes_ > 0 && pending_bytes >= slow_bytes_))) {
+		return false;
+	}
+
+	topic_index_.SetSlow(conn, true);
+	conn->drop_frames = 0;
+
+	LOG(WARNING) << "slow quote client: " << conn->addr
+		<< ", pending frames: " << pending_frames
+		<< ", pending bytes: " << pending_bytes
+		<< ", action: " << slow_action_;
+
+	if (slow_action_ == QuoteSlowAction_Disconnect) {
+		// sockets are closed in the hub loop thread
+		WsConnHandle handle = conn->handle;
+		ws_service_->Outbox(conn->hub).Post([this, handle]() {
+			KickSlowConn(handle);
+		});
+	}
+
+	return true;
+}
+void QuoteService::OnSlowConn(QuoteConn *conn, const std::string *topic, const std::string *last)
+{
+	if (slow_action_ == QuoteSlowAction_Conflate) {
+		// receive-all batches are conflated per topic in ConflateSlowConns
+		if (topic == nullptr) {
+			return;
+		}
+		if (!last->empty()) {
+			conn->conflated[*topic] = *last;
+			return;
+		}
+	}
+
+	conn->drop_frames++;
+	conn->total_drop_frames++;
+}
+void QuoteService::ConflateSlowConns(int encoding, int batch_policy, std::map<std::string, QuoteTopicMsg> &topic_msgs)
+{
+	topic_index_.ForEachSlowConn([&](QuoteConn *conn) {
+		if (conn->encoding != encoding || !conn->sub_all) {
+			return;
+		}
+		if (batch_policy >= 0 && conn->batch_policy != batch_policy) {
+			return;
+		}
+
+		for (auto &it : topic_msgs) {
+			if (it.second.projected) {
+				continue;
+			}
+			if (!it.second.last.empty()) {
+				conn->conflated[it.first] = it.second.last;
+			}
+			else {
+				conn->drop_frames++;
+				conn->total_drop_frames++;
+			}
+		}
+	});
+}
+bool QuoteService::RecoverSlowConns()
+{
+	if (!topic_index_.HasSlowConn()) {
+		return false;
+	}
+
+	bool pending = false;
+	topic_index_.ForEachSlowConn([&](QuoteConn *conn) {
+		if (slow_action_ == QuoteSlowAction_Disconnect) {
+			return;
+		}
+
+		// back to normal only after half of the threshold drained, avoid flapping
+		int64_t pending_frames = conn->flow->pending_frames.load(std::memory_order_relaxed);
+		int64_t pending_bytes = conn->flow->pending_bytes.load(std::memory_order_relaxed);
+		if ((slow_frames_ > 0 && pending_frames > slow_frames_ / 2) || (slow_bytes_ > 0 && pending_bytes > slow_bytes_ / 2)) {
+			pending = true;
+			return;
+		}
+
+		if (!conn->conflated.empty()) {
+			// newest update of every topic in one frame
+			std::string frame;
+			for (auto &it : conn->conflated) {
+				FrameAppend(conn->encoding, frame, it.second.data(), it.second.size());
+			}
+			FrameFinish(conn->encoding, frame);
+			conn->conflated.clear();
+
+			SendToConn(conn, frame.data(), frame.size());
+		}
+
+		if (conn->drop_frames > 0) {
+			std::string frame;
+			FrameGap(conn->encoding, conn->drop_frames, frame);
+
+			SendToConn(conn, frame.data(), frame.size());
+		}
+
+		LOG(INFO) << "quote client recover from slow: " << conn->addr
+			<< ", drop frames: " << conn->drop_frames;
+
+		conn->drop_frames = 0;
+		topic_index_.SetSlow(conn, false);
+	});
+
+	return pending;
+}
+void QuoteService::KickSlowConn(WsConnHandle handle)
+{
+	// in hub loop thread, only this thread removes connections of the hub, so the
+	// socket stays valid after unpin. close may run onDisconnection right away,
+	// which waits for pins of the slot
+	uWS::WebSocket<uWS::SERVER> *ws = nullptr;
+	{
+		WsConnRef ref(ws_service_->Conns(), handle);
+		ws = ref.ws();
+	}
+	if (ws) {
+		LOG(WARNING) << "close slow quote client: " << ws->getAddress().address << ":" << ws->getAddress().port;
+		ws->close(1008, "slow consumer", strlen("slow consumer"));
+	}
+}
+
+bool QuoteService::ParseSubTopics(rapidjson::Document &doc, std::vector<QuoteSubTopic> &topics)
+{
+	if (!(doc.HasMember("data") && (doc["data"].IsObject() || doc["data"].IsArray()))) {
+		throw std::runtime_error("field \"data\" need object or array");
+	}
+
+	bool all = false;
+	rapidjson::Value &data = doc["data"];
+	rapidjson::SizeType cnt = data.IsArray() ? data.Size() : 1;
+	for (rapidjson::SizeType i = 0; i < cnt; i++)
+	{
+		rapidjson::Value &item = data.IsArray() ? data[i] : data;
+		if (!item.IsObject()) {
+			throw std::runtime_error("element of \"data\" need object");
+		}
+		if (!(item.HasMember("symbol") && item["symbol"].IsString())) {
+			throw std::runtime_error("field \"symbol\" need string");
+		}
+
+		const char *symbol = item["symbol"].GetString();
+		if (strcmp(symbol, "*") == 0) {
+			all = true;
+			continue;
+		}
+
+		const char *contract = "";
+		if (item.HasMember("contract")) {
+			if (!item["contract"].IsString()) {
+				throw std::runtime_error("field \"contract\" need string");
+			}
+			contract = item["contract"].GetString();
+		}
+
+		QuoteTopicPolicy policy;
+		if (item.HasMember("max_rate")) {
+			if (!(item["max_rate"].IsInt() && item["max_rate"].GetInt() >= 0 && item["max_rate"].GetInt() <= 1000)) {
+				throw std::runtime_error("field \"max_rate\" need int between 0 and 1000");
+			}
+			policy.max_rate = item["max_rate"].GetInt();
+		}
+		if (item.HasMember("conflate")) {
+			if (!item["conflate"].IsBool()) {
+				throw std::runtime_error("field \"conflate\" need bool");
+			}
+			policy.conflate = item["conflate"].GetBool();
+		}
+
+		bool snapshot = false;
+		if (item.HasMember("snapshot")) {
+			if (!item["snapshot"].IsBool()) {
+				throw std::runtime_error("field \"snapshot\" need bool");
+			}
+			snapshot = item["snapshot"].GetBool();
+		}
+		bool resume = false;
+		uint64_t seq = 0;
+		if (item.HasMember("seq")) {
+			if (!item["seq"].IsUint64()) {
+				throw std::runtime_error("field \"seq\" need unsigned int");
+			}
+			resume = true;
+			seq = item["seq"].GetUint64();
+		}
+
+		QuoteProjection projection;
+		if (item.HasMember("fields")) {
+			if (!(item["fields"].IsArray() && item["fields"].Size() > 0)) {
+				throw std::runtime_error("field \"fields\" need non-empty array");
+			}
+			projection.field_mask = 0;
+			for (rapidjson::SizeType j = 0; j < item["fields"].Size(); j++) {
+				rapidjson::Value &field = item["fields"][j];
+				int field_id = field.IsString() ? getQuoteFieldEnum(field.GetString()) : QuoteField_Max;
+				if (field_id == QuoteField_Max) {
+					throw std::runtime_error("invalid element of field \"fields\"");
+				}
+				projection.field_mask |= 1u << field_id;
+			}
+		}
+		if (item.HasMember("depth")) {
+			if (!(item["depth"].IsInt() && item["depth"].GetInt() >= 0 && item["depth"].GetInt() <= BIDASK_MAX_LEN)) {
+				throw std::runtime_error("field \"depth\" need int between 0 and 10");
+			}
+			projection.depth = item["depth"].GetInt();
+		}
+
+		std::vector<int> info1s;
+		if (item.HasMember("info1")) {
+			if (!item["info1"].IsString()) {
+				throw std::runtime_error("field \"info1\" need string");
+			}
+			int info1 = getQuoteInfo1Enum(item["info1"].GetString());
+			if (info1 == QuoteInfo1_Unknown) {
+				throw std::runtime_error("invalid field \"info1\"");
+			}
+			info1s.push_back(info1);
+		}
+		else {
+			// without info1, all quotes of the instrument
+			info1s.push_back(QuoteInfo1_MarketData);
+			info1s.push_back(QuoteInfo1_Kline);
+			info1s.push_back(QuoteInfo1_OrderBook);
+			info1s.push_back(QuoteInfo1_Level2);
+		}
+
+		for (auto info1 : info1s) {
+			QuoteSubTopic sub_topic;
+			sub_topic.topic = QuoteTopicKey(symbol, contract, info1);
+			sub_topic.symbol = symbol;
+			sub_topic.contract = contract;
+			sub_topic.info1 = info1;
+			sub_topic.snapshot = snapshot || resume;
+			sub_topic.resume = resume;
+			sub_topic.seq = seq;
+
+			// kline and level2 updates can't be skipped, and are always full
+			if (info1 == QuoteInfo1_MarketData || info1 == QuoteInfo1_OrderBook) {
+				sub_topic.policy = policy;
+				sub_topic.projection = projection.Id();
+			}
+			topics.push_back(sub_topic);
+		}
+	}
+
+	return all;
+}
+void QuoteService::RspSubTopics(WsConnHandle conn, const char *msg, rapidjson::Document &doc)
+{
+	SerializeBuffer s(SerializeBuffer_QuoteRsp);
+	auto &writer = s.Writer();
+
+	writer.StartObject();
+	writer.Key("msg");
+	writer.String(msg);
+	writer.Key("error_id");
+	writer.Int(0);
+	writer.Key("data");
+	doc["data"].Accept(writer);
+	writer.EndObject();
+
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
 
 
@@ -2,19 +2,47 @@
 #define BABELTRADER_QUOTE_SERVICE_H_
 
 #include <vector>
+#include <map>
+#include <string>
+#include <set>
+#include <memory>
 
 #include "uWS/uWS.h"
-#include "muggle/cpp/tunnel/tunnel.hpp"
+#include "rapidjson/document.h"
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
 #include "common/common_struct.h"
+#include "common/quote_conf.h"
+#include "common/quote_ring.h"
+#include "common/quote_topic.h"
+#include "common/quote_binary.h"
+#include "common/quote_delta.h"
+#include "common/histogram.h"
+#include "common/price_tick.h"
+#include "common/quote_snapshot.h"
+#include "common/quote_replay.h"
+#include "common/kline_history.h"
+#include "common/ws_conn_table.h"
 
 namespace babeltrader
 {
 
 class WsService;
+struct QuoteSubJob;
+struct QuoteOutFrame;
+
+struct QuoteBatchStats
+{
+	QuoteBatchPolicy policy;
+	HistogramSnapshot size;		// records per frame
+	HistogramSnapshot delay_us;	// from the first record taken to the frame sent
+};
 
 class QuoteService
 {
 public:
+	QuoteService(const QuoteServiceConf &conf);
+
 	virtual std::vector<Quote> GetSubTopics(std::vector<bool> &vec_b) = 0;
 	virtual void SubTopic(const Quote &msg) = 0;
 	virtual void UnsubTopic(const Quote &msg) = 0;
@@ -26,19 +54,156 @@ public:
 	void BroadcastOrderBook(QuoteOrderBook &msg, bool async = true);
 	void BroadcastLevel2(QuoteOrderBookLevel2 &msg, bool async = true);
 
+	// sum of all workers, and each worker
+	void GetQuoteRingStats(QuoteRingStats &stats);
+	void GetWorkerRingStats(std::vector<QuoteRingStats> &stats);
+	void GetConnStats(std::vector<QuoteConnStats> &stats);
+	void GetBatchStats(std::vector<QuoteBatchStats> &stats);
+
+	// index of batch policy by name, empty name is the listener policy, -1 if not found
+	int FindBatchPolicy(const std::string &name);
+
+	// comma separated json records of the newest quotes, every instrument when keys is empty.
+	// keys without any quote yet go to missing
+	void GetSnapshots(const std::vector<std::string> &keys, std::string &records, std::vector<std::string> &missing);
+
+	// newest n completed bars of the interval, see KlineHistory::Get
+	void GetKlineHistory(const std::vector<std::string> &keys, int info2, int n, KlineHistoryResult &result);
+
+	// ws client topics
+	void OnWsConnection(uWS::WebSocket<uWS::SERVER> *ws, WsConnHandle handle, int hub, int encoding, int batch_policy, bool compress);
+	void OnWsDisconnection(WsConnHandle handle);
+	void OnReqSub(WsConnHandle conn, rapidjson::Document &doc);
+	void OnReqUnsub(WsConnHandle conn, rapidjson::Document &doc);
+
 private:
-	void AsyncLoop();
-	// void Dispatch(QuoteBlock &msg);
+	// serialized quotes of one topic in a batch
+	struct QuoteTopicMsg
+	{
+		QuoteTopicMsg()
+			: projected(false)
+		{}
+
+		std::string batch;	// all updates of the topic
+		std::string last;	// newest record only, for throttled and conflated clients
+		bool projected;		// topic key of a projection, receive-all clients never get it
+	};
+
+	// records of one batch in one encoding
+	struct QuoteBatch
+	{
+		bool active;
+		bool by_topic;
+		std::string all;
+		std::map<std::string, QuoteTopicMsg> topic_msgs;
+	};
+
+	// pending batch of one batch policy
+	struct QuoteBatchGroup
+	{
+		QuoteBatch batches[QuoteEncoding_Max];
+		int cnt;			// records in batch, 0 means not started
+		int64_t bytes;		// largest frame among encodings
+		int64_t start_us;	// when the first record was taken
+	};
 
-	void SyncBroadcastMarketData(const QuoteMarketData *msg);
-	void SyncBroadcastKline(const QuoteKline *msg);
-	void SyncBroadcastOrderBook(const QuoteOrderBook *msg);
-	void SyncBroadcastLevel2(const QuoteOrderBookLevel2 *msg);
+	struct QuoteBatchMetrics
+	{
+		Histogram size;
+		Histogram delay_us;
+	};
+
+	// fan-out worker, owns the instruments hashed to it. ring is the hand-off
+	// queue, the rest is only touched by the worker thread
+	struct QuoteWorker
+	{
+		QuoteWorker(uint64_t ring_size, int ring_overflow, int replay_size)
+			: ring(ring_size, ring_overflow)
+			, replay(replay_size)
+		{}
+
+		QuoteRing ring;
+		QuoteReplayTable replay;
+		std::vector<QuoteBatchGroup> batch_groups;
+		std::string batch_recs[QuoteEncoding_Max];
+		std::string batch_lasts[QuoteEncoding_Max];
+		std::string batch_topic;
+
+		// projected records of the current quote
+		std::vector<uint32_t> projections;
+		std::vector<std::string> projection_topics;
+		std::vector<std::string> projection_recs;
+	};
+
+	void AsyncLoop(QuoteWorker *worker);
+	bool StartBatch(QuoteWorker *worker, int batch_policy);
+	void AppendBatches(QuoteWorker *worker, const QuoteBlockCommon *msg, uint64_t seq);
+	void FlushBatch(QuoteWorker *worker, int batch_policy);
+	bool FlushBatches(QuoteWorker *worker);
+	int64_t NextBatchDeadline(QuoteWorker *worker);
+	void PushRing(const void *msg, uint32_t len);
+
+	// snapshot or resume of a topic runs in the worker owning it, between two quotes
+	bool PushSubJob(WsConnHandle conn, const QuoteSubTopic &topic);
+	void HandleSubJob(QuoteWorker *worker, const QuoteSubJob &job);
+
+	void SyncBroadcast(const QuoteBlockCommon *msg);
+	// seq 0 means the quote is not stamped
+	void SerializeRecord(int encoding, const QuoteBlockCommon *msg, uint64_t seq, std::string &rec);
+	void SerializeProjections(const QuoteBlockCommon *msg, uint64_t seq, const std::string &topic, std::vector<uint32_t> &projections, std::vector<std::string> &topics, std::vector<std::string> &recs);
+	void SerializeLast(int encoding, const QuoteBlockCommon *msg, const std::string &rec, std::string &last);
+	void SerializeDelta(int encoding, const QuoteMarketData &msg, const QuoteDelta &delta, std::string &rec);
+	QuoteDeltaState& DeltaState(int encoding);
+	void SendDeltaSnapshot(QuoteConn *conn, const std::set<std::string> *topics);
+	void FrameAppend(int encoding, std::string &frame, const char *rec, size_t len);
+	void FrameFinish(int encoding, std::string &frame);
+	void FrameGap(int encoding, uint64_t drop_frames, std::string &frame);
+	// batch_policy -1 means connections of every policy
+	void SendQuotes(int encoding, int batch_policy, const char *all, size_t len, std::map<std::string, QuoteTopicMsg> &topic_msgs);
+	void Publish(int encoding, int batch_policy, const std::string *topic, const char *msg, size_t len, const std::string *last);
+	// frames to one connection are queued under index lock, SendQueued sends them after unlock
+	void SendToConn(QuoteConn *conn, const char *msg, size_t len);
+	// binary only, instrument records of ids the connection has not got up to max_id
+	void SendInstruments(QuoteConn *conn, uint32_t max_id);
+	void QueueFrame(QuoteConn *conn, uWS::OpCode op_code, const char *msg, size_t len, bool flow);
+	void SendQueued();
+	void SendCompressed(QuoteOutFrame &frame);
+	bool TrySendSlot(QuoteConn *conn, QuoteSlot &slot, int64_t now_ms);
+	bool DrainConns();
+
+	// slow consumer
+	bool CheckSlow(QuoteConn *conn);
+	void OnSlowConn(QuoteConn *conn, const std::string *topic, const std::string *last);
+	void ConflateSlowConns(int encoding, int batch_policy, std::map<std::string, QuoteTopicMsg> &topic_msgs);
+	bool RecoverSlowConns();
+	void KickSlowConn(WsConnHandle handle);
+
+	bool ParseSubTopics(rapidjson::Document &doc, std::vector<QuoteSubTopic> &topics);
+	void RspSubTopics(WsConnHandle conn, const char *msg, rapidjson::Document &doc);
 
 public:
-	uWS::Hub uws_hub_;
 	WsService *ws_service_;
-	muggle::Tunnel<QuoteBlock> tunnel_;
+	std::vector<std::unique_ptr<QuoteWorker>> workers_;
+	QuoteTopicIndex topic_index_;
+	QuoteInstrumentTable instrument_table_;
+	PriceTickTable price_ticks_;
+	QuoteSnapshotCache snapshots_;
+	KlineHistory kline_history_;
+
+	// last sent marketdata of delta streams
+	QuoteDeltaState delta_json_;
+	QuoteDeltaState delta_bin_;
+
+	// batching, metrics are shared by all workers
+	std::vector<QuoteBatchPolicy> batch_policies_;
+	std::vector<std::unique_ptr<QuoteBatchMetrics>> batch_metrics_;
+
+	int64_t slow_frames_;
+	int64_t slow_bytes_;
+	int slow_action_;
+
+	int64_t compress_threshold_;
+	int compress_level_;
 };
 
 
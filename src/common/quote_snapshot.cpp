@@ -0,0 +1,122 @@
+#include "quote_snapshot.h"
+
+#include <string.h>
+#include <functional>
+
+namespace babeltrader
+{
+
+std::string QuoteSnapshotKey(const Quote &quote)
+{
+	std::string key(quote.symbol, strnlen(quote.symbol, sizeof(quote.symbol)));
+	key.append(quote.contract, strnlen(quote.contract, sizeof(quote.contract)));
+	return key;
+}
+
+void QuoteSnapshotCache::Update(const QuoteBlockCommon *msg, uint64_t seq)
+{
+	if (msg->quote_type != QuoteBlockType_MarketData &&
+		msg->quote_type != QuoteBlockType_OrderBook &&
+		msg->quote_type != QuoteBlockType_Kline) {
+		return;
+	}
+
+	std::string key = QuoteSnapshotKey(msg->quote);
+	QuoteSnapshotStripe &stripe = Stripe(key);
+
+	std::unique_lock<std::mutex> lock(stripe.mtx);
+	QuoteSnapshotEntry &entry = stripe.entries[key];
+	switch (msg->quote_type)
+	{
+		case QuoteBlockType_MarketData:
+		{
+			memcpy(&entry.market_data, msg, sizeof(entry.market_data));
+			entry.has_market_data = true;
+			entry.market_data_seq = seq;
+		}break;
+		case QuoteBlockType_OrderBook:
+		{
+			memcpy(&entry.order_book, msg, sizeof(entry.order_book));
+			entry.has_order_book = true;
+			entry.order_book_seq = seq;
+		}break;
+		case QuoteBlockType_Kline:
+		{
+			memcpy(&entry.klines[msg->quote.info2], msg, sizeof(QuoteKline));
+			entry.kline_seqs[msg->quote.info2] = seq;
+		}break;
+	}
+	entry.version++;
+}
+
+bool QuoteSnapshotCache::Append(const std::string &key, QuoteJsonEncoder &encoder, const PriceTickTable *ticks, std::string &out)
+{
+	QuoteSnapshotStripe &stripe = Stripe(key);
+
+	std::unique_lock<std::mutex> lock(stripe.mtx);
+	auto it = stripe.entries.find(key);
+	if (it == stripe.entries.end()) {
+		return false;
+	}
+
+	QuoteSnapshotEntry &entry = it->second;
+	uint64_t tick_version = ticks ? ticks->Version() : 0;
+	if (entry.json_version != entry.version || entry.tick_version != tick_version) {
+		Serialize(entry, encoder, ticks);
+		entry.json_version = entry.version;
+		entry.tick_version = tick_version;
+	}
+
+	if (!entry.json.empty()) {
+		if (!out.empty()) {
+			out.append(1, ',');
+		}
+		out.append(entry.json);
+	}
+	return true;
+}
+
+void QuoteSnapshotCache::GetKeys(std::vector<std::string> &keys)
+{
+	for (int i = 0; i < QUOTE_SNAPSHOT_STRIPES; i++) {
+		std::unique_lock<std::mutex> lock(stripes_[i].mtx);
+		for (auto &it : stripes_[i].entries) {
+			keys.push_back(it.first);
+		}
+	}
+}
+
+QuoteSnapshotCache::QuoteSnapshotStripe& QuoteSnapshotCache::Stripe(const std::string &key)
+{
+	return stripes_[std::hash<std::string>()(key) % QUOTE_SNAPSHOT_STRIPES];
+}
+
+void QuoteSnapshotCache::Serialize(QuoteSnapshotEntry &entry, QuoteJsonEncoder &encoder, const PriceTickTable *ticks)
+{
+	static thread_local std::string rec;
+
+	entry.json.clear();
+	auto append = [&](const QuoteBlockCommon *msg, uint64_t seq) {
+		encoder.Encode(msg, rec, ticks, nullptr, seq);
+		if (rec.empty()) {
+			return;
+		}
+		if (!entry.json.empty()) {
+			entry.json.append(1, ',');
+		}
+		entry.json.append(rec);
+	};
+
+	if (entry.has_market_data) {
+		append((const QuoteBlockCommon*)&entry.market_data, entry.market_data_seq);
+	}
+	if (entry.has_order_book) {
+		append((const QuoteBlockCommon*)&entry.order_book, entry.order_book_seq);
+	}
+	for (auto &it : entry.klines) {
+		append((const QuoteBlockCommon*)&it.second, entry.kline_seqs[it.first]);
+	}
+}
+
+
+}
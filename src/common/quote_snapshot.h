@@ -0,0 +1,88 @@
+#ifndef BABELTRADER_QUOTE_SNAPSHOT_H_
+#define BABELTRADER_QUOTE_SNAPSHOT_H_
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_struct.h"
+#include "common/price_tick.h"
+#include "common/quote_json.h"
+
+namespace babeltrader
+{
+
+#define QUOTE_SNAPSHOT_STRIPES 64
+
+// instrument key of the cache, symbol + contract
+std::string QuoteSnapshotKey(const Quote &quote);
+
+// last value cache, newest marketdata, orderbook and kline of every instrument.
+// fan-out workers update it when they take a quote off the ring, rest requests read it.
+// records of an instrument are serialized by the first read after an update,
+// then reused by every read until the next update
+class QuoteSnapshotCache
+{
+public:
+	QuoteSnapshotCache() {}
+
+	QuoteSnapshotCache(const QuoteSnapshotCache&) = delete;
+	QuoteSnapshotCache& operator=(const QuoteSnapshotCache&) = delete;
+
+	// seq is the topic seq stamped by the worker, 0 if not stamped
+	void Update(const QuoteBlockCommon *msg, uint64_t seq = 0);
+
+	// append json records of the instrument to out, comma separated.
+	// return false if the instrument never had a quote
+	bool Append(const std::string &key, QuoteJsonEncoder &encoder, const PriceTickTable *ticks, std::string &out);
+
+	void GetKeys(std::vector<std::string> &keys);
+
+private:
+	struct QuoteSnapshotEntry
+	{
+		QuoteSnapshotEntry()
+			: has_market_data(false)
+			, has_order_book(false)
+			, market_data_seq(0)
+			, order_book_seq(0)
+			, version(0)
+			, json_version(0)
+			, tick_version(0)
+		{}
+
+		QuoteMarketData market_data;
+		QuoteOrderBook order_book;
+		std::map<int, QuoteKline> klines;	// info2 -> newest kline of the interval
+		bool has_market_data;
+		bool has_order_book;
+		uint64_t market_data_seq;	// topic seq of the quotes, 0 if not stamped
+		uint64_t order_book_seq;
+		std::map<int, uint64_t> kline_seqs;
+
+		uint64_t version;		// bumped on every update
+		uint64_t json_version;	// version json was serialized at
+		uint64_t tick_version;	// price tick table version json was serialized at
+		std::string json;
+	};
+
+	struct QuoteSnapshotStripe
+	{
+		std::mutex mtx;
+		std::unordered_map<std::string, QuoteSnapshotEntry> entries;
+	};
+
+	QuoteSnapshotStripe& Stripe(const std::string &key);
+	void Serialize(QuoteSnapshotEntry &entry, QuoteJsonEncoder &encoder, const PriceTickTable *ticks);
+
+private:
+	QuoteSnapshotStripe stripes_[QUOTE_SNAPSHOT_STRIPES];
+};
+
+
+}
+
+#endif
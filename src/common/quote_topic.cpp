@@ -0,0 +1,373 @@
+#include "quote_topic.h"
+
+#include <vector>
+
+namespace babeltrader
+{
+
+const char *g_quote_encoding[QuoteEncoding_Max] = {
+	"json",
+	"binary",
+	"json_delta",
+	"binary_delta",
+};
+
+std::string QuoteTopicKey(const char *symbol, const char *contract, int info1)
+{
+	std::string key(symbol);
+	key.append(contract);
+	key.append(1, '.');
+	if (info1 > QuoteInfo1_Unknown && info1 < QuoteInfo1_Max) {
+		key.append(g_quote_info1[info1]);
+	}
+	return key;
+}
+std::string QuoteTopicKey(const Quote &quote)
+{
+	return QuoteTopicKey(quote.symbol, quote.contract, quote.info1);
+}
+
+void QuoteConnFlow::Retain()
+{
+	refs.fetch_add(1, std::memory_order_relaxed);
+}
+void QuoteConnFlow::Release()
+{
+	if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		delete this;
+	}
+}
+
+void QuoteConnFlow::Sent(uint32_t bytes)
+{
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		pending_sizes.push_back(bytes);
+	}
+
+	pending_frames.fetch_add(1, std::memory_order_relaxed);
+	int64_t cur = pending_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	int64_t peak = peak_bytes.load(std::memory_order_relaxed);
+	while (cur > peak) {
+		if (peak_bytes.compare_exchange_weak(peak, cur, std::memory_order_relaxed)) {
+			break;
+		}
+	}
+}
+void QuoteConnFlow::OnSent()
+{
+	uint32_t bytes = 0;
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		if (!pending_sizes.empty()) {
+			bytes = pending_sizes.front();
+			pending_sizes.pop_front();
+		}
+	}
+
+	pending_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+	pending_frames.fetch_sub(1, std::memory_order_relaxed);
+	sent_frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+QuoteTopicIndex::QuoteTopicIndex()
+{
+	for (int i = 0; i < QuoteEncoding_Max; i++) {
+		conn_cnt_[i] = 0;
+	}
+}
+
+void QuoteTopicIndex::AddConn(WsConnHandle handle, uWS::WebSocket<uWS::SERVER> *ws, int encoding, int batch_policy, const std::function<void(QuoteConn*)> &fn)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	if (conns_.find(handle) != conns_.end()) {
+		return;
+	}
+
+	QuoteConn &conn = conns_[handle];
+	conn.handle = handle;
+	conn.hub = 0;
+	conn.addr = std::string(ws->getAddress().address) + ":" + std::to_string(ws->getAddress().port);
+	conn.encoding = encoding;
+	conn.batch_policy = batch_policy;
+	conn.sub_all = true;
+	conn.flow = new QuoteConnFlow();
+	conn.instruments_sent = 0;
+	conn.slow = false;
+	conn.slow_times = 0;
+	conn.drop_frames = 0;
+	conn.total_drop_frames = 0;
+
+	conn_cnt_[encoding]++;
+	policy_conn_cnt_[encoding][batch_policy]++;
+	sub_all_[encoding].insert(&conn);
+
+	if (fn) {
+		fn(&conn);
+	}
+}
+void QuoteTopicIndex::DelConn(WsConnHandle handle)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	auto it = conns_.find(handle);
+	if (it == conns_.end()) {
+		return;
+	}
+
+	QuoteConn *conn = &it->second;
+	while (!conn->topics.empty()) {
+		DelTopic(conn, *conn->topics.begin());
+	}
+
+	sub_all_[conn->encoding].erase(conn);
+	slot_conns_.erase(conn);
+	slow_conns_.erase(conn);
+	conn_cnt_[conn->encoding]--;
+	if (--policy_conn_cnt_[conn->encoding][conn->batch_policy] == 0) {
+		policy_conn_cnt_[conn->encoding].erase(conn->batch_policy);
+	}
+	conn->flow->Release();
+	conns_.erase(it);
+}
+
+void QuoteTopicIndex::Sub(WsConnHandle handle, const std::string &topic, const QuoteTopicPolicy &policy, uint32_t projection)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	QuoteConn *conn = FindConn(handle);
+	if (conn == nullptr) {
+		return;
+	}
+
+	// once client start to manage topics, it never fall back to receive all
+	conn->sub_all = false;
+	sub_all_[conn->encoding].erase(conn);
+
+	if (conn->encoding != QuoteEncoding_Json) {
+		projection = 0;
+	}
+
+	auto proj_it = conn->projections.find(topic);
+	uint32_t old_projection = proj_it != conn->projections.end() ? proj_it->second : 0;
+	if (old_projection != projection) {
+		DelTopic(conn, QuoteProjectedTopic(topic, old_projection));
+	}
+
+	std::string key = QuoteProjectedTopic(topic, projection);
+	if (conn->topics.insert(key).second && projection != 0) {
+		conn->projections[topic] = projection;
+		topic_projections_[conn->encoding][topic][projection]++;
+	}
+	topic_conns_[conn->encoding][key].insert(conn);
+
+	if (policy.max_rate > 0 || policy.conflate) {
+		QuoteSlot &slot = conn->slots[key];
+		slot.policy = policy;
+		slot.next_ms = 0;
+		slot_conns_.insert(conn);
+	}
+	else if (conn->slots.erase(key) && conn->slots.empty()) {
+		slot_conns_.erase(conn);
+	}
+}
+void QuoteTopicIndex::Unsub(WsConnHandle handle, const std::string &topic)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	QuoteConn *conn = FindConn(handle);
+	if (conn == nullptr) {
+		return;
+	}
+
+	conn->sub_all = false;
+	sub_all_[conn->encoding].erase(conn);
+
+	auto proj_it = conn->projections.find(topic);
+	DelTopic(conn, QuoteProjectedTopic(topic, proj_it != conn->projections.end() ? proj_it->second : 0));
+}
+void QuoteTopicIndex::SubAll(WsConnHandle handle)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	QuoteConn *conn = FindConn(handle);
+	if (conn == nullptr) {
+		return;
+	}
+
+	conn->sub_all = true;
+	sub_all_[conn->encoding].insert(conn);
+}
+void QuoteTopicIndex::UnsubAll(WsConnHandle handle)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	QuoteConn *conn = FindConn(handle);
+	if (conn == nullptr) {
+		return;
+	}
+
+	conn->sub_all = false;
+	sub_all_[conn->encoding].erase(conn);
+}
+void QuoteTopicIndex::WithConn(WsConnHandle handle, const std::function<void(QuoteConn*)> &fn)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	QuoteConn *conn = FindConn(handle);
+	if (conn != nullptr) {
+		fn(conn);
+	}
+}
+
+bool QuoteTopicIndex::HasConn(int encoding)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	return conn_cnt_[encoding] > 0;
+}
+bool QuoteTopicIndex::HasConn(int encoding, int batch_policy)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	return policy_conn_cnt_[encoding].find(batch_policy) != policy_conn_cnt_[encoding].end();
+}
+bool QuoteTopicIndex::HasTopicSubscriber(int encoding)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	return !topic_conns_[encoding].empty();
+}
+
+void QuoteTopicIndex::GetProjections(int encoding, const std::string &topic, std::vector<uint32_t> &projections)
+{
+	projections.clear();
+
+	std::unique_lock<std::mutex> lock(mtx_);
+	auto &topic_projections = topic_projections_[encoding];
+	if (topic_projections.empty()) {
+		return;
+	}
+
+	auto it = topic_projections.find(topic);
+	if (it != topic_projections.end()) {
+		for (auto &proj : it->second) {
+			projections.push_back(proj.first);
+		}
+	}
+}
+
+void QuoteTopicIndex::ForEachSubAll(int encoding, const std::function<void(QuoteConn*)> &fn)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	for (auto conn : sub_all_[encoding]) {
+		fn(conn);
+	}
+}
+void QuoteTopicIndex::ForEachSubscriber(int encoding, const std::string &topic, const std::function<void(QuoteConn*)> &fn)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	auto &topic_conns = topic_conns_[encoding];
+	auto it = topic_conns.find(topic);
+	if (it == topic_conns.end()) {
+		return;
+	}
+
+	for (auto conn : it->second) {
+		// a connection subscribed to all already got the whole batch
+		if (!conn->sub_all) {
+			fn(conn);
+		}
+	}
+}
+
+void QuoteTopicIndex::ForEachSlotConn(const std::function<void(QuoteConn*)> &fn)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	for (auto conn : slot_conns_) {
+		fn(conn);
+	}
+}
+
+void QuoteTopicIndex::ForEachSlowConn(const std::function<void(QuoteConn*)> &fn)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+
+	// callback may clear the slow flag
+	std::vector<QuoteConn*> conns(slow_conns_.begin(), slow_conns_.end());
+	for (auto conn : conns) {
+		fn(conn);
+	}
+}
+void QuoteTopicIndex::ForEachConn(const std::function<void(QuoteConn*)> &fn)
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	for (auto &it : conns_) {
+		fn(&it.second);
+	}
+}
+
+void QuoteTopicIndex::SetSlow(QuoteConn *conn, bool slow)
+{
+	conn->slow = slow;
+	if (slow) {
+		conn->slow_times++;
+		slow_conns_.insert(conn);
+	}
+	else {
+		slow_conns_.erase(conn);
+	}
+}
+
+bool QuoteTopicIndex::HasSlowConn()
+{
+	std::unique_lock<std::mutex> lock(mtx_);
+	return !slow_conns_.empty();
+}
+
+QuoteConn* QuoteTopicIndex::FindConn(WsConnHandle handle)
+{
+	auto it = conns_.find(handle);
+	if (it == conns_.end()) {
+		return nullptr;
+	}
+	return &it->second;
+}
+void QuoteTopicIndex::DelTopic(QuoteConn *conn, const std::string &topic)
+{
+	if (conn->topics.erase(topic) == 0) {
+		return;
+	}
+
+	if (conn->slots.erase(topic) && conn->slots.empty()) {
+		slot_conns_.erase(conn);
+	}
+
+	auto &topic_conns = topic_conns_[conn->encoding];
+	auto it = topic_conns.find(topic);
+	if (it != topic_conns.end()) {
+		it->second.erase(conn);
+		if (it->second.empty()) {
+			topic_conns.erase(it);
+		}
+	}
+
+	// projected key is topic#projection
+	size_t pos = topic.rfind('#');
+	if (pos == std::string::npos) {
+		return;
+	}
+
+	std::string base = topic.substr(0, pos);
+	auto proj_it = conn->projections.find(base);
+	if (proj_it == conn->projections.end()) {
+		return;
+	}
+
+	auto &topic_projections = topic_projections_[conn->encoding];
+	auto topic_proj_it = topic_projections.find(base);
+	if (topic_proj_it != topic_projections.end()) {
+		auto cnt_it = topic_proj_it->second.find(proj_it->second);
+		if (cnt_it != topic_proj_it->second.end() && --cnt_it->second == 0) {
+			topic_proj_it->second.erase(cnt_it);
+			if (topic_proj_it->second.empty()) {
+				topic_projections.erase(topic_proj_it);
+			}
+		}
+	}
+	conn->projections.erase(proj_it);
+}
+
+
+}
\ No newline at end of file
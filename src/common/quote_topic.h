@@ -0,0 +1,252 @@
+#ifndef BABELTRADER_QUOTE_TOPIC_H_
+#define BABELTRADER_QUOTE_TOPIC_H_
+
+#include <map>
+#include <set>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "uWS/uWS.h"
+
+#include "common/common_struct.h"
+#include "common/quote_compress.h"
+#include "common/quote_projection.h"
+#include "common/ws_conn_table.h"
+
+namespace babeltrader
+{
+
+enum QuoteEncodingEnum
+{
+	QuoteEncoding_Json = 0,
+	QuoteEncoding_Binary,		// see quote_binary.h
+	QuoteEncoding_JsonDelta,	// marketdata as delta, see quote_delta.h
+	QuoteEncoding_BinaryDelta,
+	QuoteEncoding_Max,
+};
+
+extern const char *g_quote_encoding[QuoteEncoding_Max];
+
+inline bool IsBinaryEncoding(int encoding)
+{
+	return encoding == QuoteEncoding_Binary || encoding == QuoteEncoding_BinaryDelta;
+}
+inline bool IsDeltaEncoding(int encoding)
+{
+	return encoding == QuoteEncoding_JsonDelta || encoding == QuoteEncoding_BinaryDelta;
+}
+
+// topic of a quote: symbol + contract + info1, e.g. rb1901.marketdata
+std::string QuoteTopicKey(const char *symbol, const char *contract, int info1);
+std::string QuoteTopicKey(const Quote &quote);
+
+// delivery policy of a subscribed topic, only marketdata and orderbook use it
+struct QuoteTopicPolicy
+{
+	QuoteTopicPolicy()
+		: max_rate(0)
+		, conflate(false)
+	{}
+
+	int max_rate;	// max updates per second, 0 means no limit
+	bool conflate;	// keep only the newest update while the socket is busy
+};
+
+struct QuoteSubTopic
+{
+	QuoteSubTopic()
+		: projection(0)
+		, info1(0)
+		, snapshot(false)
+		, resume(false)
+		, seq(0)
+	{}
+
+	std::string topic;
+	QuoteTopicPolicy policy;
+	uint32_t projection;	// QuoteProjection id, 0 for full records
+
+	std::string symbol;
+	std::string contract;
+	int info1;
+
+	// catch up before the live stream, newest quotes of the topic, or quotes after seq
+	bool snapshot;
+	bool resume;
+	uint64_t seq;
+};
+
+// last value slot of a throttled or conflated topic
+struct QuoteSlot
+{
+	QuoteTopicPolicy policy;
+	int64_t next_ms;		// earliest time the next update may go out
+	std::string pending;	// newest framed message not sent yet
+};
+
+// send side state of a connection, it is shared with uWS send callbacks,
+// so it lives until the connection is gone and no frame refers to it
+struct QuoteConnFlow
+{
+	QuoteConnFlow()
+		: refs(1)
+		, pending_frames(0)
+		, pending_bytes(0)
+		, peak_bytes(0)
+		, sent_frames(0)
+	{}
+
+	void Retain();
+	void Release();
+
+	// every Sent() must match one OnSent(), uWS completes frames of a socket in order
+	void Sent(uint32_t bytes);
+	void OnSent();
+
+	std::atomic<int> refs;
+	std::atomic<int64_t> pending_frames;
+	std::atomic<int64_t> pending_bytes;
+	std::atomic<int64_t> peak_bytes;
+	std::atomic<uint64_t> sent_frames;
+
+	std::mutex mtx;
+	std::deque<uint32_t> pending_sizes;
+};
+
+// deflate stream of a connection. senders compress a frame and put it into the
+// outbox under mtx, after index unlocked, so frames leave in the order of the
+// deflate window. shared with senders, it may outlive the connection
+struct QuoteConnDeflate
+{
+	explicit QuoteConnDeflate(int level)
+		: deflate(new QuoteDeflate(level))
+		, ok(true)
+		, frames(0)
+		, in_bytes(0)
+		, out_bytes(0)
+		, us(0)
+	{}
+
+	std::mutex mtx;
+	std::unique_ptr<QuoteDeflate> deflate;
+
+	// read by stats without mtx
+	std::atomic<bool> ok;		// false once the stream broke, frames go out raw
+	std::atomic<uint64_t> frames;
+	std::atomic<uint64_t> in_bytes;
+	std::atomic<uint64_t> out_bytes;
+	std::atomic<uint64_t> us;
+};
+
+struct QuoteConn
+{
+	WsConnHandle handle;
+	int hub;			// frames go through the outbox of this hub
+	std::string addr;
+	int encoding;
+	int batch_policy;		// index of policy in QuoteService
+	bool sub_all;
+	std::set<std::string> topics;		// projected subscriptions are kept with projected topic key
+	std::map<std::string, uint32_t> projections;	// topic -> projection of projected subscriptions
+	std::map<std::string, QuoteSlot> slots;
+	QuoteConnFlow *flow;
+	uint32_t instruments_sent;	// binary only, instrument records of ids up to it were sent
+
+	// slow consumer
+	bool slow;
+	uint64_t slow_times;
+	uint64_t drop_frames;		// frames dropped since it became slow
+	uint64_t total_drop_frames;
+	std::map<std::string, std::string> conflated;	// newest update per topic while slow
+
+	// per connection deflate, null if client didn't ask for it
+	std::shared_ptr<QuoteConnDeflate> deflate;
+};
+
+struct QuoteConnStats
+{
+	std::string addr;
+	int encoding;
+	std::string batch;
+	bool sub_all;
+	int topics;
+	int64_t pending_frames;
+	int64_t pending_bytes;
+	int64_t peak_bytes;
+	uint64_t sent_frames;
+	uint64_t drop_frames;
+	uint64_t slow_times;
+	bool slow;
+	bool compress;
+	uint64_t compress_frames;
+	uint64_t compress_in_bytes;
+	uint64_t compress_out_bytes;
+	uint64_t compress_us;
+};
+
+// connection -> topics index for quote fan-out, keyed by connection handle.
+// a new connection receives every quote until it sends its first sub.
+// requests of a connection that already closed are ignored, a handle is never reused
+class QuoteTopicIndex
+{
+public:
+	QuoteTopicIndex();
+
+	// fn runs with index locked right after the connection is added
+	void AddConn(WsConnHandle handle, uWS::WebSocket<uWS::SERVER> *ws, int encoding, int batch_policy, const std::function<void(QuoteConn*)> &fn);
+	void DelConn(WsConnHandle handle);
+
+	// a topic has one projection per connection, sub again replaces it.
+	// projection only applies to json connections, others always get full records
+	void Sub(WsConnHandle handle, const std::string &topic, const QuoteTopicPolicy &policy, uint32_t projection = 0);
+	void Unsub(WsConnHandle handle, const std::string &topic);
+	void SubAll(WsConnHandle handle);
+	void UnsubAll(WsConnHandle handle);
+
+	// run fn under index lock if the connection is known
+	void WithConn(WsConnHandle handle, const std::function<void(QuoteConn*)> &fn);
+
+	bool HasConn(int encoding);
+	bool HasConn(int encoding, int batch_policy);
+	bool HasTopicSubscriber(int encoding);
+
+	// projections subscribed of the topic, besides the full record
+	void GetProjections(int encoding, const std::string &topic, std::vector<uint32_t> &projections);
+
+	// callbacks run with index locked, connections can't go away in the middle
+	void ForEachSubAll(int encoding, const std::function<void(QuoteConn*)> &fn);
+	void ForEachSubscriber(int encoding, const std::string &topic, const std::function<void(QuoteConn*)> &fn);
+	void ForEachSlotConn(const std::function<void(QuoteConn*)> &fn);
+	void ForEachSlowConn(const std::function<void(QuoteConn*)> &fn);
+	void ForEachConn(const std::function<void(QuoteConn*)> &fn);
+
+	// only inside ForEach callbacks, the index is locked already
+	void SetSlow(QuoteConn *conn, bool slow);
+
+	bool HasSlowConn();
+
+private:
+	QuoteConn* FindConn(WsConnHandle handle);
+	void DelTopic(QuoteConn *conn, const std::string &topic);
+
+private:
+	std::mutex mtx_;
+	std::map<WsConnHandle, QuoteConn> conns_;
+	int conn_cnt_[QuoteEncoding_Max];
+	std::map<int, int> policy_conn_cnt_[QuoteEncoding_Max];
+	std::set<QuoteConn*> sub_all_[QuoteEncoding_Max];
+	std::map<std::string, std::set<QuoteConn*>> topic_conns_[QuoteEncoding_Max];
+	std::map<std::string, std::map<uint32_t, int>> topic_projections_[QuoteEncoding_Max];	// topic -> projection -> subscribers
+	std::set<QuoteConn*> slot_conns_;
+	std::set<QuoteConn*> slow_conns_;
+};
+
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+#include "serialize_buffer.h"
+
+#include <atomic>
+
+namespace babeltrader
+{
+
+const char *g_serialize_buffers[SerializeBuffer_Max] = {
+	"quote_delta",
+	"quote_rsp",
+	"trade_msg",
+};
+
+struct SerializeBuffer::Slot
+{
+	Slot()
+		: writer(s)
+		, busy(false)
+		, created(false)
+		, high_water(0)
+	{}
+
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> writer;
+	bool busy;
+	bool created;
+	size_t high_water;
+};
+
+struct SerializeBufferCounter
+{
+	std::atomic<int64_t> threads;
+	std::atomic<int64_t> uses;
+	std::atomic<int64_t> nested;
+	std::atomic<int64_t> grows;
+	std::atomic<int64_t> shrinks;
+	std::atomic<int64_t> high_water;
+};
+
+static SerializeBufferCounter s_counters[SerializeBuffer_Max];
+
+SerializeBuffer::SerializeBuffer(int kind)
+	: slot_(nullptr)
+	, kind_(kind)
+{
+	static thread_local Slot slots[SerializeBuffer_Max];
+
+	SerializeBufferCounter &counter = s_counters[kind_];
+	slot_ = &slots[kind_];
+	if (slot_->busy) {
+		// serializer of the same kind called inside another, can't share
+		owned_.reset(new Slot());
+		slot_ = owned_.get();
+		counter.nested.fetch_add(1, std::memory_order_relaxed);
+	} else if (!slot_->created) {
+		slot_->created = true;
+		counter.threads.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	slot_->busy = true;
+	slot_->s.Clear();
+	slot_->writer.Reset(slot_->s);
+}
+SerializeBuffer::~SerializeBuffer()
+{
+	SerializeBufferCounter &counter = s_counters[kind_];
+	size_t size = slot_->s.GetSize();
+
+	counter.uses.fetch_add(1, std::memory_order_relaxed);
+	if (size > slot_->high_water) {
+		slot_->high_water = size;
+		counter.grows.fetch_add(1, std::memory_order_relaxed);
+
+		int64_t cur = counter.high_water.load(std::memory_order_relaxed);
+		while ((int64_t)size > cur && !counter.high_water.compare_exchange_weak(cur, (int64_t)size, std::memory_order_relaxed)) {}
+	}
+
+	// one huge query response should not pin its memory for the thread's lifetime
+	if (size > SERIALIZE_BUFFER_KEEP_MAX) {
+		slot_->s.Clear();
+		slot_->s.ShrinkToFit();
+		slot_->high_water = 0;
+		counter.shrinks.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	slot_->busy = false;
+}
+
+rapidjson::Writer<rapidjson::StringBuffer>& SerializeBuffer::Writer()
+{
+	return slot_->writer;
+}
+const char* SerializeBuffer::GetString() const
+{
+	return slot_->s.GetString();
+}
+size_t SerializeBuffer::GetLength() const
+{
+	return slot_->s.GetLength();
+}
+
+void SerializeBuffer::GetStats(std::vector<SerializeBufferStats> &stats)
+{
+	stats.clear();
+	for (int i = 0; i < SerializeBuffer_Max; i++) {
+		SerializeBufferCounter &counter = s_counters[i];
+
+		SerializeBufferStats stat;
+		stat.name = g_serialize_buffers[i];
+		stat.threads = counter.threads.load(std::memory_order_relaxed);
+		stat.uses = counter.uses.load(std::memory_order_relaxed);
+		stat.nested = counter.nested.load(std::memory_order_relaxed);
+		stat.grows = counter.grows.load(std::memory_order_relaxed);
+		stat.shrinks = counter.shrinks.load(std::memory_order_relaxed);
+		stat.high_water = counter.high_water.load(std::memory_order_relaxed);
+		stats.push_back(stat);
+	}
+}
+
+
+}
@@ -0,0 +1,72 @@
+#ifndef BABELTRADER_SERIALIZE_BUFFER_H_
+#define BABELTRADER_SERIALIZE_BUFFER_H_
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
+
+namespace babeltrader
+{
+
+enum SerializeBufferEnum
+{
+	SerializeBuffer_QuoteDelta = 0,
+	SerializeBuffer_QuoteRsp,
+	SerializeBuffer_TradeMsg,
+	SerializeBuffer_Max,
+};
+
+extern const char *g_serialize_buffers[SerializeBuffer_Max];
+
+// buffer bigger than this after a message is given back to the heap
+#define SERIALIZE_BUFFER_KEEP_MAX (4 * 1024 * 1024)
+
+struct SerializeBufferStats
+{
+	std::string name;
+	int64_t threads;		// thread local buffers created
+	int64_t uses;
+	int64_t nested;			// uses that found the thread's buffer busy and fell back to heap
+	int64_t grows;			// uses bigger than anything the thread's buffer held before
+	int64_t shrinks;		// buffers given back after an oversized message
+	int64_t high_water;		// biggest message in bytes
+};
+
+// thread local StringBuffer and Writer, cleared and reused by every serialization
+// of the same kind in the thread, so the send path stops allocating once every
+// buffer has reached its working size. usage:
+//     SerializeBuffer buf(SerializeBuffer_TradeMsg);
+//     auto &writer = buf.Writer();
+//     ...
+//     send(buf.GetString(), buf.GetLength());
+class SerializeBuffer
+{
+public:
+	explicit SerializeBuffer(int kind);
+	~SerializeBuffer();
+
+	SerializeBuffer(const SerializeBuffer&) = delete;
+	SerializeBuffer& operator=(const SerializeBuffer&) = delete;
+
+	rapidjson::Writer<rapidjson::StringBuffer>& Writer();
+	const char* GetString() const;
+	size_t GetLength() const;
+
+	static void GetStats(std::vector<SerializeBufferStats> &stats);
+
+private:
+	struct Slot;
+
+	Slot *slot_;
+	std::unique_ptr<Slot> owned_;
+	int kind_;
+};
+
+
+}
+
+#endif
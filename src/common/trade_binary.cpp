@@ -0,0 +1,217 @@
+#include "trade_binary.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "err.h"
+
+namespace babeltrader
+{
+
+
+const char *g_trade_bin_msg[TradeBinMsg_Max] = {
+	"",
+	"insert_order",
+	"cancel_order",
+	"confirmorder",
+	"orderstatus",
+	"orderdeal",
+	"error"
+};
+
+static int64_t ToFixed(double v)
+{
+	if (!isfinite(v)) {
+		return 0;
+	}
+	return (int64_t)llround(v * TRADE_BIN_PRICE_SCALE);
+}
+static double FromFixed(int64_t v)
+{
+	return (double)v / TRADE_BIN_PRICE_SCALE;
+}
+
+// too long strings are cut, keep a zero at end so client can read it as c string
+static void CopyStr(char *dst, size_t size, const std::string &src)
+{
+	size_t len = src.size() < size - 1 ? src.size() : size - 1;
+	memcpy(dst, src.data(), len);
+	memset(dst + len, 0, size - len);
+}
+static void AssignStr(std::string &dst, const char *src, size_t size)
+{
+	const char *end = (const char*)memchr(src, 0, size);
+	dst.assign(src, end ? end - src : size);
+}
+static void AssignEnum(std::string &dst, const char **names, int max, uint8_t v)
+{
+	if (v < max) {
+		dst.assign(names[v]);
+	}
+	else {
+		dst.clear();
+	}
+}
+
+// dir is an action, or action_dir for gateways with positions, e.g. "closetoday_short"
+static void EncodeDir(const std::string &dir, uint8_t &action, uint8_t &position_dir)
+{
+	size_t pos = dir.find('_');
+	if (pos == std::string::npos) {
+		action = (uint8_t)getOrderActionEnum(dir.c_str());
+		position_dir = OrderDir_Unknown;
+		return;
+	}
+
+	char buf[32];
+	if (pos >= sizeof(buf)) {
+		action = OrderAction_Unknown;
+		position_dir = OrderDir_Unknown;
+		return;
+	}
+	memcpy(buf, dir.data(), pos);
+	buf[pos] = '\0';
+	action = (uint8_t)getOrderActionEnum(buf);
+	position_dir = (uint8_t)getOrderDirEnum(dir.c_str() + pos + 1);
+}
+static void DecodeDir(uint8_t action, uint8_t position_dir, std::string &dir)
+{
+	AssignEnum(dir, g_order_action, OrderAction_Max, action);
+	if (!dir.empty() && (position_dir == OrderDir_Long || position_dir == OrderDir_Short)) {
+		dir.append(1, '_');
+		dir.append(g_order_dir[position_dir]);
+	}
+}
+
+static void AppendHead(std::string &out, uint8_t msg_type, int error_id, size_t body_len)
+{
+	TradeBinHead head;
+	head.magic = TRADE_BIN_MAGIC;
+	head.version = TRADE_BIN_VERSION;
+	head.msg_type = msg_type;
+	head.len = (uint32_t)(sizeof(head) + body_len);
+	head.error_id = error_id;
+	head.reserved = 0;
+	out.append((const char*)&head, sizeof(head));
+}
+static void AppendOrder(std::string &out, const Order &order)
+{
+	TradeBinOrder bin;
+	CopyStr(bin.user_id, sizeof(bin.user_id), order.user_id);
+	CopyStr(bin.order_id, sizeof(bin.order_id), order.order_id);
+	CopyStr(bin.outside_user_id, sizeof(bin.outside_user_id), order.outside_user_id);
+	CopyStr(bin.outside_id, sizeof(bin.outside_id), order.outside_id);
+	CopyStr(bin.client_order_id, sizeof(bin.client_order_id), order.client_order_id);
+	CopyStr(bin.symbol, sizeof(bin.symbol), order.symbol);
+	CopyStr(bin.contract, sizeof(bin.contract), order.contract);
+	CopyStr(bin.contract_id, sizeof(bin.contract_id), order.contract_id);
+	bin.market = (uint8_t)getMarketEnum(order.market.c_str());
+	bin.exchange = (uint8_t)getExchangeEnum(order.exchange.c_str());
+	bin.type = (uint8_t)getProductTypeEnum(order.type.c_str());
+	bin.order_type = (uint8_t)getOrderTypeEnum(order.order_type.c_str());
+	bin.order_flag1 = (uint8_t)getOrderFlag1Enum(order.order_flag1.c_str());
+	EncodeDir(order.dir, bin.dir, bin.position_dir);
+	bin.reserved = 0;
+	bin.price = ToFixed(order.price);
+	bin.amount = (int64_t)order.amount;
+	bin.total_price = ToFixed(order.total_price);
+	bin.ts = order.ts;
+	out.append((const char*)&bin, sizeof(bin));
+}
+static void DecodeOrder(const TradeBinOrder &bin, Order &order)
+{
+	AssignStr(order.user_id, bin.user_id, sizeof(bin.user_id));
+	AssignStr(order.order_id, bin.order_id, sizeof(bin.order_id));
+	AssignStr(order.outside_user_id, bin.outside_user_id, sizeof(bin.outside_user_id));
+	AssignStr(order.outside_id, bin.outside_id, sizeof(bin.outside_id));
+	AssignStr(order.client_order_id, bin.client_order_id, sizeof(bin.client_order_id));
+	AssignStr(order.symbol, bin.symbol, sizeof(bin.symbol));
+	AssignStr(order.contract, bin.contract, sizeof(bin.contract));
+	AssignStr(order.contract_id, bin.contract_id, sizeof(bin.contract_id));
+	AssignEnum(order.market, g_markets, Market_Max, bin.market);
+	AssignEnum(order.exchange, g_exchanges, Exchange_Max, bin.exchange);
+	AssignEnum(order.type, g_product_types, ProductType_Max, bin.type);
+	AssignEnum(order.order_type, g_order_type, OrderType_Max, bin.order_type);
+	AssignEnum(order.order_flag1, g_order_flag1, OrderFlag1_Max, bin.order_flag1);
+	DecodeDir(bin.dir, bin.position_dir, order.dir);
+	order.price = FromFixed(bin.price);
+	order.amount = (double)bin.amount;
+	order.total_price = FromFixed(bin.total_price);
+	order.ts = bin.ts;
+}
+
+int TradeBinParseRequest(const char *data, size_t len, uint8_t &msg_type, Order &order)
+{
+	TradeBinHead head;
+	if (len < sizeof(head)) {
+		return BABELTRADER_ERR_WSREQ_FAILED_PARSE;
+	}
+	memcpy(&head, data, sizeof(head));
+
+	if (head.magic != TRADE_BIN_MAGIC || head.version != TRADE_BIN_VERSION || head.len != len) {
+		return BABELTRADER_ERR_WSREQ_FAILED_PARSE;
+	}
+
+	msg_type = head.msg_type;
+	if (msg_type != TradeBinMsg_InsertOrder && msg_type != TradeBinMsg_CancelOrder) {
+		return BABELTRADER_ERR_WSREQ_NOT_HANDLE;
+	}
+	if (len != sizeof(head) + sizeof(TradeBinOrder)) {
+		return BABELTRADER_ERR_WSREQ_FAILED_PARSE;
+	}
+
+	TradeBinOrder bin;
+	memcpy(&bin, data + sizeof(head), sizeof(bin));
+	DecodeOrder(bin, order);
+
+	return BABELTRADER_OK;
+}
+
+void TradeBinSerializeConfirmOrder(const Order &order, int error_id, std::string &out)
+{
+	AppendHead(out, TradeBinMsg_ConfirmOrder, error_id, sizeof(TradeBinOrder));
+	AppendOrder(out, order);
+}
+void TradeBinSerializeOrderStatus(const Order &order, const OrderStatusNotify &order_status, int error_id, std::string &out)
+{
+	TradeBinOrderStatus bin;
+	bin.order_status = (uint8_t)order_status.order_status;
+	bin.order_submit_status = (uint8_t)order_status.order_submit_status;
+	memset(bin.reserved, 0, sizeof(bin.reserved));
+	bin.amount = (int64_t)order_status.amount;
+	bin.dealed_amount = (int64_t)order_status.dealed_amount;
+
+	AppendHead(out, TradeBinMsg_OrderStatus, error_id, sizeof(bin) + sizeof(TradeBinOrder));
+	out.append((const char*)&bin, sizeof(bin));
+	AppendOrder(out, order);
+}
+void TradeBinSerializeOrderDeal(const Order &order, const OrderDealNotify &order_deal, std::string &out)
+{
+	TradeBinOrderDeal bin;
+	bin.price = ToFixed(order_deal.price);
+	bin.amount = (int64_t)order_deal.amount;
+	bin.ts = order_deal.ts;
+	CopyStr(bin.trading_day, sizeof(bin.trading_day), order_deal.trading_day);
+	CopyStr(bin.trade_id, sizeof(bin.trade_id), order_deal.trade_id);
+
+	AppendHead(out, TradeBinMsg_OrderDeal, 0, sizeof(bin) + sizeof(TradeBinOrder));
+	out.append((const char*)&bin, sizeof(bin));
+	AppendOrder(out, order);
+}
+void TradeBinSerializeError(uint8_t req_msg_type, int error_id, const char *error_msg, const Order *order, std::string &out)
+{
+	TradeBinError bin;
+	bin.req_msg_type = req_msg_type;
+	memset(bin.reserved, 0, sizeof(bin.reserved));
+	memset(bin.error_msg, 0, sizeof(bin.error_msg));
+	strncpy(bin.error_msg, error_msg, sizeof(bin.error_msg) - 1);
+
+	AppendHead(out, TradeBinMsg_Error, error_id, sizeof(bin) + (order ? sizeof(TradeBinOrder) : 0));
+	out.append((const char*)&bin, sizeof(bin));
+	if (order) {
+		AppendOrder(out, *order);
+	}
+}
+
+
+}
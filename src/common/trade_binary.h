@@ -0,0 +1,121 @@
+#ifndef BABELTRADER_TRADE_BINARY_H_
+#define BABELTRADER_TRADE_BINARY_H_
+
+#include <stdint.h>
+#include <string>
+
+#include "common/common_struct.h"
+
+namespace babeltrader
+{
+
+// binary order entry protocol, served on /ws/order of trade gateways
+//
+// every websocket binary message is one message: head + body.
+// all integers are little endian, structs are packed, strings are zero padded.
+// enums are the numeric values of enum.h, prices are fixed point int64 of
+// price * TRADE_BIN_PRICE_SCALE, amounts are int64 like the json protocol
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "binary trade protocol only support little endian host"
+#endif
+
+#define TRADE_BIN_MAGIC 0x5442		// "BT"
+#define TRADE_BIN_VERSION 1
+#define TRADE_BIN_PRICE_SCALE 100000000LL
+
+#define TRADE_BIN_USER_LEN 32
+#define TRADE_BIN_ID_LEN 64
+#define TRADE_BIN_SYMBOL_LEN 32
+#define TRADE_BIN_DAY_LEN 16
+#define TRADE_BIN_ERROR_MSG_LEN 128
+
+enum TradeBinMsgEnum
+{
+	TradeBinMsg_Unknown = 0,
+	TradeBinMsg_InsertOrder,	// request, body: order
+	TradeBinMsg_CancelOrder,	// request, body: order
+	TradeBinMsg_ConfirmOrder,	// push, body: order
+	TradeBinMsg_OrderStatus,	// push, body: order status + order
+	TradeBinMsg_OrderDeal,		// push, body: order deal + order
+	TradeBinMsg_Error,			// response, body: error + order of the request if it was decoded
+	TradeBinMsg_Max,
+};
+extern const char *g_trade_bin_msg[TradeBinMsg_Max];
+
+#pragma pack(push, 1)
+
+struct TradeBinHead
+{
+	uint16_t magic;
+	uint8_t version;
+	uint8_t msg_type;		// TradeBinMsgEnum
+	uint32_t len;			// bytes of message, include this head
+	int32_t error_id;
+	uint32_t reserved;
+};
+
+struct TradeBinOrder
+{
+	char user_id[TRADE_BIN_USER_LEN];
+	char order_id[TRADE_BIN_ID_LEN];
+	char outside_user_id[TRADE_BIN_USER_LEN];
+	char outside_id[TRADE_BIN_ID_LEN];
+	char client_order_id[TRADE_BIN_ID_LEN];
+	char symbol[TRADE_BIN_SYMBOL_LEN];
+	char contract[TRADE_BIN_SYMBOL_LEN];
+	char contract_id[TRADE_BIN_SYMBOL_LEN];
+	uint8_t market;			// MarketEnum
+	uint8_t exchange;		// ExchangeEnum
+	uint8_t type;			// ProductTypeEnum
+	uint8_t order_type;		// OrderTypeEnum
+	uint8_t order_flag1;	// OrderFlag1Enum
+	uint8_t dir;			// OrderActionEnum
+	uint8_t position_dir;	// OrderDirEnum, long/short make a combined dir like "open_long"
+	uint8_t reserved;
+	int64_t price;
+	int64_t amount;
+	int64_t total_price;
+	int64_t ts;
+};
+
+struct TradeBinOrderStatus
+{
+	uint8_t order_status;			// OrderStatusEnum
+	uint8_t order_submit_status;	// OrderSubmitStatusEnum
+	uint8_t reserved[6];
+	int64_t amount;
+	int64_t dealed_amount;
+};
+
+struct TradeBinOrderDeal
+{
+	int64_t price;
+	int64_t amount;
+	int64_t ts;
+	char trading_day[TRADE_BIN_DAY_LEN];
+	char trade_id[TRADE_BIN_ID_LEN];
+};
+
+struct TradeBinError
+{
+	uint8_t req_msg_type;	// TradeBinMsgEnum of the request
+	uint8_t reserved[7];
+	char error_msg[TRADE_BIN_ERROR_MSG_LEN];
+};
+
+#pragma pack(pop)
+
+// decode an insert/cancel request into order, return BABELTRADER_OK or error id
+int TradeBinParseRequest(const char *data, size_t len, uint8_t &msg_type, Order &order);
+
+// append a message to out
+void TradeBinSerializeConfirmOrder(const Order &order, int error_id, std::string &out);
+void TradeBinSerializeOrderStatus(const Order &order, const OrderStatusNotify &order_status, int error_id, std::string &out);
+void TradeBinSerializeOrderDeal(const Order &order, const OrderDealNotify &order_deal, std::string &out);
+void TradeBinSerializeError(uint8_t req_msg_type, int error_id, const char *error_msg, const Order *order, std::string &out);
+
+
+}
+
+#endif
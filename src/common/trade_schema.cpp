@@ -0,0 +1,240 @@
+#include "trade_schema.h"
+
+namespace babeltrader
+{
+
+
+static constexpr JsonField<Order> s_order_fields[] = {
+	JSON_FIELD(Order, user_id, JsonFieldType_String),
+	JSON_FIELD(Order, order_id, JsonFieldType_String),
+	JSON_FIELD_FLAGS(Order, outside_user_id, JsonFieldType_String, JsonFieldFlag_NoDecode),
+	JSON_FIELD(Order, outside_id, JsonFieldType_String),
+	JSON_FIELD(Order, client_order_id, JsonFieldType_String),
+	JSON_FIELD(Order, market, JsonFieldType_String),
+	JSON_FIELD(Order, exchange, JsonFieldType_String),
+	JSON_FIELD(Order, type, JsonFieldType_String),
+	JSON_FIELD(Order, symbol, JsonFieldType_String),
+	JSON_FIELD(Order, contract, JsonFieldType_String),
+	JSON_FIELD(Order, contract_id, JsonFieldType_String),
+	JSON_FIELD(Order, order_type, JsonFieldType_String),
+	JSON_FIELD(Order, order_flag1, JsonFieldType_String),
+	JSON_FIELD(Order, dir, JsonFieldType_String),
+	JSON_FIELD(Order, price, JsonFieldType_Price),
+	JSON_FIELD(Order, amount, JsonFieldType_DoubleAsInt),
+	JSON_FIELD(Order, total_price, JsonFieldType_Double),
+	JSON_FIELD(Order, ts, JsonFieldType_Int64AsDouble),
+};
+const JsonSchema<Order> g_order_schema(s_order_fields);
+
+static constexpr JsonField<OrderDealNotify> s_order_deal_notify_fields[] = {
+	JSON_FIELD(OrderDealNotify, price, JsonFieldType_Price),
+	JSON_FIELD(OrderDealNotify, amount, JsonFieldType_DoubleAsInt),
+	JSON_FIELD(OrderDealNotify, trading_day, JsonFieldType_String),
+	JSON_FIELD(OrderDealNotify, trade_id, JsonFieldType_String),
+	JSON_FIELD(OrderDealNotify, ts, JsonFieldType_Int64),
+};
+const JsonSchema<OrderDealNotify> g_order_deal_notify_schema(s_order_deal_notify_fields);
+
+static constexpr JsonField<OrderQuery> s_order_query_fields[] = {
+	JSON_FIELD(OrderQuery, qry_id, JsonFieldType_String),
+	JSON_FIELD(OrderQuery, user_id, JsonFieldType_String),
+	JSON_FIELD(OrderQuery, outside_id, JsonFieldType_String),
+	JSON_FIELD(OrderQuery, market, JsonFieldType_String),
+	JSON_FIELD(OrderQuery, exchange, JsonFieldType_String),
+	JSON_FIELD(OrderQuery, type, JsonFieldType_String),
+	JSON_FIELD(OrderQuery, symbol, JsonFieldType_String),
+	JSON_FIELD(OrderQuery, contract, JsonFieldType_String),
+	JSON_FIELD(OrderQuery, contract_id, JsonFieldType_String),
+};
+const JsonSchema<OrderQuery> g_order_query_schema(s_order_query_fields);
+
+static constexpr JsonField<TradeQuery> s_trade_query_fields[] = {
+	JSON_FIELD(TradeQuery, qry_id, JsonFieldType_String),
+	JSON_FIELD(TradeQuery, user_id, JsonFieldType_String),
+	JSON_FIELD(TradeQuery, trade_id, JsonFieldType_String),
+	JSON_FIELD(TradeQuery, market, JsonFieldType_String),
+	JSON_FIELD(TradeQuery, exchange, JsonFieldType_String),
+	JSON_FIELD(TradeQuery, type, JsonFieldType_String),
+	JSON_FIELD(TradeQuery, symbol, JsonFieldType_String),
+	JSON_FIELD(TradeQuery, contract, JsonFieldType_String),
+	JSON_FIELD(TradeQuery, contract_id, JsonFieldType_String),
+};
+const JsonSchema<TradeQuery> g_trade_query_schema(s_trade_query_fields);
+
+static constexpr JsonField<PositionQuery> s_position_query_fields[] = {
+	JSON_FIELD(PositionQuery, qry_id, JsonFieldType_String),
+	JSON_FIELD(PositionQuery, user_id, JsonFieldType_String),
+	JSON_FIELD(PositionQuery, market, JsonFieldType_String),
+	JSON_FIELD(PositionQuery, exchange, JsonFieldType_String),
+	JSON_FIELD(PositionQuery, type, JsonFieldType_String),
+	JSON_FIELD(PositionQuery, symbol, JsonFieldType_String),
+	JSON_FIELD(PositionQuery, contract, JsonFieldType_String),
+	JSON_FIELD(PositionQuery, contract_id, JsonFieldType_String),
+};
+const JsonSchema<PositionQuery> g_position_query_schema(s_position_query_fields);
+
+static constexpr JsonField<TradeAccountQuery> s_trade_account_query_fields[] = {
+	JSON_FIELD(TradeAccountQuery, qry_id, JsonFieldType_String),
+	JSON_FIELD_FLAGS(TradeAccountQuery, user_id, JsonFieldType_String, JsonFieldFlag_NoDecode),
+	JSON_FIELD(TradeAccountQuery, market, JsonFieldType_String),
+	JSON_FIELD(TradeAccountQuery, currency_id, JsonFieldType_String),
+};
+const JsonSchema<TradeAccountQuery> g_trade_account_query_schema(s_trade_account_query_fields);
+
+static constexpr JsonField<ProductQuery> s_product_query_fields[] = {
+	JSON_FIELD(ProductQuery, qry_id, JsonFieldType_String),
+	JSON_FIELD(ProductQuery, market, JsonFieldType_String),
+	JSON_FIELD(ProductQuery, exchange, JsonFieldType_String),
+	JSON_FIELD(ProductQuery, symbol, JsonFieldType_String),
+	JSON_FIELD(ProductQuery, contract, JsonFieldType_String),
+};
+const JsonSchema<ProductQuery> g_product_query_schema(s_product_query_fields);
+
+static constexpr JsonField<PositionSummaryType1> s_position_summary_type1_fields[] = {
+	JSON_FIELD(PositionSummaryType1, market, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, outside_user_id, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, exchange, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, type, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, symbol, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, contract, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, contract_id, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, dir, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, order_flag1, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, date_type, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, amount, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, closed_amount, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, today_amount, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, margin, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, margin_rate_by_money, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, margin_rate_by_vol, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, long_frozen, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, short_frozen, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, frozen_margin, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, trading_day, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType1, pre_settlement_price, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, settlement_price, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, open_cost, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, position_cost, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, position_profit, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, close_profit_by_date, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType1, close_profit_by_trade, JsonFieldType_Double),
+};
+const JsonSchema<PositionSummaryType1> g_position_summary_type1_schema(s_position_summary_type1_fields);
+
+static constexpr JsonField<PositionDetailType1> s_position_detail_type1_fields[] = {
+	JSON_FIELD(PositionDetailType1, market, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, outside_user_id, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, exchange, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, type, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, symbol, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, contract, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, contract_id, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, dir, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, order_flag1, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, open_date, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, trading_day, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, trade_id, JsonFieldType_String),
+	JSON_FIELD(PositionDetailType1, amount, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, closed_amount, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, closed_money, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, pre_settlement_price, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, settlement_price, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, open_price, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, margin, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, margin_rate_by_money, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, margin_rate_by_vol, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, close_profit_by_date, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, close_profit_by_trade, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, position_profit_by_date, JsonFieldType_Double),
+	JSON_FIELD(PositionDetailType1, position_profit_by_trade, JsonFieldType_Double),
+};
+const JsonSchema<PositionDetailType1> g_position_detail_type1_schema(s_position_detail_type1_fields);
+
+static constexpr JsonField<TradeAccountType1> s_trade_account_type1_fields[] = {
+	JSON_FIELD(TradeAccountType1, market, JsonFieldType_String),
+	JSON_FIELD(TradeAccountType1, outside_user_id, JsonFieldType_String),
+	JSON_FIELD(TradeAccountType1, pre_credit, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, pre_balance, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, pre_margin, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, interest, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, deposit, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, withdraw, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, credit, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, margin, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, commission, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, close_profit, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, position_profit, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, frozen_margin, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, frozen_cash, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, frozen_commision, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, balance, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, available, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType1, currency_id, JsonFieldType_String),
+	JSON_FIELD(TradeAccountType1, trading_day, JsonFieldType_String),
+};
+const JsonSchema<TradeAccountType1> g_trade_account_type1_schema(s_trade_account_type1_fields);
+
+static constexpr JsonField<ProductType1> s_product_type1_fields[] = {
+	JSON_FIELD(ProductType1, market, JsonFieldType_String),
+	JSON_FIELD(ProductType1, outside_user_id, JsonFieldType_String),
+	JSON_FIELD(ProductType1, exchange, JsonFieldType_String),
+	JSON_FIELD(ProductType1, type, JsonFieldType_String),
+	JSON_FIELD(ProductType1, symbol, JsonFieldType_String),
+	JSON_FIELD(ProductType1, contract, JsonFieldType_String),
+	JSON_FIELD(ProductType1, contract_id, JsonFieldType_String),
+	JSON_FIELD(ProductType1, vol_multiple, JsonFieldType_Double),
+	JSON_FIELD(ProductType1, price_tick, JsonFieldType_Double),
+	JSON_FIELD(ProductType1, long_margin_ratio, JsonFieldType_Double),
+	JSON_FIELD(ProductType1, short_margin_ratio, JsonFieldType_Double),
+};
+const JsonSchema<ProductType1> g_product_type1_schema(s_product_type1_fields);
+
+static constexpr JsonField<PositionSummaryType2> s_position_summary_type2_fields[] = {
+	JSON_FIELD(PositionSummaryType2, market, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType2, outside_user_id, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType2, exchange, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType2, type, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType2, symbol, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType2, dir, JsonFieldType_String),
+	JSON_FIELD(PositionSummaryType2, amount, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType2, avaliable_amount, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType2, avg_price, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType2, unrealized_profit, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType2, purchase_redeemable_qty, JsonFieldType_Double),
+	JSON_FIELD(PositionSummaryType2, executable_option, JsonFieldType_Int64),
+	JSON_FIELD(PositionSummaryType2, lockable_position, JsonFieldType_Int64),
+	JSON_FIELD(PositionSummaryType2, executable_underlying, JsonFieldType_Int64),
+	JSON_FIELD(PositionSummaryType2, locked_position, JsonFieldType_Int64),
+	JSON_FIELD(PositionSummaryType2, usable_locked_position, JsonFieldType_Int64),
+};
+const JsonSchema<PositionSummaryType2> g_position_summary_type2_schema(s_position_summary_type2_fields);
+
+static constexpr JsonField<TradeAccountType2> s_trade_account_type2_fields[] = {
+	JSON_FIELD(TradeAccountType2, market, JsonFieldType_String),
+	JSON_FIELD(TradeAccountType2, outside_user_id, JsonFieldType_String),
+	JSON_FIELD(TradeAccountType2, account_type, JsonFieldType_String),
+	JSON_FIELD(TradeAccountType2, total_asset, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, available_cash, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, securities_asset, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, fund_buy_amount, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, fund_buy_fee, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, fund_sell_amount, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, fund_sell_fee, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, withholding_amount, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, frozen_margin, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, frozen_exec_cash, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, frozen_exec_fee, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, pay_later, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, preadva_pay, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, orig_banlance, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, banlance, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, deposit_withdraw, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, trade_netting, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, captial_asset, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, force_freeze_amount, JsonFieldType_Double),
+	JSON_FIELD(TradeAccountType2, preferred_amount, JsonFieldType_Double),
+};
+const JsonSchema<TradeAccountType2> g_trade_account_type2_schema(s_trade_account_type2_fields);
+
+
+}
@@ -0,0 +1,30 @@
+#ifndef BABELTRADER_TRADE_SCHEMA_H_
+#define BABELTRADER_TRADE_SCHEMA_H_
+
+#include "common/common_struct.h"
+#include "common/json_schema.h"
+
+namespace babeltrader
+{
+
+// field tables of the trade structs, drive the json converters and any other
+// encoding that wants to walk the members. field order is the wire order
+
+extern const JsonSchema<Order> g_order_schema;
+extern const JsonSchema<OrderDealNotify> g_order_deal_notify_schema;
+extern const JsonSchema<OrderQuery> g_order_query_schema;
+extern const JsonSchema<TradeQuery> g_trade_query_schema;
+extern const JsonSchema<PositionQuery> g_position_query_schema;
+extern const JsonSchema<TradeAccountQuery> g_trade_account_query_schema;
+extern const JsonSchema<ProductQuery> g_product_query_schema;
+extern const JsonSchema<PositionSummaryType1> g_position_summary_type1_schema;
+extern const JsonSchema<PositionDetailType1> g_position_detail_type1_schema;
+extern const JsonSchema<TradeAccountType1> g_trade_account_type1_schema;
+extern const JsonSchema<ProductType1> g_product_type1_schema;
+extern const JsonSchema<PositionSummaryType2> g_position_summary_type2_schema;
+extern const JsonSchema<TradeAccountType2> g_trade_account_type2_schema;
+
+
+}
+
+#endif
@@ -4,88 +4,98 @@
 
 #include "converter.h"
 #include "ws_service.h"
+#include "serialize_buffer.h"
+#include "trade_binary.h"
 
 namespace babeltrader
 {
 
-void TradeService::OnReqInsertOrder(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void TradeService::OnReqInsertOrder(WsConnHandle conn, rapidjson::Document &doc)
 {
 	if (!(doc.HasMember("data") && doc["data"].IsObject())) {
 		throw std::runtime_error("field \"data\" need object");
 	}
 
 	Order order = ConvertOrderJson2Common(doc["data"]);
-	this->InsertOrder(ws, order);
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	this->InsertOrder(conn, order);
 }
-void TradeService::OnReqCancelOrder(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void TradeService::OnReqCancelOrder(WsConnHandle conn, rapidjson::Document &doc)
 {
 	if (!(doc.HasMember("data") && doc["data"].IsObject())) {
 		throw std::runtime_error("field \"data\" need object");
 	}
 
 	Order order = ConvertOrderJson2Common(doc["data"]);
-	this->CancelOrder(ws, order);
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	this->CancelOrder(conn, order);
 }
-void TradeService::OnReqQueryOrder(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void TradeService::OnReqQueryOrder(WsConnHandle conn, rapidjson::Document &doc)
 {
 	if (!(doc.HasMember("data") && doc["data"].IsObject())) {
 		throw std::runtime_error("field \"data\" need object");
 	}
 
 	OrderQuery order_qry = ConvertOrderQueryJson2Common(doc["data"]);
-	this->QueryOrder(ws, order_qry);
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	this->QueryOrder(conn, order_qry);
 }
-void TradeService::OnReqQueryTrade(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void TradeService::OnReqQueryTrade(WsConnHandle conn, rapidjson::Document &doc)
 {
 	if (!(doc.HasMember("data") && doc["data"].IsObject())) {
 		throw std::runtime_error("field \"data\" need object");
 	}
 
 	TradeQuery trade_qry = ConvertTradeQueryJson2Common(doc["data"]);
-	this->QueryTrade(ws, trade_qry);
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	this->QueryTrade(conn, trade_qry);
 }
-void TradeService::OnReqQueryPosition(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void TradeService::OnReqQueryPosition(WsConnHandle conn, rapidjson::Document &doc)
 {
 	if (!(doc.HasMember("data") && doc["data"].IsObject())) {
 		throw std::runtime_error("field \"data\" need object");
 	}
 
 	PositionQuery position_qry = ConvertPositionQueryJson2Common(doc["data"]);
-	this->QueryPosition(ws, position_qry);
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	this->QueryPosition(conn, position_qry);
 }
-void TradeService::OnReqQueryPositionDetail(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void TradeService::OnReqQueryPositionDetail(WsConnHandle conn, rapidjson::Document &doc)
 {
 	if (!(doc.HasMember("data") && doc["data"].IsObject())) {
 		throw std::runtime_error("field \"data\" need object");
 	}
 
 	PositionQuery position_qry = ConvertPositionQueryJson2Common(doc["data"]);
-	this->QueryPositionDetail(ws, position_qry);
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	this->QueryPositionDetail(conn, position_qry);
 }
-void TradeService::OnReqQueryTradeAccount(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void TradeService::OnReqQueryTradeAccount(WsConnHandle conn, rapidjson::Document &doc)
 {
 	if (!(doc.HasMember("data") && doc["data"].IsObject())) {
 		throw std::runtime_error("field \"data\" need object");
 	}
 
 	TradeAccountQuery trade_account_qry = ConvertTradeAccountJson2Common(doc["data"]);
-	this->QueryTradeAccount(ws, trade_account_qry);
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	this->QueryTradeAccount(conn, trade_account_qry);
 }
-void TradeService::OnReqQueryProduct(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void TradeService::OnReqQueryProduct(WsConnHandle conn, rapidjson::Document &doc)
 {
 	if (!(doc.HasMember("data") && doc["data"].IsObject())) {
 		throw std::runtime_error("field \"data\" need object");
 	}
 
 	ProductQuery product_qry = ConvertProductQueryJson2Common(doc["data"]);
-	this->QueryProduct(ws, product_qry);
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	this->QueryProduct(conn, product_qry);
 }
 
 
 void TradeService::BroadcastConfirmOrder(Order &order, int error_id, const char *error_msg)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -96,21 +106,29 @@ void TradeService::BroadcastConfirmOrder(Order &order, int error_id, const char
 	// writer.Key("error_msg");
 	// writer.String(error_msg);
 
+	PriceTick tick = price_ticks_.Find(order.symbol, order.contract);
+
 	writer.Key("data");
 	writer.StartObject();
-	SerializeOrder(writer, order);
+	SerializeOrder(writer, order, &tick);
 	writer.EndObject();
 
 	writer.EndObject();
 
 	LOG(INFO) << s.GetString();
 
-	uws_hub_.getDefaultGroup<uWS::SERVER>().broadcast(s.GetString(), s.GetLength(), uWS::OpCode::TEXT);
+	// binary order clients get the same message in binary
+	static thread_local std::string bin;
+	bin.clear();
+	if (ws_service_->HasBinClients()) {
+		TradeBinSerializeConfirmOrder(order, error_id, bin);
+	}
+	BroadcastMsg(s.GetString(), s.GetLength(), bin);
 }
 void TradeService::BroadcastOrderStatus(Order &order, OrderStatusNotify &order_status_notify, int error_id, const char *error_msg)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -121,6 +139,8 @@ void TradeService::BroadcastOrderStatus(Order &order, OrderStatusNotify &order_s
 	// writer.Key("error_msg");
 	// writer.String(error_msg);
 
+	PriceTick tick = price_ticks_.Find(order.symbol, order.contract);
+
 	writer.Key("data");
 	writer.StartObject();
 
@@ -128,7 +148,7 @@ void TradeService::BroadcastOrderStatus(Order &order, OrderStatusNotify &order_s
 
 	writer.Key("order");
 	writer.StartObject();
-	SerializeOrder(writer, order);
+	SerializeOrder(writer, order, &tick);
 	writer.EndObject();  // order end
 
 	writer.EndObject();  // data end
@@ -136,12 +156,18 @@ void TradeService::BroadcastOrderStatus(Order &order, OrderStatusNotify &order_s
 
 	LOG(INFO) << s.GetString();
 
-	uws_hub_.getDefaultGroup<uWS::SERVER>().broadcast(s.GetString(), s.GetLength(), uWS::OpCode::TEXT);
+	// binary order clients get the same message in binary
+	static thread_local std::string bin;
+	bin.clear();
+	if (ws_service_->HasBinClients()) {
+		TradeBinSerializeOrderStatus(order, order_status_notify, error_id, bin);
+	}
+	BroadcastMsg(s.GetString(), s.GetLength(), bin);
 }
 void TradeService::BroadcastOrderDeal(Order &order, OrderDealNotify &order_deal)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -149,14 +175,16 @@ void TradeService::BroadcastOrderDeal(Order &order, OrderDealNotify &order_deal)
 	writer.Key("error_id");
 	writer.Int(0);
 
+	PriceTick tick = price_ticks_.Find(order.symbol, order.contract);
+
 	writer.Key("data");
 	writer.StartObject();
 
-	SerializeOrderDeal(writer, order_deal);
+	SerializeOrderDeal(writer, order_deal, &tick);
 
 	writer.Key("order");
 	writer.StartObject();
-	SerializeOrder(writer, order);
+	SerializeOrder(writer, order, &tick);
 	writer.EndObject();  // order end
 
 	writer.EndObject();  // data end
@@ -164,12 +192,22 @@ void TradeService::BroadcastOrderDeal(Order &order, OrderDealNotify &order_deal)
 
 	LOG(INFO) << s.GetString();
 
-	uws_hub_.getDefaultGroup<uWS::SERVER>().broadcast(s.GetString(), s.GetLength(), uWS::OpCode::TEXT);
+	// binary order clients get the same message in binary
+	static thread_local std::string bin;
+	bin.clear();
+	if (ws_service_->HasBinClients()) {
+		TradeBinSerializeOrderDeal(order, order_deal, bin);
+	}
+	BroadcastMsg(s.GetString(), s.GetLength(), bin);
 }
-void TradeService::RspOrderQry(uWS::WebSocket<uWS::SERVER>* ws, OrderQuery &order_qry, std::vector<Order> &orders, std::vector<OrderStatusNotify> &order_status, int error_id)
+void TradeService::BroadcastMsg(const char *json, size_t len, const std::string &bin)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	ws_service_->BroadcastTradeMsg(json, len, bin);
+}
+void TradeService::RspOrderQry(WsConnHandle conn, OrderQuery &order_qry, std::vector<Order> &orders, std::vector<OrderStatusNotify> &order_status, int error_id)
+{
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -187,12 +225,14 @@ void TradeService::RspOrderQry(uWS::WebSocket<uWS::SERVER>* ws, OrderQuery &orde
 
 	for (auto i = 0; i < orders.size(); i++)
 	{
+		PriceTick tick = price_ticks_.Find(orders[i].symbol, orders[i].contract);
+
 		writer.StartObject();
 		SerializeOrderStatus(writer, order_status[i]);
 
 		writer.Key("order");
 		writer.StartObject();
-		SerializeOrder(writer, orders[i]);
+		SerializeOrder(writer, orders[i], &tick);
 		writer.EndObject();  // order end
 
 		writer.EndObject();  // order status end
@@ -206,12 +246,12 @@ void TradeService::RspOrderQry(uWS::WebSocket<uWS::SERVER>* ws, OrderQuery &orde
 
 	LOG(INFO) << s.GetString();
 
-	ws_service_->SendMsgToClient(ws, s.GetString());
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
-void TradeService::RspTradeQry(uWS::WebSocket<uWS::SERVER>* ws, TradeQuery &trade_qry, std::vector<Order> &orders, std::vector<OrderDealNotify> &order_deal, int error_id)
+void TradeService::RspTradeQry(WsConnHandle conn, TradeQuery &trade_qry, std::vector<Order> &orders, std::vector<OrderDealNotify> &order_deal, int error_id)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -229,12 +269,14 @@ void TradeService::RspTradeQry(uWS::WebSocket<uWS::SERVER>* ws, TradeQuery &trad
 
 	for (auto i = 0; i < orders.size(); i++)
 	{
+		PriceTick tick = price_ticks_.Find(orders[i].symbol, orders[i].contract);
+
 		writer.StartObject();
-		SerializeOrderDeal(writer, order_deal[i]);
+		SerializeOrderDeal(writer, order_deal[i], &tick);
 
 		writer.Key("order");
 		writer.StartObject();
-		SerializeOrder(writer, orders[i]);
+		SerializeOrder(writer, orders[i], &tick);
 		writer.EndObject();  // order end
 
 		writer.EndObject();  // order deal end
@@ -248,13 +290,13 @@ void TradeService::RspTradeQry(uWS::WebSocket<uWS::SERVER>* ws, TradeQuery &trad
 
 	LOG(INFO) << s.GetString();
 
-	ws_service_->SendMsgToClient(ws, s.GetString());
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
 
-void TradeService::RspPositionQryType1(uWS::WebSocket<uWS::SERVER>* ws, PositionQuery &position_qry, std::vector<PositionSummaryType1> &positions, int error_id)
+void TradeService::RspPositionQryType1(WsConnHandle conn, PositionQuery &position_qry, std::vector<PositionSummaryType1> &positions, int error_id)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -288,12 +330,12 @@ void TradeService::RspPositionQryType1(uWS::WebSocket<uWS::SERVER>* ws, Position
 
 	LOG(INFO) << s.GetString();
 
-	ws_service_->SendMsgToClient(ws, s.GetString());
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
-void TradeService::RspPositionDetailQryType1(uWS::WebSocket<uWS::SERVER>* ws, PositionQuery &position_qry, std::vector<PositionDetailType1> &positions, int error_id)
+void TradeService::RspPositionDetailQryType1(WsConnHandle conn, PositionQuery &position_qry, std::vector<PositionDetailType1> &positions, int error_id)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -327,12 +369,12 @@ void TradeService::RspPositionDetailQryType1(uWS::WebSocket<uWS::SERVER>* ws, Po
 
 	LOG(INFO) << s.GetString();
 
-	ws_service_->SendMsgToClient(ws, s.GetString());
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
-void TradeService::RspTradeAccountQryType1(uWS::WebSocket<uWS::SERVER>* ws, TradeAccountQuery &tradeaccount_qry, std::vector<TradeAccountType1> &trade_accounts, int error_id)
+void TradeService::RspTradeAccountQryType1(WsConnHandle conn, TradeAccountQuery &tradeaccount_qry, std::vector<TradeAccountType1> &trade_accounts, int error_id)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -366,12 +408,12 @@ void TradeService::RspTradeAccountQryType1(uWS::WebSocket<uWS::SERVER>* ws, Trad
 
 	LOG(INFO) << s.GetString();
 
-	ws_service_->SendMsgToClient(ws, s.GetString());
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
-void TradeService::RspProductQryType1(uWS::WebSocket<uWS::SERVER>* ws, ProductQuery &product_qry, std::vector<ProductType1> &product_types, int error_id)
+void TradeService::RspProductQryType1(WsConnHandle conn, ProductQuery &product_qry, std::vector<ProductType1> &product_types, int error_id)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -392,6 +434,9 @@ void TradeService::RspProductQryType1(uWS::WebSocket<uWS::SERVER>* ws, ProductQu
 
 	for (auto i = 0; i < product_types.size(); i++)
 	{
+		// remember ticks, order prices of the instrument are printed with them from now on
+		price_ticks_.Set(product_types[i].symbol, product_types[i].contract, product_types[i].price_tick);
+
 		writer.StartObject();
 		SerializeProductType1(writer, product_types[i]);
 		writer.EndObject();
@@ -405,13 +450,13 @@ void TradeService::RspProductQryType1(uWS::WebSocket<uWS::SERVER>* ws, ProductQu
 
 	LOG(INFO) << s.GetString();
 
-	ws_service_->SendMsgToClient(ws, s.GetString());
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
 
-void TradeService::RspPositionQryType2(uWS::WebSocket<uWS::SERVER>* ws, PositionQuery &position_qry, std::vector<PositionSummaryType2> &positions, int error_id)
+void TradeService::RspPositionQryType2(WsConnHandle conn, PositionQuery &position_qry, std::vector<PositionSummaryType2> &positions, int error_id)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -445,12 +490,12 @@ void TradeService::RspPositionQryType2(uWS::WebSocket<uWS::SERVER>* ws, Position
 
 	LOG(INFO) << s.GetString();
 
-	ws_service_->SendMsgToClient(ws, s.GetString());
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
-void TradeService::RspTradeAccountQryType2(uWS::WebSocket<uWS::SERVER>* ws, TradeAccountQuery &tradeaccount_qry, std::vector<TradeAccountType2> &trade_accounts, int error_id)
+void TradeService::RspTradeAccountQryType2(WsConnHandle conn, TradeAccountQuery &tradeaccount_qry, std::vector<TradeAccountType2> &trade_accounts, int error_id)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
+	SerializeBuffer s(SerializeBuffer_TradeMsg);
+	auto &writer = s.Writer();
 
 	writer.StartObject();
 	writer.Key("msg");
@@ -484,7 +529,7 @@ void TradeService::RspTradeAccountQryType2(uWS::WebSocket<uWS::SERVER>* ws, Trad
 
 	LOG(INFO) << s.GetString();
 
-	ws_service_->SendMsgToClient(ws, s.GetString());
+	ws_service_->SendMsgToClient(conn, s.GetString());
 }
 
 
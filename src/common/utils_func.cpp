@@ -8,6 +8,30 @@ namespace babeltrader
 {
 
 
+void ParseUrlQuery(const std::string &query, std::map<std::string, std::string> &params)
+{
+	size_t begin = 0;
+	while (begin < query.size())
+	{
+		size_t end = query.find('&', begin);
+		if (end == std::string::npos)
+		{
+			end = query.size();
+		}
+
+		size_t eq = query.find('=', begin);
+		if (eq != std::string::npos && eq < end)
+		{
+			params[query.substr(begin, eq - begin)] = query.substr(eq + 1, end - eq - 1);
+		}
+		else if (end > begin)
+		{
+			params[query.substr(begin, end - begin)] = "";
+		}
+		begin = end + 1;
+	}
+}
+
 void CTPSplitInstrument(const char *instrument, std::string &symbol, std::string &contract)
 {
 	char buf[64] = { 0 };
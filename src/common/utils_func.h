@@ -2,6 +2,7 @@
 #define BABELTRADER_COMMON_FUNC_H_
 
 #include <string>
+#include <map>
 #include <chrono>
 
 namespace babeltrader
@@ -13,6 +14,9 @@ int64_t CTPGetTimestamp(const char *str_date, const char *str_time, int millisec
 
 int64_t XTPGetTimestamp(int64_t xtp_ts);
 
+// split "a=1&b=2" into params
+void ParseUrlQuery(const std::string &query, std::map<std::string, std::string> &params);
+
 class QuoteTransferMonitor
 {
 public:
@@ -0,0 +1,128 @@
+#include "ws_conn_table.h"
+
+#include <thread>
+
+namespace babeltrader
+{
+
+
+WsConnTable::WsConnTable()
+	: slots_(new WsConnSlot[WS_CONN_TABLE_SIZE])
+	, used_(0)
+	, size_(0)
+{
+	for (uint32_t i = 0; i < WS_CONN_TABLE_SIZE; i++) {
+		slots_[i].state.store(1ull << 32, std::memory_order_relaxed);
+		slots_[i].ws.store(nullptr, std::memory_order_relaxed);
+		slots_[i].flags.store(0, std::memory_order_relaxed);
+	}
+}
+
+WsConnHandle WsConnTable::Add(uWS::WebSocket<uWS::SERVER> *ws, uint32_t flags)
+{
+	std::unique_lock<std::mutex> lock(free_mtx_);
+
+	uint32_t idx = 0;
+	bool fresh = false;
+	if (!free_.empty()) {
+		idx = free_.back();
+		free_.pop_back();
+	}
+	else if (used_.load(std::memory_order_relaxed) < WS_CONN_TABLE_SIZE) {
+		idx = used_.load(std::memory_order_relaxed);
+		fresh = true;
+	}
+	else {
+		return WS_CONN_INVALID;
+	}
+
+	WsConnSlot &slot = slots_[idx];
+	slot.ws.store(ws, std::memory_order_relaxed);
+	slot.flags.store(flags, std::memory_order_relaxed);
+
+	uint64_t gen = slot.state.load(std::memory_order_relaxed) & WS_CONN_GEN_MASK;
+	slot.state.store(gen | WS_CONN_ALIVE, std::memory_order_release);
+	if (fresh) {
+		used_.store(idx + 1, std::memory_order_release);
+	}
+	size_++;
+
+	return gen | idx;
+}
+void WsConnTable::Remove(WsConnHandle handle)
+{
+	uint32_t idx = (uint32_t)(handle & 0xFFFFFFFFull);
+	if (handle == WS_CONN_INVALID || idx >= WS_CONN_TABLE_SIZE) {
+		return;
+	}
+
+	WsConnSlot &slot = slots_[idx];
+	uint64_t state = slot.state.load(std::memory_order_acquire);
+	if ((state & WS_CONN_GEN_MASK) != (handle & WS_CONN_GEN_MASK) || !(state & WS_CONN_ALIVE)) {
+		return;
+	}
+
+	// no new pins after this, wait for the ones already taken
+	state = slot.state.fetch_and(~WS_CONN_ALIVE, std::memory_order_acq_rel) & ~WS_CONN_ALIVE;
+	while (state & WS_CONN_PIN_MASK) {
+		std::this_thread::yield();
+		state = slot.state.load(std::memory_order_acquire);
+	}
+
+	slot.ws.store(nullptr, std::memory_order_relaxed);
+	slot.flags.store(0, std::memory_order_relaxed);
+
+	uint64_t gen = (state & WS_CONN_GEN_MASK) + (1ull << 32);
+	if (gen == 0) {
+		gen = 1ull << 32;
+	}
+	slot.state.store(gen, std::memory_order_release);
+
+	std::unique_lock<std::mutex> lock(free_mtx_);
+	free_.push_back(idx);
+	size_--;
+}
+
+uWS::WebSocket<uWS::SERVER>* WsConnTable::Pin(WsConnHandle handle, uint32_t *flags)
+{
+	uint32_t idx = (uint32_t)(handle & 0xFFFFFFFFull);
+	if (handle == WS_CONN_INVALID || idx >= WS_CONN_TABLE_SIZE) {
+		return nullptr;
+	}
+
+	WsConnSlot &slot = slots_[idx];
+	uint64_t state = slot.state.load(std::memory_order_acquire);
+	do {
+		if ((state & WS_CONN_GEN_MASK) != (handle & WS_CONN_GEN_MASK) || !(state & WS_CONN_ALIVE)) {
+			return nullptr;
+		}
+	} while (!slot.state.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire));
+
+	if (flags) {
+		*flags = slot.flags.load(std::memory_order_relaxed);
+	}
+	return slot.ws.load(std::memory_order_relaxed);
+}
+void WsConnTable::Unpin(WsConnHandle handle)
+{
+	uint32_t idx = (uint32_t)(handle & 0xFFFFFFFFull);
+	slots_[idx].state.fetch_sub(1, std::memory_order_release);
+}
+uint32_t WsConnTable::PeekFlags(WsConnHandle handle) const
+{
+	uint32_t idx = (uint32_t)(handle & 0xFFFFFFFFull);
+	if (handle == WS_CONN_INVALID || idx >= WS_CONN_TABLE_SIZE) {
+		return 0;
+	}
+
+	const WsConnSlot &slot = slots_[idx];
+	uint32_t flags = slot.flags.load(std::memory_order_acquire);
+	uint64_t state = slot.state.load(std::memory_order_acquire);
+	if ((state & WS_CONN_GEN_MASK) != (handle & WS_CONN_GEN_MASK) || !(state & WS_CONN_ALIVE)) {
+		return 0;
+	}
+	return flags;
+}
+
+
+}
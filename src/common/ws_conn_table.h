@@ -0,0 +1,137 @@
+#ifndef BABELTRADER_WS_CONN_TABLE_H_
+#define BABELTRADER_WS_CONN_TABLE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "uWS/uWS.h"
+
+namespace babeltrader
+{
+
+// handle of a ws connection, generation << 32 | slot.
+// a handle kept after the connection is gone never matches the next
+// connection in the same slot, 0 is never a valid handle
+typedef uint64_t WsConnHandle;
+#define WS_CONN_INVALID 0
+
+#define WS_CONN_TABLE_SIZE 65536
+
+// slot state: generation in high 32 bits, alive bit, pin count in the rest
+#define WS_CONN_GEN_MASK 0xFFFFFFFF00000000ull
+#define WS_CONN_ALIVE 0x80000000ull
+#define WS_CONN_PIN_MASK 0x7FFFFFFFull
+
+enum WsConnFlagEnum
+{
+	WsConnFlag_BinOrder = 1,	// binary order entry connection
+};
+
+// index of the uWS hub owning the connection, kept in flags
+#define WS_CONN_HUB_SHIFT 8
+#define WS_CONN_HUB_MASK 0xFF00u
+inline int WsConnHub(uint32_t flags)
+{
+	return (int)((flags & WS_CONN_HUB_MASK) >> WS_CONN_HUB_SHIFT);
+}
+
+// connections by handle. Pin/Unpin never lock, a pinned socket stays alive
+// until Unpin because Remove waits for the pins of its slot to go away.
+// Add/Remove are called from the uWS loop when a connection comes and goes
+class WsConnTable
+{
+public:
+	WsConnTable();
+
+	WsConnTable(const WsConnTable&) = delete;
+	WsConnTable& operator=(const WsConnTable&) = delete;
+
+	// return WS_CONN_INVALID when the table is full
+	WsConnHandle Add(uWS::WebSocket<uWS::SERVER> *ws, uint32_t flags);
+	void Remove(WsConnHandle handle);
+
+	// socket of a live handle and pin it, nullptr if the connection is gone
+	uWS::WebSocket<uWS::SERVER>* Pin(WsConnHandle handle, uint32_t *flags = nullptr);
+	void Unpin(WsConnHandle handle);
+
+	// flags of a live handle without pin, 0 if the connection is gone
+	uint32_t PeekFlags(WsConnHandle handle) const;
+
+	// pin every live connection in turn
+	template <typename FUNC>
+	void ForEach(FUNC fn)
+	{
+		uint32_t used = used_.load(std::memory_order_acquire);
+		for (uint32_t i = 0; i < used; i++) {
+			uint64_t state = slots_[i].state.load(std::memory_order_acquire);
+			if (!(state & WS_CONN_ALIVE)) {
+				continue;
+			}
+
+			WsConnHandle handle = (state & WS_CONN_GEN_MASK) | i;
+			uint32_t flags = 0;
+			uWS::WebSocket<uWS::SERVER> *ws = Pin(handle, &flags);
+			if (ws) {
+				fn(handle, ws, flags);
+				Unpin(handle);
+			}
+		}
+	}
+
+	uint32_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+	struct WsConnSlot
+	{
+		std::atomic<uint64_t> state;
+		std::atomic<uWS::WebSocket<uWS::SERVER>*> ws;
+		std::atomic<uint32_t> flags;
+	};
+
+	std::unique_ptr<WsConnSlot[]> slots_;
+	std::atomic<uint32_t> used_;	// slots below this were ever handed out
+	std::atomic<uint32_t> size_;
+
+	std::mutex free_mtx_;
+	std::vector<uint32_t> free_;
+};
+
+// pin of a handle for a scope
+class WsConnRef
+{
+public:
+	WsConnRef(WsConnTable &table, WsConnHandle handle)
+		: table_(table)
+		, handle_(handle)
+		, flags_(0)
+	{
+		ws_ = table_.Pin(handle_, &flags_);
+	}
+	~WsConnRef()
+	{
+		if (ws_) {
+			table_.Unpin(handle_);
+		}
+	}
+
+	WsConnRef(const WsConnRef&) = delete;
+	WsConnRef& operator=(const WsConnRef&) = delete;
+
+	uWS::WebSocket<uWS::SERVER>* ws() const { return ws_; }
+	uint32_t flags() const { return flags_; }
+	explicit operator bool() const { return ws_ != nullptr; }
+
+private:
+	WsConnTable &table_;
+	WsConnHandle handle_;
+	uWS::WebSocket<uWS::SERVER> *ws_;
+	uint32_t flags_;
+};
+
+
+}
+
+#endif
@@ -0,0 +1,271 @@
+#include "ws_outbox.h"
+
+#include <string.h>
+
+#include "glog/logging.h"
+
+namespace babeltrader
+{
+
+
+WsOutbox::WsOutbox(WsConnTable &conns)
+	: conns_(conns)
+	, ring_(WS_OUTBOX_RING_SIZE, QuoteRingOverflow_Block)
+	, async_(nullptr)
+	, wake_pending_(false)
+	, loop_tid_(std::thread::id())
+	, wakeups_(0)
+	, direct_sends_(0)
+	, large_sends_(0)
+{}
+
+void WsOutbox::Start(uS::Loop *loop)
+{
+	async_ = new uS::Async(loop);
+	async_->setData(this);
+	async_->start(WsOutbox::OnAsync);
+
+	// messages put before start are waiting in the ring
+	if (wake_pending_.load(std::memory_order_acquire)) {
+		async_->send();
+	}
+}
+
+void WsOutbox::Send(WsConnHandle conn, const char *data, size_t len, uWS::OpCode op_code, WsSentCallback callback, void *callback_data)
+{
+	WsOutboxHead head;
+	memset(&head, 0, sizeof(head));
+	head.conn = conn;
+	head.callback = callback;
+	head.callback_data = callback_data;
+	head.op_code = (uint8_t)op_code;
+	Put(head, nullptr, data, len);
+}
+void WsOutbox::Broadcast(const char *data, size_t len, uWS::OpCode op_code, uint32_t flag_mask, uint32_t flag_value)
+{
+	WsOutboxHead head;
+	memset(&head, 0, sizeof(head));
+	head.conn = WS_CONN_INVALID;
+	head.flag_mask = flag_mask;
+	head.flag_value = flag_value;
+	head.op_code = (uint8_t)op_code;
+	Put(head, nullptr, data, len);
+}
+void WsOutbox::Multicast(const char *data, size_t len, uWS::OpCode op_code, const WsOutboxTarget *targets, size_t cnt, WsSentCallback callback)
+{
+	if (cnt == 0) {
+		return;
+	}
+
+	WsOutboxHead head;
+	memset(&head, 0, sizeof(head));
+	head.conn = WS_CONN_INVALID;
+	head.callback = callback;
+	head.targets = (uint32_t)cnt;
+	head.op_code = (uint8_t)op_code;
+	Put(head, targets, data, len);
+}
+void WsOutbox::Post(std::function<void()> fn)
+{
+	{
+		std::unique_lock<std::mutex> lock(task_mtx_);
+		tasks_.push_back(std::move(fn));
+	}
+	Wakeup();
+}
+
+void WsOutbox::GetStats(WsOutboxStats &stats)
+{
+	ring_.GetStats(stats.ring);
+	stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+	stats.direct_sends = direct_sends_.load(std::memory_order_relaxed);
+	stats.large_sends = large_sends_.load(std::memory_order_relaxed);
+	batch_.Snapshot(stats.batch);
+}
+
+void WsOutbox::OnAsync(uS::Async *async)
+{
+	((WsOutbox*)async->getData())->Drain();
+}
+
+void WsOutbox::Put(const WsOutboxHead &head, const WsOutboxTarget *targets, const char *data, size_t len)
+{
+	// the loop thread owns the sockets, and must never block on its own ring.
+	// what other threads put before is sent first, a connection keeps its order
+	if (InLoopThread()) {
+		uint32_t pending = 0;
+		if (ring_.Front(&pending) != nullptr) {
+			DrainRing(UINT64_MAX);
+		}
+		direct_sends_.fetch_add(1, std::memory_order_relaxed);
+		SendNow(head, (const char*)targets, data, len);
+		return;
+	}
+
+	static thread_local std::string rec;
+	size_t targets_len = head.targets * sizeof(WsOutboxTarget);
+	if (targets_len + len <= WS_OUTBOX_LARGE_SIZE) {
+		rec.assign((const char*)&head, sizeof(head));
+		rec.append((const char*)targets, targets_len);
+		rec.append(data, len);
+	}
+	else {
+		// keeps its place in the ring, but not its bytes
+		large_sends_.fetch_add(1, std::memory_order_relaxed);
+		std::string *large = new std::string((const char*)targets, targets_len);
+		large->append(data, len);
+
+		WsOutboxHead large_head = head;
+		large_head.large = 1;
+		rec.assign((const char*)&large_head, sizeof(large_head));
+		rec.append((const char*)&large, sizeof(large));
+	}
+
+	if (!ring_.Write(rec.data(), (uint32_t)rec.size())) {
+		LOG(WARNING) << "failed put ws outbound message, len: " << len;
+		WsOutboxHead failed;
+		memcpy(&failed, rec.data(), sizeof(failed));
+		if (failed.large) {
+			std::string *large = nullptr;
+			memcpy(&large, rec.data() + sizeof(failed), sizeof(large));
+			delete large;
+		}
+		Cancel(head, (const char*)targets);
+		return;
+	}
+
+	Wakeup();
+}
+void WsOutbox::Wakeup()
+{
+	if (!wake_pending_.exchange(true, std::memory_order_acq_rel) && async_) {
+		async_->send();
+	}
+}
+
+void WsOutbox::Drain()
+{
+	SetLoopThread();
+	wakeups_.fetch_add(1, std::memory_order_relaxed);
+
+	// clear before reading, a message put after this asks for a new wakeup
+	wake_pending_.store(false, std::memory_order_release);
+
+	std::vector<std::function<void()>> tasks;
+	{
+		std::unique_lock<std::mutex> lock(task_mtx_);
+		tasks.swap(tasks_);
+	}
+	for (auto &fn : tasks) {
+		fn();
+	}
+
+	uint64_t cnt = DrainRing(WS_OUTBOX_DRAIN_MAX);
+	if (cnt > 0) {
+		batch_.Record(cnt);
+	}
+
+	// let other events of the loop run, and come back for the rest
+	uint32_t len = 0;
+	if (cnt == WS_OUTBOX_DRAIN_MAX && ring_.Front(&len) != nullptr) {
+		Wakeup();
+	}
+}
+uint64_t WsOutbox::DrainRing(uint64_t max)
+{
+	uint64_t cnt = 0;
+	uint32_t len = 0;
+	const void *rec = nullptr;
+	while (cnt < max && (rec = ring_.Front(&len)) != nullptr) {
+		WsOutboxHead head;
+		memcpy(&head, rec, sizeof(head));
+		size_t targets_len = head.targets * sizeof(WsOutboxTarget);
+		if (head.large) {
+			std::string *large = nullptr;
+			memcpy(&large, (const char*)rec + sizeof(head), sizeof(large));
+			SendNow(head, large->data(), large->data() + targets_len, large->size() - targets_len);
+			delete large;
+		}
+		else {
+			const char *targets = (const char*)rec + sizeof(head);
+			SendNow(head, targets, targets + targets_len, len - sizeof(head) - targets_len);
+		}
+		ring_.Pop();
+		cnt++;
+	}
+	return cnt;
+}
+
+// targets may be unaligned in the ring, they are copied out one by one
+void WsOutbox::SendNow(const WsOutboxHead &head, const char *targets, const char *data, size_t len)
+{
+	uWS::OpCode op_code = (uWS::OpCode)head.op_code;
+	if (head.conn != WS_CONN_INVALID) {
+		WsConnRef ref(conns_, head.conn);
+		if (ref) {
+			ref.ws()->send(data, len, op_code, head.callback, head.callback_data);
+		}
+		else {
+			Cancel(head, targets);
+		}
+		return;
+	}
+
+	if (head.targets > 0) {
+		uWS::WebSocket<uWS::SERVER>::PreparedMessage *prepared = nullptr;
+		for (uint32_t i = 0; i < head.targets; i++) {
+			WsOutboxTarget target;
+			memcpy(&target, targets + i * sizeof(WsOutboxTarget), sizeof(target));
+
+			WsConnRef ref(conns_, target.conn);
+			if (!ref) {
+				if (head.callback) {
+					head.callback(nullptr, target.data, true, nullptr);
+				}
+				continue;
+			}
+			if (prepared == nullptr) {
+				prepared = uWS::WebSocket<uWS::SERVER>::prepareMessage((char*)data, len, op_code, false, head.callback);
+			}
+			ref.ws()->sendPrepared(prepared, target.data);
+		}
+		if (prepared) {
+			uWS::WebSocket<uWS::SERVER>::finalizeMessage(prepared);
+		}
+		return;
+	}
+
+	uWS::WebSocket<uWS::SERVER>::PreparedMessage *prepared = nullptr;
+	conns_.ForEach([&](WsConnHandle conn, uWS::WebSocket<uWS::SERVER> *ws, uint32_t flags) {
+		if ((flags & head.flag_mask) != head.flag_value) {
+			return;
+		}
+		if (prepared == nullptr) {
+			prepared = uWS::WebSocket<uWS::SERVER>::prepareMessage((char*)data, len, op_code, false);
+		}
+		ws->sendPrepared(prepared);
+	});
+	if (prepared) {
+		uWS::WebSocket<uWS::SERVER>::finalizeMessage(prepared);
+	}
+}
+
+// callback of every receiver runs once, so flow control of the senders is released
+void WsOutbox::Cancel(const WsOutboxHead &head, const char *targets)
+{
+	if (head.callback == nullptr) {
+		return;
+	}
+	if (head.conn != WS_CONN_INVALID) {
+		head.callback(nullptr, head.callback_data, true, nullptr);
+		return;
+	}
+	for (uint32_t i = 0; i < head.targets; i++) {
+		WsOutboxTarget target;
+		memcpy(&target, targets + i * sizeof(WsOutboxTarget), sizeof(target));
+		head.callback(nullptr, target.data, true, nullptr);
+	}
+}
+
+
+}
@@ -0,0 +1,122 @@
+#ifndef BABELTRADER_WS_OUTBOX_H_
+#define BABELTRADER_WS_OUTBOX_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "uWS/uWS.h"
+
+#include "common/quote_ring.h"
+#include "common/histogram.h"
+#include "common/ws_conn_table.h"
+
+namespace babeltrader
+{
+
+#define WS_OUTBOX_RING_SIZE (4 * 1024 * 1024)
+#define WS_OUTBOX_LARGE_SIZE (WS_OUTBOX_RING_SIZE / 8)	// larger records go to the heap, the ring keeps a pointer
+#define WS_OUTBOX_DRAIN_MAX 4096						// records sent per wakeup, the rest waits for the next one
+
+// completion of a send, same as the callback of uWS send, ws is null when cancelled
+typedef void (*WsSentCallback)(uWS::WebSocket<uWS::SERVER> *ws, void *data, bool cancelled, void *reserved);
+
+// a receiver of a multicast, data goes to the sent callback
+struct WsOutboxTarget
+{
+	WsConnHandle conn;
+	void *data;
+};
+
+struct WsOutboxStats
+{
+	int hub;
+	QuoteRingStats ring;
+	uint64_t wakeups;
+	uint64_t direct_sends;		// sent right away by the loop thread itself
+	uint64_t large_sends;		// records over WS_OUTBOX_LARGE_SIZE
+	HistogramSnapshot batch;	// messages sent per wakeup
+};
+
+// outbound messages of one uWS loop. any thread puts messages in the ring and
+// wakes the loop with an async handle, the loop thread drains the ring and
+// does every socket write. one wakeup is asked for until the loop has started
+// draining, so a burst of messages costs one wakeup and one drain.
+// a broadcast or multicast is framed once and shared by all its connections.
+// only the loop thread sends in place, other threads block while the ring is
+// full, so they must not hold a connection pin or a lock the loop thread needs
+class WsOutbox
+{
+public:
+	explicit WsOutbox(WsConnTable &conns);
+
+	WsOutbox(const WsOutbox&) = delete;
+	WsOutbox& operator=(const WsOutbox&) = delete;
+
+	// create the async handle, call before the loop runs
+	void Start(uS::Loop *loop);
+
+	// to one connection. callback always runs once, cancelled if the connection is gone
+	void Send(WsConnHandle conn, const char *data, size_t len, uWS::OpCode op_code, WsSentCallback callback = nullptr, void *callback_data = nullptr);
+
+	// to every connection with (flags & flag_mask) == flag_value
+	void Broadcast(const char *data, size_t len, uWS::OpCode op_code, uint32_t flag_mask, uint32_t flag_value);
+
+	// to the listed connections, callback runs once for every target
+	void Multicast(const char *data, size_t len, uWS::OpCode op_code, const WsOutboxTarget *targets, size_t cnt, WsSentCallback callback);
+
+	// run fn in loop thread
+	void Post(std::function<void()> fn);
+
+	// the loop thread, known after its first callback
+	void SetLoopThread() { loop_tid_.store(std::this_thread::get_id(), std::memory_order_relaxed); }
+	bool InLoopThread() const { return loop_tid_.load(std::memory_order_relaxed) == std::this_thread::get_id(); }
+
+	void GetStats(WsOutboxStats &stats);
+
+private:
+	struct WsOutboxHead
+	{
+		WsConnHandle conn;		// WS_CONN_INVALID for broadcast and multicast
+		WsSentCallback callback;
+		void *callback_data;
+		uint32_t flag_mask;
+		uint32_t flag_value;
+		uint32_t targets;		// multicast targets between head and payload
+		uint8_t op_code;
+		uint8_t large;			// targets and payload are in a heap string, the ring holds its pointer
+		uint8_t reserved[2];
+	};
+
+	static void OnAsync(uS::Async *async);
+	void Put(const WsOutboxHead &head, const WsOutboxTarget *targets, const char *data, size_t len);
+	void Wakeup();
+	void Drain();
+	uint64_t DrainRing(uint64_t max);
+	void SendNow(const WsOutboxHead &head, const char *targets, const char *data, size_t len);
+	void Cancel(const WsOutboxHead &head, const char *targets);
+
+private:
+	WsConnTable &conns_;
+	QuoteRing ring_;
+	uS::Async *async_;
+	std::atomic<bool> wake_pending_;
+	std::atomic<std::thread::id> loop_tid_;
+
+	std::mutex task_mtx_;
+	std::vector<std::function<void()>> tasks_;
+
+	std::atomic<uint64_t> wakeups_;
+	std::atomic<uint64_t> direct_sends_;
+	std::atomic<uint64_t> large_sends_;
+	Histogram batch_;
+};
+
+
+}
+
+#endif
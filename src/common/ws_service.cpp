@@ -1,7 +1,8 @@
 #include "ws_service.h"
 
 #include <iostream>
-#include <queue>
+#include <chrono>
+#include <string.h>
 
 #include "glog/logging.h"
 #include "rapidjson/writer.h"
@@ -9,15 +10,42 @@
 
 #include "err.h"
 #include "converter.h"
+#include "utils_func.h"
 
 namespace babeltrader
 {
 
+const char *g_ws_lanes[WsLane_Max] = {
+	"order",
+	"query"
+};
 
-WsService::WsService(QuoteService *quote_service, TradeService *trade_service)
+static int64_t SteadyNowNs()
+{
+	return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// mix slot and generation of the handle before taking the shard
+static size_t WsShardIndex(WsConnHandle conn, size_t shards)
+{
+	uint64_t h = conn * 0x9E3779B97F4A7C15ull;
+	return (size_t)(h >> 32) % shards;
+}
+static WsConnHandle GetConnHandle(uWS::WebSocket<uWS::SERVER> *ws)
+{
+	return (WsConnHandle)(uintptr_t)ws->getUserData();
+}
+
+WsService::WsService(QuoteService *quote_service, TradeService *trade_service, int hubs, int shards, int query_rate)
 	: quote_(quote_service)
 	, trade_(trade_service)
+	, query_interval_ns_(query_rate > 0 ? 1000000000LL / query_rate : 0)
+	, bin_clients_(0)
 {
+	for (int i = 0; i < WsLane_Max; i++) {
+		lane_processed_[i].store(0, std::memory_order_relaxed);
+	}
+
 	if (quote_)
 	{
 		quote_->ws_service_ = this;
@@ -29,115 +57,463 @@ WsService::WsService(QuoteService *quote_service, TradeService *trade_service)
 
 	RegisterCallbacks();
 
-	std::thread th(&WsService::MessageLoop, this);
-	th.detach();
+	// hub loops are not running yet
+	if (hubs < 1) {
+		hubs = 1;
+	}
+	if (hubs > WS_HUBS_MAX) {
+		hubs = WS_HUBS_MAX;
+	}
+	for (int i = 0; i < hubs; i++) {
+		hubs_.emplace_back(new uWS::Hub());
+		outboxes_.emplace_back(new WsOutbox(conns_));
+		outboxes_.back()->Start(hubs_.back()->getLoop());
+	}
+
+	if (shards < 1) {
+		shards = 1;
+	}
+	if (shards > WS_SHARDS_MAX) {
+		shards = WS_SHARDS_MAX;
+	}
+	for (int i = 0; i < shards; i++) {
+		shards_.emplace_back(new WsShard());
+	}
+	for (auto &shard : shards_) {
+		std::thread th(&WsService::MessageLoop, this, shard.get());
+		th.detach();
+	}
 }
 
-void WsService::onConnection(uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest &req)
+void WsService::onConnection(int hub, uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest &req)
 {
+	outboxes_[hub]->SetLoopThread();
 	LOG(INFO) << "ws connection: " << ws->getAddress().address << ":" << ws->getAddress().port << ", url: " << req.getUrl().toString() << std::endl;
-	if (req.getUrl().toString() != "/ws")
+	auto url = req.getUrl().toString();
+
+	// quote clients pick options with url query, e.g. /ws?delta=1&batch=latency&compress=deflate
+	std::map<std::string, std::string> params;
+	auto pos = url.find('?');
+	if (pos != std::string::npos)
+	{
+		ParseUrlQuery(url.substr(pos + 1), params);
+		url = url.substr(0, pos);
+	}
+
+	int batch_policy = 0;
+	if (quote_)
+	{
+		batch_policy = quote_->FindBatchPolicy(params["batch"]);
+	}
+
+	if (url != "/ws" && !(url == "/ws/bin" && quote_) && !(url == "/ws/order" && trade_))
+	{
+		ws->close();
+	}
+	else if (batch_policy < 0)
+	{
+		LOG(WARNING) << "ws connection with unknown batch policy: " << params["batch"];
+		ws->close();
+	}
+	else if (!params["compress"].empty() && params["compress"] != "deflate")
 	{
+		LOG(WARNING) << "ws connection with unknown compress: " << params["compress"];
 		ws->close();
-	} 
+	}
 	else
 	{
-		std::unique_lock<std::mutex> lock(ws_mtx_);
-		ws_set_.insert(ws);
+		uint32_t flags = ((uint32_t)hub << WS_CONN_HUB_SHIFT) | (url == "/ws/order" ? WsConnFlag_BinOrder : 0);
+		WsConnHandle conn = conns_.Add(ws, flags);
+		if (conn == WS_CONN_INVALID)
+		{
+			LOG(WARNING) << "ws connection table full, connections: " << conns_.Size();
+			ws->close();
+			return;
+		}
+		ws->setUserData((void*)(uintptr_t)conn);
+		if (flags & WsConnFlag_BinOrder) {
+			bin_clients_++;
+		}
+
+		if (quote_)
+		{
+			int encoding = url == "/ws/bin" ? QuoteEncoding_Binary : QuoteEncoding_Json;
+			if (params["delta"] == "1")
+			{
+				encoding = encoding == QuoteEncoding_Binary ? QuoteEncoding_BinaryDelta : QuoteEncoding_JsonDelta;
+			}
+			quote_->OnWsConnection(ws, conn, hub, encoding, batch_policy, params["compress"] == "deflate");
+		}
 	}
 }
 void WsService::onDisconnection(uWS::WebSocket<uWS::SERVER> *ws, int code, char *message, size_t length)
 {
 	LOG(INFO) << "ws disconnection: " << ws->getAddress().address << ":" << ws->getAddress().port << std::endl;
+	WsConnHandle conn = GetConnHandle(ws);
+	uint32_t flags = 0;
 	{
-		std::unique_lock<std::mutex> lock(ws_mtx_);
-		ws_set_.erase(ws);
+		WsConnRef ref(conns_, conn);
+		flags = ref.flags();
+	}
+	// wait senders of other threads out, the socket is freed after return
+	conns_.Remove(conn);
+	ws->setUserData(nullptr);
+	if (flags & WsConnFlag_BinOrder) {
+		bin_clients_--;
+	}
+
+	if (quote_)
+	{
+		quote_->OnWsDisconnection(conn);
 	}
 }
 void WsService::onMessage(uWS::WebSocket<uWS::SERVER> *ws, char *message, size_t length, uWS::OpCode opCode)
 {
+	WsConnHandle conn = GetConnHandle(ws);
+	if (opCode == uWS::OpCode::BINARY) {
+		// binary requests are only orders on /ws/order, flags are set before any message
+		if (trade_ && (conns_.PeekFlags(conn) & WsConnFlag_BinOrder)) {
+			OnBinMessage(conn, message, length);
+			return;
+		}
+
+		LOG(WARNING) << "binary ws message on text connection, len: " << length;
+		OnClientMsgError(conn, nullptr,
+			BABELTRADER_ERR_WSREQ_FAILED_PARSE,
+			BABELTRADER_ERR_MSG[BABELTRADER_ERR_WSREQ_FAILED_PARSE - BABELTRADER_ERR_BEGIN]);
+		return;
+	}
+
 	LOG(INFO).write(message, length);
 
-	rapidjson::Document doc;
-	doc.Parse(message, length);
+	WsRequest *req = GetRequest();
+	req->conn_ = conn;
+	req->text_.assign(message, message + length);
+	req->text_.push_back('\0');
+
+	auto t = std::chrono::steady_clock::now();
+	req->doc_.ParseInsitu(&req->text_[0]);
+	req->parse_ns_ = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t).count();
 
-	if (doc.HasParseError()) {
-		OnClientMsgError(ws, message, length, 
+	if (req->doc_.HasParseError()) {
+		parse_invalid_ns_.Record(req->parse_ns_);
+		ReleaseRequest(req);
+
+		OnClientMsgError(conn, nullptr,
 			BABELTRADER_ERR_WSREQ_FAILED_PARSE, 
 			BABELTRADER_ERR_MSG[BABELTRADER_ERR_WSREQ_FAILED_PARSE - BABELTRADER_ERR_BEGIN]);
 		return;
 	}
 
-	int ret = PutMsg(ws, std::move(doc));
-	if (ret != 0) {
-		OnClientMsgError(ws, message, length,
-			BABELTRADER_ERR_WSREQ_FAILED_TUNNEL,
-			BABELTRADER_ERR_MSG[BABELTRADER_ERR_WSREQ_FAILED_TUNNEL - BABELTRADER_ERR_BEGIN]);
+	FindCallback(req);
+	PutMsg(req);
+}
+
+void WsService::OnBinMessage(WsConnHandle conn, char *message, size_t length)
+{
+	WsRequest *req = GetRequest();
+	req->conn_ = conn;
+
+	auto t = std::chrono::steady_clock::now();
+	int ret = TradeBinParseRequest(message, length, req->bin_type_, req->order_);
+	req->parse_ns_ = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t).count();
+
+	if (ret != BABELTRADER_OK) {
+		bin_parse_ns_[TradeBinMsg_Unknown].Record(req->parse_ns_);
+		LOG(WARNING) << "failed parse binary order message, len: " << length;
+
+		uint8_t msg_type = req->bin_type_;
+		ReleaseRequest(req);
+
+		OnClientBinMsgError(conn, msg_type, nullptr, ret, BABELTRADER_ERR_MSG[ret - BABELTRADER_ERR_BEGIN]);
+		return;
 	}
+	bin_parse_ns_[req->bin_type_].Record(req->parse_ns_);
+
+	req->lane_ = WsLane_Order;
+	PutMsg(req);
 }
 
-int WsService::PutMsg(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &&doc)
+WsService::WsRequest* WsService::GetRequest()
 {
-	WsTunnelMsg msg(ws, std::move(doc));
+	{
+		std::unique_lock<std::mutex> lock(pool_mtx_);
+		if (!pool_.empty()) {
+			WsRequest *req = pool_.back();
+			pool_.pop_back();
+			return req;
+		}
+	}
+
+	return new WsRequest();
+}
+void WsService::ReleaseRequest(WsRequest *req)
+{
+	// doc values live in the allocator chunks, drop them before clear
+	req->doc_.SetNull();
+	req->allocator_.Clear();
+	req->conn_ = WS_CONN_INVALID;
+	req->callback_ = -1;
+	req->has_msg_ = false;
+	req->lane_ = WsLane_Order;
+	req->bin_type_ = TradeBinMsg_Unknown;
+	if (req->text_.capacity() > WS_REQUEST_KEEP_MAX) {
+		std::vector<char>().swap(req->text_);
+	}
 
-	auto ret = msg_tunnel_.Write(std::move(msg));
-	if (ret != muggle::TUNNEL_SUCCESS) {
-		return -1;
+	{
+		std::unique_lock<std::mutex> lock(pool_mtx_);
+		if (pool_.size() < WS_REQUEST_POOL_MAX) {
+			pool_.push_back(req);
+			return;
+		}
 	}
 
-	return 0;
+	delete req;
 }
 
-void WsService::SendMsgToClient(uWS::WebSocket<uWS::SERVER> *ws, const char *msg)
+void WsService::PutMsg(WsRequest *req)
 {
-	std::unique_lock<std::mutex> lock(ws_mtx_);
-	if (ws_set_.find(ws) != ws_set_.end()) {
-		ws->send(msg);
+	WsShard *shard = shards_[WsShardIndex(req->conn_, shards_.size())].get();
+
+	req->put_ns_ = SteadyNowNs();
+	int64_t depth = 0;
+	{
+		std::unique_lock<std::mutex> lock(shard->mtx);
+		shard->lanes[req->lane_].push_back(req);
+		depth = ++shard->depth;
+	}
+	shard->cv.notify_one();
+
+	shard->put_depth.Record((uint64_t)depth);
+	int64_t peak = shard->peak_depth.load(std::memory_order_relaxed);
+	while (depth > peak && !shard->peak_depth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
 	}
 }
 
-void WsService::MessageLoop()
+// order lane first, a query only when its turn of the query rate has come
+WsService::WsRequest* WsService::TakeMsg(WsShard *shard, std::unique_lock<std::mutex> &lock, int64_t &next_query_ns)
 {
-	std::queue<WsTunnelMsg> queue;
 	while (true) {
-		msg_tunnel_.Read(queue, true);
-		while (queue.size()) {
-			WsTunnelMsg &msg = queue.front();
-			Dispatch(msg.ws_, msg.doc_);
-			queue.pop();
+		std::deque<WsRequest*> &orders = shard->lanes[WsLane_Order];
+		if (!orders.empty()) {
+			WsRequest *req = orders.front();
+			orders.pop_front();
+			return req;
+		}
+
+		std::deque<WsRequest*> &queries = shard->lanes[WsLane_Query];
+		if (queries.empty()) {
+			shard->cv.wait(lock);
+			continue;
+		}
+
+		if (query_interval_ns_ > 0) {
+			int64_t now = SteadyNowNs();
+			if (now < next_query_ns) {
+				shard->cv.wait_for(lock, std::chrono::nanoseconds(next_query_ns - now));
+				continue;
+			}
+			next_query_ns = now + query_interval_ns_;
+		}
+
+		WsRequest *req = queries.front();
+		queries.pop_front();
+		return req;
+	}
+}
+
+void WsService::SendMsgToClient(WsConnHandle conn, const char *msg)
+{
+	ConnOutbox(conn).Send(conn, msg, strlen(msg), uWS::OpCode::TEXT);
+}
+
+// every hub frames the message once for its own connections
+void WsService::BroadcastTradeMsg(const char *json, size_t json_len, const std::string &bin)
+{
+	for (size_t i = 0; i < outboxes_.size(); i++) {
+		uint32_t mask = WS_CONN_HUB_MASK | WsConnFlag_BinOrder;
+		uint32_t hub = (uint32_t)i << WS_CONN_HUB_SHIFT;
+		outboxes_[i]->Broadcast(json, json_len, uWS::OpCode::TEXT, mask, hub);
+		if (!bin.empty()) {
+			outboxes_[i]->Broadcast(bin.data(), bin.size(), uWS::OpCode::BINARY, mask, hub | WsConnFlag_BinOrder);
+		}
+	}
+}
+
+void WsService::GetMsgStats(std::vector<WsMsgStats> &msg_stats)
+{
+	for (auto &callback : callbacks_) {
+		WsMsgStats stats;
+		stats.msg = callback.msg;
+		callback.parse_ns->Snapshot(stats.parse_ns);
+		msg_stats.push_back(stats);
+	}
+
+	if (trade_) {
+		for (int i = TradeBinMsg_InsertOrder; i <= TradeBinMsg_CancelOrder; i++) {
+			WsMsgStats stats;
+			stats.msg = std::string("bin_") + g_trade_bin_msg[i];
+			bin_parse_ns_[i].Snapshot(stats.parse_ns);
+			msg_stats.push_back(stats);
 		}
+
+		WsMsgStats bin_invalid_stats;
+		bin_invalid_stats.msg = "bin_invalid";
+		bin_parse_ns_[TradeBinMsg_Unknown].Snapshot(bin_invalid_stats.parse_ns);
+		msg_stats.push_back(bin_invalid_stats);
+	}
+
+	WsMsgStats unknown_stats;
+	unknown_stats.msg = "unknown";
+	parse_unknown_ns_.Snapshot(unknown_stats.parse_ns);
+	msg_stats.push_back(unknown_stats);
+
+	WsMsgStats invalid_stats;
+	invalid_stats.msg = "invalid";
+	parse_invalid_ns_.Snapshot(invalid_stats.parse_ns);
+	msg_stats.push_back(invalid_stats);
+}
+
+void WsService::GetShardStats(std::vector<WsShardStats> &shard_stats)
+{
+	for (size_t i = 0; i < shards_.size(); i++) {
+		WsShard *shard = shards_[i].get();
+
+		WsShardStats stats;
+		stats.shard = (int)i;
+		stats.depth = shard->depth.load(std::memory_order_relaxed);
+		stats.peak_depth = shard->peak_depth.load(std::memory_order_relaxed);
+		stats.processed = shard->processed.load(std::memory_order_relaxed);
+		shard->put_depth.Snapshot(stats.put_depth);
+		shard_stats.push_back(stats);
+	}
+}
+void WsService::GetLaneStats(std::vector<WsLaneStats> &lane_stats)
+{
+	for (int i = 0; i < WsLane_Max; i++) {
+		WsLaneStats stats;
+		stats.lane = g_ws_lanes[i];
+		stats.processed = lane_processed_[i].load(std::memory_order_relaxed);
+		lane_wait_ns_[i].Snapshot(stats.wait_ns);
+		lane_stats.push_back(stats);
+	}
+}
+
+void WsService::GetOutboxStats(std::vector<WsOutboxStats> &outbox_stats)
+{
+	for (size_t i = 0; i < outboxes_.size(); i++) {
+		WsOutboxStats stats = WsOutboxStats();
+		stats.hub = (int)i;
+		outboxes_[i]->GetStats(stats);
+		outbox_stats.push_back(stats);
+	}
+}
+
+void WsService::MessageLoop(WsShard *shard)
+{
+	int64_t next_query_ns = 0;
+	std::unique_lock<std::mutex> lock(shard->mtx);
+	while (true) {
+		WsRequest *req = TakeMsg(shard, lock, next_query_ns);
+		shard->depth--;
+		lock.unlock();
+
+		int lane = req->lane_;
+		int64_t wait_ns = SteadyNowNs() - req->put_ns_;
+		lane_wait_ns_[lane].Record(wait_ns > 0 ? (uint64_t)wait_ns : 0);
+
+		Dispatch(req);
+		ReleaseRequest(req);
+		shard->processed++;
+		lane_processed_[lane]++;
+
+		lock.lock();
 	}
 }
 
 void WsService::RegisterCallbacks()
 {
+	if (quote_)
+	{
+		RegisterCallback("sub", WsLane_Order, std::bind(&QuoteService::OnReqSub, quote_, std::placeholders::_1, std::placeholders::_2));
+		RegisterCallback("unsub", WsLane_Order, std::bind(&QuoteService::OnReqUnsub, quote_, std::placeholders::_1, std::placeholders::_2));
+	}
 	if (trade_)
 	{
-		callbacks_["insert_order"] = std::bind(&TradeService::OnReqInsertOrder, trade_, std::placeholders::_1, std::placeholders::_2);
-		callbacks_["cancel_order"] = std::bind(&TradeService::OnReqCancelOrder, trade_, std::placeholders::_1, std::placeholders::_2);
-		callbacks_["query_order"] = std::bind(&TradeService::OnReqQueryOrder, trade_, std::placeholders::_1, std::placeholders::_2);
-		callbacks_["query_trade"] = std::bind(&TradeService::OnReqQueryTrade, trade_, std::placeholders::_1, std::placeholders::_2);
-		callbacks_["query_position"] = std::bind(&TradeService::OnReqQueryPosition, trade_, std::placeholders::_1, std::placeholders::_2);
-		callbacks_["query_positiondetail"] = std::bind(&TradeService::OnReqQueryPositionDetail, trade_, std::placeholders::_1, std::placeholders::_2);
-		callbacks_["query_tradeaccount"] = std::bind(&TradeService::OnReqQueryTradeAccount, trade_, std::placeholders::_1, std::placeholders::_2);
-		callbacks_["query_product"] = std::bind(&TradeService::OnReqQueryProduct, trade_, std::placeholders::_1, std::placeholders::_2);
+		RegisterCallback("insert_order", WsLane_Order, std::bind(&TradeService::OnReqInsertOrder, trade_, std::placeholders::_1, std::placeholders::_2));
+		RegisterCallback("cancel_order", WsLane_Order, std::bind(&TradeService::OnReqCancelOrder, trade_, std::placeholders::_1, std::placeholders::_2));
+		RegisterCallback("query_order", WsLane_Query, std::bind(&TradeService::OnReqQueryOrder, trade_, std::placeholders::_1, std::placeholders::_2));
+		RegisterCallback("query_trade", WsLane_Query, std::bind(&TradeService::OnReqQueryTrade, trade_, std::placeholders::_1, std::placeholders::_2));
+		RegisterCallback("query_position", WsLane_Query, std::bind(&TradeService::OnReqQueryPosition, trade_, std::placeholders::_1, std::placeholders::_2));
+		RegisterCallback("query_positiondetail", WsLane_Query, std::bind(&TradeService::OnReqQueryPositionDetail, trade_, std::placeholders::_1, std::placeholders::_2));
+		RegisterCallback("query_tradeaccount", WsLane_Query, std::bind(&TradeService::OnReqQueryTradeAccount, trade_, std::placeholders::_1, std::placeholders::_2));
+		RegisterCallback("query_product", WsLane_Query, std::bind(&TradeService::OnReqQueryProduct, trade_, std::placeholders::_1, std::placeholders::_2));
 	}
-	
+
+	std::vector<const char*> msgs;
+	for (auto &callback : callbacks_) {
+		msgs.push_back(callback.msg);
+	}
+	callback_hash_.Build(msgs);
 }
-void WsService::Dispatch(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc)
+void WsService::RegisterCallback(const char *msg, int lane, std::function<void(WsConnHandle, rapidjson::Document&)> fn)
 {
+	WsCallback callback;
+	callback.msg = msg;
+	callback.lane = lane;
+	callback.fn = fn;
+	callback.parse_ns.reset(new Histogram());
+	callbacks_.push_back(std::move(callback));
+}
+// route by msg in the loop thread, the lane is needed before the request is queued
+void WsService::FindCallback(WsRequest *req)
+{
+	rapidjson::Document &doc = req->doc_;
+	if (doc.IsObject())
+	{
+		auto msg = doc.FindMember("msg");
+		if (msg != doc.MemberEnd() && msg->value.IsString())
+		{
+			req->has_msg_ = true;
+			req->callback_ = callback_hash_.Find(msg->value.GetString(), msg->value.GetStringLength());
+		}
+	}
+
+	if (req->callback_ >= 0)
+	{
+		WsCallback &callback = callbacks_[req->callback_];
+		callback.parse_ns->Record(req->parse_ns_);
+		req->lane_ = callback.lane;
+	}
+	else
+	{
+		parse_unknown_ns_.Record(req->parse_ns_);
+		req->lane_ = WsLane_Order;
+	}
+}
+void WsService::Dispatch(WsRequest *req)
+{
+	if (req->bin_type_ != TradeBinMsg_Unknown) {
+		DispatchBin(req);
+		return;
+	}
+
+	WsConnHandle conn = req->conn_;
+	rapidjson::Document &doc = req->doc_;
+	WsCallback *callback = req->callback_ >= 0 ? &callbacks_[req->callback_] : nullptr;
+
 	try
 	{
-		if (!doc["msg"].IsString()) throw std::runtime_error("field \"msg\" need string");
+		if (!req->has_msg_) throw std::runtime_error("field \"msg\" need string");
 
-		auto it = callbacks_.find(doc["msg"].GetString());
-		if (it != callbacks_.end())
+		if (callback)
 		{
-			it->second(ws, doc);
+			callback->fn(conn, doc);
 		}
 		else
 		{
-			OnClientMsgError(ws, doc,
+			OnClientMsgError(conn, &doc,
 				BABELTRADER_ERR_WSREQ_NOT_HANDLE,
 				BABELTRADER_ERR_MSG[BABELTRADER_ERR_WSREQ_NOT_HANDLE - BABELTRADER_ERR_BEGIN]);
 		}
@@ -149,25 +525,48 @@ void WsService::Dispatch(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &d
 			BABELTRADER_ERR_MSG[BABELTRADER_ERR_WSREQ_FAILED_HANDLE - BABELTRADER_ERR_BEGIN]) + std::string(" - ") + e.what();
 
 		// response error
-		OnClientMsgError(ws, doc,
+		OnClientMsgError(conn, &doc,
 			BABELTRADER_ERR_WSREQ_FAILED_HANDLE,
 			error_msg.c_str());
 	}
 }
 
-void WsService::OnClientMsgError(uWS::WebSocket<uWS::SERVER> *ws, const char *message, size_t length, int error_id, const char  *error_msg)
+void WsService::DispatchBin(WsRequest *req)
 {
-	rapidjson::Document doc;
-	doc.Parse<0>(message, length);
-	if (doc.HasParseError()) {
-		LOG(WARNING) << "failed parse json from message";
-		LOG(WARNING).write(message, length);
-		return;
+	try
+	{
+		switch (req->bin_type_)
+		{
+		case TradeBinMsg_InsertOrder:
+		{
+			std::unique_lock<std::mutex> lock(trade_->req_mtx_);
+			trade_->InsertOrder(req->conn_, req->order_);
+		}break;
+		case TradeBinMsg_CancelOrder:
+		{
+			std::unique_lock<std::mutex> lock(trade_->req_mtx_);
+			trade_->CancelOrder(req->conn_, req->order_);
+		}break;
+		default:
+			OnClientBinMsgError(req->conn_, req->bin_type_, &req->order_,
+				BABELTRADER_ERR_WSREQ_NOT_HANDLE,
+				BABELTRADER_ERR_MSG[BABELTRADER_ERR_WSREQ_NOT_HANDLE - BABELTRADER_ERR_BEGIN]);
+			break;
+		}
 	}
+	catch (std::exception &e)
+	{
+		auto error_msg = std::string(
+			BABELTRADER_ERR_MSG[BABELTRADER_ERR_WSREQ_FAILED_HANDLE - BABELTRADER_ERR_BEGIN]) + std::string(" - ") + e.what();
 
-	OnClientMsgError(ws, doc, error_id, error_msg);
+		OnClientBinMsgError(req->conn_, req->bin_type_, &req->order_,
+			BABELTRADER_ERR_WSREQ_FAILED_HANDLE,
+			error_msg.c_str());
+	}
 }
-void WsService::OnClientMsgError(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc, int error_id, const char  *error_msg)
+
+// data is the request already parsed, null when the request is not valid json
+void WsService::OnClientMsgError(WsConnHandle conn, rapidjson::Value *data, int error_id, const char  *error_msg)
 {
 	rapidjson::StringBuffer s;
 	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
@@ -180,17 +579,26 @@ void WsService::OnClientMsgError(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Doc
 	writer.Key("error_msg");
 	writer.String(error_msg);
 	writer.Key("data");
-	doc.Accept(writer);
+	if (data) {
+		data->Accept(writer);
+	}
+	else {
+		writer.Null();
+	}
 	writer.EndObject();
 
 	LOG(INFO) << s.GetString();
 
-	{
-		std::unique_lock<std::mutex> lock(ws_mtx_);
-		if (ws_set_.find(ws) != ws_set_.end()) {
-			ws->send(s.GetString());
-		}
-	}
+	SendMsgToClient(conn, s.GetString());
+}
+void WsService::OnClientBinMsgError(WsConnHandle conn, uint8_t req_msg_type, const Order *order, int error_id, const char *error_msg)
+{
+	std::string rsp;
+	TradeBinSerializeError(req_msg_type, error_id, error_msg, order, rsp);
+
+	LOG(INFO) << "binary order error: " << error_id << ", " << error_msg;
+
+	ConnOutbox(conn).Send(conn, rsp.data(), rsp.size(), uWS::OpCode::BINARY);
 }
 
 
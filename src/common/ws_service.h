@@ -3,63 +3,207 @@
 
 #include <functional>
 #include <thread>
-#include <set>
+#include <map>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 
 #include "uWS/uWS.h"
 #include "rapidjson/document.h"
-#include "muggle/cpp/tunnel/tunnel.hpp"
 
 #include "common/quote_service.h"
 #include "common/trade_service.h"
+#include "common/histogram.h"
+#include "common/trade_binary.h"
+#include "common/json_schema.h"
+#include "common/ws_conn_table.h"
+#include "common/ws_outbox.h"
 
 namespace babeltrader
 {
 
+// chunk for the pool allocator of a request, a usual request is parsed without any malloc
+#define WS_REQUEST_CHUNK_SIZE 4096
+#define WS_REQUEST_POOL_MAX 256
+// text buffer bigger than this is freed when the request goes back to pool
+#define WS_REQUEST_KEEP_MAX (1024 * 1024)
+#define WS_SHARDS_MAX 64
+#define WS_HUBS_MAX 16
+
+// order actions always go first, queries are paced by the query rate
+enum WsLaneEnum
+{
+	WsLane_Order = 0,	// orders, cancels, subscriptions and anything failed early
+	WsLane_Query,		// queries, may answer thousands of rows
+	WsLane_Max,
+};
+extern const char *g_ws_lanes[WsLane_Max];
+
+struct WsMsgStats
+{
+	std::string msg;
+	HistogramSnapshot parse_ns;
+};
+
+struct WsShardStats
+{
+	int shard;
+	int64_t depth;			// requests in queue now
+	int64_t peak_depth;
+	uint64_t processed;
+	HistogramSnapshot put_depth;	// depth seen by each request when queued
+};
+
+struct WsLaneStats
+{
+	std::string lane;
+	uint64_t processed;
+	HistogramSnapshot wait_ns;	// from queued to dispatched
+};
+
 class WsService
 {
 private:
-	struct WsTunnelMsg
+	// an inbound request, doc is parsed in-situ from text, so its strings point into text.
+	// binary order requests are decoded into order instead, bin_type is not 0 for them.
+	// requests are pooled, text, order and allocator chunk are reused by the next message
+	struct WsRequest
 	{
-		WsTunnelMsg(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &&doc)
-			: ws_(ws)
-			, doc_(std::move(doc))
+		WsRequest()
+			: conn_(WS_CONN_INVALID)
+			, allocator_(chunk_, sizeof(chunk_))
+			, doc_(&allocator_)
+			, parse_ns_(0)
+			, put_ns_(0)
+			, callback_(-1)
+			, has_msg_(false)
+			, lane_(WsLane_Order)
+			, bin_type_(TradeBinMsg_Unknown)
 		{}
 
-		uWS::WebSocket<uWS::SERVER> *ws_;
+		WsRequest(const WsRequest&) = delete;
+		WsRequest& operator=(const WsRequest&) = delete;
+
+		WsConnHandle conn_;
+		std::vector<char> text_;
+		char chunk_[WS_REQUEST_CHUNK_SIZE];
+		rapidjson::MemoryPoolAllocator<> allocator_;
 		rapidjson::Document doc_;
+		uint64_t parse_ns_;
+		int64_t put_ns_;
+		int callback_;		// index of callbacks, -1 when msg is not registered
+		bool has_msg_;
+		int lane_;
+		uint8_t bin_type_;
+		Order order_;
+	};
+
+	struct WsCallback
+	{
+		const char *msg;
+		int lane;
+		std::function<void(WsConnHandle, rapidjson::Document&)> fn;
+		std::unique_ptr<Histogram> parse_ns;
+	};
+
+	// a dispatch thread and its lanes. a connection always goes to the same shard,
+	// so requests of one client in the same lane are handled in order, and a slow
+	// request only delays the clients sharing its shard
+	struct WsShard
+	{
+		WsShard()
+			: depth(0)
+			, peak_depth(0)
+			, processed(0)
+		{}
+
+		std::mutex mtx;
+		std::condition_variable cv;
+		std::deque<WsRequest*> lanes[WsLane_Max];
+		std::atomic<int64_t> depth;
+		std::atomic<int64_t> peak_depth;
+		std::atomic<uint64_t> processed;
+		Histogram put_depth;
 	};
 
 public:
-	WsService(QuoteService *quote_service, TradeService *trade_service);
+	// hubs: number of uWS hubs, each runs its own loop thread and listens on the same port
+	// shards: number of dispatch threads
+	// query_rate: queries each shard dispatches per second, 0 means no limit
+	WsService(QuoteService *quote_service, TradeService *trade_service, int hubs = 1, int shards = 1, int query_rate = 0);
 
-	void onConnection(uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest &req);
+	int Hubs() const { return (int)hubs_.size(); }
+	uWS::Hub& Hub(int hub) { return *hubs_[hub]; }
+
+	// hub is the index of the hub accepted the connection
+	void onConnection(int hub, uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest &req);
 	void onDisconnection(uWS::WebSocket<uWS::SERVER> *ws, int code, char *message, size_t length);
 	void onMessage(uWS::WebSocket<uWS::SERVER> *ws, char *message, size_t length, uWS::OpCode opCode);
 
-	int PutMsg(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &&doc);
+	void SendMsgToClient(WsConnHandle conn, const char *msg);
+
+	WsConnTable& Conns() { return conns_; }
+	WsOutbox& Outbox(int hub) { return *outboxes_[hub]; }
+	// outbox of the hub owning the connection, hub 0 when it is gone
+	WsOutbox& ConnOutbox(WsConnHandle conn) { return *outboxes_[WsConnHub(conns_.PeekFlags(conn))]; }
 
-	void SendMsgToClient(uWS::WebSocket<uWS::SERVER> *ws, const char *msg);
+	// binary order connections get bin, others get json
+	bool HasBinClients() const { return bin_clients_.load(std::memory_order_relaxed) > 0; }
+	void BroadcastTradeMsg(const char *json, size_t json_len, const std::string &bin);
+
+	void GetMsgStats(std::vector<WsMsgStats> &msg_stats);
+	void GetShardStats(std::vector<WsShardStats> &shard_stats);
+	void GetLaneStats(std::vector<WsLaneStats> &lane_stats);
+	void GetOutboxStats(std::vector<WsOutboxStats> &outbox_stats);
 
 private:
-	void MessageLoop();
+	void MessageLoop(WsShard *shard);
+
+	WsRequest* GetRequest();
+	void ReleaseRequest(WsRequest *req);
+	void PutMsg(WsRequest *req);
+	WsRequest* TakeMsg(WsShard *shard, std::unique_lock<std::mutex> &lock, int64_t &next_query_ns);
 
 	void RegisterCallbacks();
-	void Dispatch(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc);
+	void RegisterCallback(const char *msg, int lane, std::function<void(WsConnHandle, rapidjson::Document&)> fn);
+	void FindCallback(WsRequest *req);
+	void Dispatch(WsRequest *req);
 
-	void OnClientMsgError(uWS::WebSocket<uWS::SERVER> *ws, const char *message, size_t length, int error_id, const char  *error_msg);
-	void OnClientMsgError(uWS::WebSocket<uWS::SERVER> *ws, rapidjson::Document &doc, int error_id, const char  *error_msg);
+	void OnBinMessage(WsConnHandle conn, char *message, size_t length);
+	void DispatchBin(WsRequest *req);
+
+	void OnClientMsgError(WsConnHandle conn, rapidjson::Value *data, int error_id, const char  *error_msg);
+	void OnClientBinMsgError(WsConnHandle conn, uint8_t req_msg_type, const Order *order, int error_id, const char *error_msg);
 
 private:
 	QuoteService *quote_;
 	TradeService *trade_;
 
-	std::map<std::string, std::function<void(uWS::WebSocket<uWS::SERVER>*, rapidjson::Document&)>> callbacks_;
-	std::function<void(uWS::WebSocket<uWS::SERVER>*, rapidjson::Document&)> default_callback_;
-
-	muggle::Tunnel<WsTunnelMsg> msg_tunnel_;
-
-	std::mutex ws_mtx_;
-	std::set<uWS::WebSocket<uWS::SERVER>*> ws_set_;
+	// filled before message loops start, read only after that.
+	// msg is routed with a perfect hash over the registered names
+	std::vector<WsCallback> callbacks_;
+	JsonKeyHash callback_hash_;
+	Histogram parse_unknown_ns_;	// valid json without a registered msg
+	Histogram parse_invalid_ns_;	// failed parse
+	Histogram bin_parse_ns_[TradeBinMsg_Max];	// binary order requests, 0 for failed
+
+	std::vector<std::unique_ptr<WsShard>> shards_;
+	int64_t query_interval_ns_;	// 0 means no limit
+	std::atomic<uint64_t> lane_processed_[WsLane_Max];
+	Histogram lane_wait_ns_[WsLane_Max];
+
+	std::mutex pool_mtx_;
+	std::vector<WsRequest*> pool_;
+
+	// handle of a connection is kept in its user data, shared by all hubs
+	WsConnTable conns_;
+	// every socket write of other threads goes through the loop of the socket's hub
+	std::vector<std::unique_ptr<uWS::Hub>> hubs_;
+	std::vector<std::unique_ptr<WsOutbox>> outboxes_;
+	std::atomic<int> bin_clients_;	// connections of /ws/order
 };
 
 
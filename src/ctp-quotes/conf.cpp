@@ -98,6 +98,8 @@ bool LoadConfig(const std::string &file_path, CTPQuoteConf &conf)
 				conf.default_sub_topics.push_back(topics[i].GetString());
 			}
 		}
+
+		babeltrader::LoadQuoteServiceConf(doc, conf.quote_service);
 	} catch (std::exception e) {
 		LOG(ERROR) << e.what();
 		ret = false;
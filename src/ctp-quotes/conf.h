@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include "common/quote_conf.h"
+
 struct CTPQuoteConf
 {
 	std::string broker_id;
@@ -13,6 +15,7 @@ struct CTPQuoteConf
 	std::string quote_ip;
 	int quote_port;
 	std::vector<std::string> default_sub_topics;
+	babeltrader::QuoteServiceConf quote_service;
 };
 
 bool LoadConfig(const std::string &file_path, CTPQuoteConf &conf);
@@ -8,10 +8,11 @@
 #include "common/utils_func.h"
 
 CTPQuoteHandler::CTPQuoteHandler(CTPQuoteConf &conf)
-	: api_(nullptr)
+	: QuoteService(conf.quote_service)
+	, api_(nullptr)
 	, conf_(conf)
 	, req_id_(1)
-	, ws_service_(this, nullptr)
+	, ws_service_(this, nullptr, conf.quote_service.ws_hubs)
 	, http_service_(this, nullptr)
 {}
 
@@ -246,30 +247,37 @@ void CTPQuoteHandler::RunService()
 {
 	RunAsyncLoop();
 
-	auto loop_thread = std::thread([&] {
-		uws_hub_.onConnection([&](uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest req) {
-			ws_service_.onConnection(ws, req);
-		});
-		uws_hub_.onMessage([&](uWS::WebSocket<uWS::SERVER> *ws, char *message, size_t length, uWS::OpCode opCode) {
-			ws_service_.onMessage(ws, message, length, opCode);
-		});
-		uws_hub_.onDisconnection([&](uWS::WebSocket<uWS::SERVER> *ws, int code, char *message, size_t length) {
-			ws_service_.onDisconnection(ws, code, message, length);
-		});
-
-		// rest
-		uws_hub_.onHttpRequest([&](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t length, size_t remainingBytes) {
-			http_service_.onMessage(res, req, data, length, remainingBytes);
+	// every hub listens on the same port, the kernel spreads new connections over them
+	std::vector<std::thread> loop_threads;
+	for (int i = 0; i < ws_service_.Hubs(); i++) {
+		loop_threads.emplace_back([&, i] {
+			uWS::Hub &hub = ws_service_.Hub(i);
+			hub.onConnection([&, i](uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest req) {
+				ws_service_.onConnection(i, ws, req);
+			});
+			hub.onMessage([&](uWS::WebSocket<uWS::SERVER> *ws, char *message, size_t length, uWS::OpCode opCode) {
+				ws_service_.onMessage(ws, message, length, opCode);
+			});
+			hub.onDisconnection([&](uWS::WebSocket<uWS::SERVER> *ws, int code, char *message, size_t length) {
+				ws_service_.onDisconnection(ws, code, message, length);
+			});
+
+			// rest
+			hub.onHttpRequest([&](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t length, size_t remainingBytes) {
+				http_service_.onMessage(res, req, data, length, remainingBytes);
+			});
+
+			if (!hub.listen(conf_.quote_ip.c_str(), conf_.quote_port, nullptr, uS::ListenOptions::REUSE_PORT)) {
+				LOG(INFO) << "Failed to listen";
+				exit(-1);
+			}
+			hub.run();
 		});
+	}
 
-		if (!uws_hub_.listen(conf_.quote_ip.c_str(), conf_.quote_port, nullptr, uS::ListenOptions::REUSE_PORT)) {
-			LOG(INFO) << "Failed to listen";
-			exit(-1);
-		}
-		uws_hub_.run();
-	});
-
-	loop_thread.join();
+	for (auto &th : loop_threads) {
+		th.join();
+	}
 }
 
 void CTPQuoteHandler::DoLogin()
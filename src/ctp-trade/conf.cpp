@@ -92,6 +92,36 @@ bool LoadConfig(const std::string &file_path, CTPTradeConf &conf)
 			throw(std::runtime_error("can't find 'trade_listen_port' in config file"));
 		}
 
+		conf.ws_hubs = 1;
+		if (doc.HasMember("trade_ws_hubs") && doc["trade_ws_hubs"].IsInt())
+		{
+			conf.ws_hubs = doc["trade_ws_hubs"].GetInt();
+			if (conf.ws_hubs < 1 || conf.ws_hubs > 16)
+			{
+				throw(std::runtime_error("invalid 'trade_ws_hubs' in config file, need 1 ~ 16"));
+			}
+		}
+
+		conf.ws_shards = 1;
+		if (doc.HasMember("trade_ws_shards") && doc["trade_ws_shards"].IsInt())
+		{
+			conf.ws_shards = doc["trade_ws_shards"].GetInt();
+			if (conf.ws_shards < 1 || conf.ws_shards > 64)
+			{
+				throw(std::runtime_error("invalid 'trade_ws_shards' in config file, need 1 ~ 64"));
+			}
+		}
+
+		conf.ws_query_rate = 0;
+		if (doc.HasMember("trade_ws_query_rate") && doc["trade_ws_query_rate"].IsInt())
+		{
+			conf.ws_query_rate = doc["trade_ws_query_rate"].GetInt();
+			if (conf.ws_query_rate < 0)
+			{
+				throw(std::runtime_error("invalid 'trade_ws_query_rate' in config file, need non-negative int"));
+			}
+		}
+
 		if (doc.HasMember("product_info") && doc["product_info"].IsInt())
 		{
 			conf.product_info = doc["product_info"].GetString();
@@ -11,6 +11,9 @@ struct CTPTradeConf
 	std::string addr;
 	std::string trade_ip;
 	int trade_port;
+	int ws_hubs;		// uWS hubs listening on trade port, one loop thread each
+	int ws_shards;		// ws request dispatch threads
+	int ws_query_rate;	// queries per second of each dispatch thread, 0 means no limit
 	std::string product_info;
 	std::string auth_code;
 };
@@ -24,7 +24,7 @@ CTPTradeHandler::CTPTradeHandler(CTPTradeConf &conf)
 	: api_(nullptr)
 	, api_ready_(false)
 	, conf_(conf)
-	, ws_service_(nullptr, this)
+	, ws_service_(nullptr, this, conf.ws_hubs, conf.ws_shards, conf.ws_query_rate)
 	, http_service_(nullptr, this)
 	, req_id_(1)
 	, order_ref_(1)
@@ -42,7 +42,7 @@ void CTPTradeHandler::run()
 	RunService();
 }
 
-void CTPTradeHandler::InsertOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order)
+void CTPTradeHandler::InsertOrder(WsConnHandle conn, Order &order)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -70,7 +70,7 @@ void CTPTradeHandler::InsertOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order)
 		throw std::runtime_error(buf);
 	}
 }
-void CTPTradeHandler::CancelOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order)
+void CTPTradeHandler::CancelOrder(WsConnHandle conn, Order &order)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -91,7 +91,7 @@ void CTPTradeHandler::CancelOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order)
 		throw std::runtime_error(buf);
 	}
 }
-void CTPTradeHandler::QueryOrder(uWS::WebSocket<uWS::SERVER> *ws, OrderQuery &order_query)
+void CTPTradeHandler::QueryOrder(WsConnHandle conn, OrderQuery &order_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -105,7 +105,7 @@ void CTPTradeHandler::QueryOrder(uWS::WebSocket<uWS::SERVER> *ws, OrderQuery &or
 	OutputOrderQuery(&req);
 
 	// cache query order
-	qry_cache_.CacheQryOrder(req_id_, ws, order_query);
+	qry_cache_.CacheQryOrder(req_id_, conn, order_query);
 
 	int ret = api_->ReqQryOrder(&req, req_id_++);
 	if (ret != 0)
@@ -117,7 +117,7 @@ void CTPTradeHandler::QueryOrder(uWS::WebSocket<uWS::SERVER> *ws, OrderQuery &or
 		throw std::runtime_error(buf);
 	}
 }
-void CTPTradeHandler::QueryTrade(uWS::WebSocket<uWS::SERVER> *ws, TradeQuery &trade_query)
+void CTPTradeHandler::QueryTrade(WsConnHandle conn, TradeQuery &trade_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -131,7 +131,7 @@ void CTPTradeHandler::QueryTrade(uWS::WebSocket<uWS::SERVER> *ws, TradeQuery &tr
 	OutputTradeQuery(&req);
 
 	// cache query order
-	qry_cache_.CacheQryTrade(req_id_, ws, trade_query);
+	qry_cache_.CacheQryTrade(req_id_, conn, trade_query);
 
 	int ret = api_->ReqQryTrade(&req, req_id_++);
 	if (ret != 0)
@@ -143,7 +143,7 @@ void CTPTradeHandler::QueryTrade(uWS::WebSocket<uWS::SERVER> *ws, TradeQuery &tr
 		throw std::runtime_error(buf);
 	}
 }
-void CTPTradeHandler::QueryPosition(uWS::WebSocket<uWS::SERVER> *ws, PositionQuery &position_query)
+void CTPTradeHandler::QueryPosition(WsConnHandle conn, PositionQuery &position_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -157,7 +157,7 @@ void CTPTradeHandler::QueryPosition(uWS::WebSocket<uWS::SERVER> *ws, PositionQue
 	OutputPositionQuery(&req);
 
 	// cache query position
-	qry_cache_.CacheQryPosition(req_id_, ws, position_query);
+	qry_cache_.CacheQryPosition(req_id_, conn, position_query);
 
 	int ret = api_->ReqQryInvestorPosition(&req, req_id_++);
 	if (ret != 0)
@@ -169,7 +169,7 @@ void CTPTradeHandler::QueryPosition(uWS::WebSocket<uWS::SERVER> *ws, PositionQue
 		throw std::runtime_error(buf);
 	}
 }
-void CTPTradeHandler::QueryPositionDetail(uWS::WebSocket<uWS::SERVER> *ws, PositionQuery &position_query)
+void CTPTradeHandler::QueryPositionDetail(WsConnHandle conn, PositionQuery &position_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -183,7 +183,7 @@ void CTPTradeHandler::QueryPositionDetail(uWS::WebSocket<uWS::SERVER> *ws, Posit
 	OutputPositionDetailQuery(&req);
 
 	// cache query position detail
-	qry_cache_.CacheQryPositionDetail(req_id_, ws, position_query);
+	qry_cache_.CacheQryPositionDetail(req_id_, conn, position_query);
 
 	int ret = api_->ReqQryInvestorPositionDetail(&req, req_id_++);
 	if (ret != 0)
@@ -195,7 +195,7 @@ void CTPTradeHandler::QueryPositionDetail(uWS::WebSocket<uWS::SERVER> *ws, Posit
 		throw std::runtime_error(buf);
 	}
 }
-void CTPTradeHandler::QueryTradeAccount(uWS::WebSocket<uWS::SERVER> *ws, TradeAccountQuery &tradeaccount_query)
+void CTPTradeHandler::QueryTradeAccount(WsConnHandle conn, TradeAccountQuery &tradeaccount_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -209,7 +209,7 @@ void CTPTradeHandler::QueryTradeAccount(uWS::WebSocket<uWS::SERVER> *ws, TradeAc
 	OutputTradeAccountQuery(&req);
 
 	// cache query trade account
-	qry_cache_.CacheQryTradeAccount(req_id_, ws, tradeaccount_query);
+	qry_cache_.CacheQryTradeAccount(req_id_, conn, tradeaccount_query);
 
 	int ret = api_->ReqQryTradingAccount(&req, req_id_++);
 	if (ret != 0)
@@ -221,7 +221,7 @@ void CTPTradeHandler::QueryTradeAccount(uWS::WebSocket<uWS::SERVER> *ws, TradeAc
 		throw std::runtime_error(buf);
 	}
 }
-void CTPTradeHandler::QueryProduct(uWS::WebSocket<uWS::SERVER> *ws, ProductQuery &product_query)
+void CTPTradeHandler::QueryProduct(WsConnHandle conn, ProductQuery &product_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -236,7 +236,7 @@ void CTPTradeHandler::QueryProduct(uWS::WebSocket<uWS::SERVER> *ws, ProductQuery
 
 		OutputProductQuery(&req);
 
-		qry_cache_.CacheQryProduct(req_id_, ws, product_query);
+		qry_cache_.CacheQryProduct(req_id_, conn, product_query);
 
 		int ret = api_->ReqQryProduct(&req, req_id_++);
 		if (ret != 0)
@@ -260,7 +260,7 @@ void CTPTradeHandler::QueryProduct(uWS::WebSocket<uWS::SERVER> *ws, ProductQuery
 
 		OutputInstrumentQuery(&req);
 
-		qry_cache_.CacheQryProduct(req_id_, ws, product_query);
+		qry_cache_.CacheQryProduct(req_id_, conn, product_query);
 
 		int ret = api_->ReqQryInstrument(&req, req_id_++);
 		if (ret != 0)
@@ -342,7 +342,8 @@ void CTPTradeHandler::OnRspUserLogout(CThostFtdcUserLogoutField *pUserLogout, CT
 }
 void CTPTradeHandler::OnRspSettlementInfoConfirm(CThostFtdcSettlementInfoConfirmField *pSettlementInfoConfirm, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
 {
-	
+	// price ticks of all instruments, order pushes print prices with them
+	DoQryInstruments();
 }
 
 void CTPTradeHandler::OnRspOrderInsert(CThostFtdcInputOrderField *pInputOrder, CThostFtdcRspInfoField *pRspInfo, int nRequestID, bool bIsLast)
@@ -419,12 +420,12 @@ void CTPTradeHandler::OnRspQryOrder(CThostFtdcOrderField *pOrder, CThostFtdcRspI
 
 	if (bIsLast)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		OrderQuery order_qry;
-		qry_cache_.GetAndClearCacheQryOrder(nRequestID, &ws, &order_qry);
+		qry_cache_.GetAndClearCacheQryOrder(nRequestID, &conn, &order_qry);
 		std::vector<CThostFtdcOrderField> &orders = rsp_qry_order_caches_[nRequestID];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<Order> common_orders;
 			std::vector<OrderStatusNotify> common_order_status;
@@ -441,7 +442,7 @@ void CTPTradeHandler::OnRspQryOrder(CThostFtdcOrderField *pOrder, CThostFtdcRspI
 			if (pRspInfo) {
 				error_id = pRspInfo->ErrorID;
 			}
-			RspOrderQry(ws, order_qry, common_orders, common_order_status, error_id);
+			RspOrderQry(conn, order_qry, common_orders, common_order_status, error_id);
 		}
 
 		rsp_qry_order_caches_.erase(nRequestID);
@@ -468,12 +469,12 @@ void CTPTradeHandler::OnRspQryTrade(CThostFtdcTradeField *pTrade, CThostFtdcRspI
 
 	if (bIsLast)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		TradeQuery trade_qry;
-		qry_cache_.GetAndClearCacheQryTrade(nRequestID, &ws, &trade_qry);
+		qry_cache_.GetAndClearCacheQryTrade(nRequestID, &conn, &trade_qry);
 		std::vector<CThostFtdcTradeField> &trades = rsp_qry_trade_caches_[nRequestID];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<Order> common_orders;
 			std::vector<OrderDealNotify> common_deals;
@@ -490,7 +491,7 @@ void CTPTradeHandler::OnRspQryTrade(CThostFtdcTradeField *pTrade, CThostFtdcRspI
 			if (pRspInfo) {
 				error_id = pRspInfo->ErrorID;
 			}
-			RspTradeQry(ws, trade_qry, common_orders, common_deals, error_id);
+			RspTradeQry(conn, trade_qry, common_orders, common_deals, error_id);
 		}
 
 		rsp_qry_trade_caches_.erase(nRequestID);
@@ -517,12 +518,12 @@ void CTPTradeHandler::OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *
 
 	if (bIsLast)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		PositionQuery position_qry;
-		qry_cache_.GetAndCleanCacheQryPosition(nRequestID, &ws, &position_qry);
+		qry_cache_.GetAndCleanCacheQryPosition(nRequestID, &conn, &position_qry);
 		std::vector<CThostFtdcInvestorPositionField> &ctp_positions = rsp_qry_position_caches_[nRequestID];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<PositionSummaryType1> positions;
 			for (CThostFtdcInvestorPositionField &ctp_position : ctp_positions)
@@ -536,7 +537,7 @@ void CTPTradeHandler::OnRspQryInvestorPosition(CThostFtdcInvestorPositionField *
 			if (pRspInfo) {
 				error_id = pRspInfo->ErrorID;
 			}
-			RspPositionQryType1(ws, position_qry, positions, error_id);
+			RspPositionQryType1(conn, position_qry, positions, error_id);
 		}
 
 		rsp_qry_position_caches_.erase(nRequestID);
@@ -563,12 +564,12 @@ void CTPTradeHandler::OnRspQryInvestorPositionDetail(CThostFtdcInvestorPositionD
 
 	if (bIsLast)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		PositionQuery position_detail_qry;
-		qry_cache_.GetAndCleanCacheQryPositionDetail(nRequestID, &ws, &position_detail_qry);
+		qry_cache_.GetAndCleanCacheQryPositionDetail(nRequestID, &conn, &position_detail_qry);
 		std::vector<CThostFtdcInvestorPositionDetailField> &ctp_position_details = rsp_qry_position_detail_caches_[nRequestID];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<PositionDetailType1> position_details;
 			for (CThostFtdcInvestorPositionDetailField &ctp_position_detail : ctp_position_details)
@@ -582,7 +583,7 @@ void CTPTradeHandler::OnRspQryInvestorPositionDetail(CThostFtdcInvestorPositionD
 			if (pRspInfo) {
 				error_id = pRspInfo->ErrorID;
 			}
-			RspPositionDetailQryType1(ws, position_detail_qry, position_details, error_id);
+			RspPositionDetailQryType1(conn, position_detail_qry, position_details, error_id);
 		}
 
 		rsp_qry_position_detail_caches_.erase(nRequestID);
@@ -609,12 +610,12 @@ void CTPTradeHandler::OnRspQryTradingAccount(CThostFtdcTradingAccountField *pTra
 
 	if (bIsLast)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		TradeAccountQuery trade_account_qry;
-		qry_cache_.GetAndCleanCacheQryTradeAccount(nRequestID, &ws, &trade_account_qry);
+		qry_cache_.GetAndCleanCacheQryTradeAccount(nRequestID, &conn, &trade_account_qry);
 		std::vector<CThostFtdcTradingAccountField> &ctp_trade_accounts = rsp_qry_trade_account_caches_[nRequestID];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<TradeAccountType1> trade_accounts;
 			for (CThostFtdcTradingAccountField &ctp_trade_account : ctp_trade_accounts)
@@ -628,7 +629,7 @@ void CTPTradeHandler::OnRspQryTradingAccount(CThostFtdcTradingAccountField *pTra
 			if (pRspInfo) {
 				error_id = pRspInfo->ErrorID;
 			}
-			RspTradeAccountQryType1(ws, trade_account_qry, trade_accounts, error_id);
+			RspTradeAccountQryType1(conn, trade_account_qry, trade_accounts, error_id);
 		}
 
 		rsp_qry_trade_account_caches_.erase(nRequestID);
@@ -655,12 +656,12 @@ void CTPTradeHandler::OnRspQryProduct(CThostFtdcProductField *pProduct, CThostFt
 
 	if (bIsLast)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		ProductQuery product_qry;
-		qry_cache_.GetAndCleanCacheQryProduct(nRequestID, &ws, &product_qry);
+		qry_cache_.GetAndCleanCacheQryProduct(nRequestID, &conn, &product_qry);
 		std::vector<CThostFtdcProductField> &ctp_products = rsp_qry_product_caches_[nRequestID];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<ProductType1> products;
 			for (CThostFtdcProductField &ctp_product : ctp_products)
@@ -674,7 +675,7 @@ void CTPTradeHandler::OnRspQryProduct(CThostFtdcProductField *pProduct, CThostFt
 			if (pRspInfo) {
 				error_id = pRspInfo->ErrorID;
 			}
-			RspProductQryType1(ws, product_qry, products, error_id);
+			RspProductQryType1(conn, product_qry, products, error_id);
 		}
 
 		rsp_qry_product_caches_.erase(nRequestID);
@@ -694,6 +695,10 @@ void CTPTradeHandler::OnRspQryInstrument(CThostFtdcInstrumentField *pInstrument,
 	}
 	if (pInstrument)
 	{
+		std::string symbol, contract;
+		CTPSplitInstrument(pInstrument->InstrumentID, symbol, contract);
+		price_ticks_.Set(symbol, contract, pInstrument->PriceTick);
+
 		CThostFtdcInstrumentField copy_product;
 		memcpy(&copy_product, pInstrument, sizeof(copy_product));
 		it->second.push_back(copy_product);
@@ -701,12 +706,12 @@ void CTPTradeHandler::OnRspQryInstrument(CThostFtdcInstrumentField *pInstrument,
 
 	if (bIsLast)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		ProductQuery product_qry;
-		qry_cache_.GetAndCleanCacheQryProduct(nRequestID, &ws, &product_qry);
+		qry_cache_.GetAndCleanCacheQryProduct(nRequestID, &conn, &product_qry);
 		std::vector<CThostFtdcInstrumentField> &ctp_products = rsp_qry_instrument_caches_[nRequestID];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<ProductType1> products;
 			for (CThostFtdcInstrumentField &ctp_product : ctp_products)
@@ -720,7 +725,7 @@ void CTPTradeHandler::OnRspQryInstrument(CThostFtdcInstrumentField *pInstrument,
 			if (pRspInfo) {
 				error_id = pRspInfo->ErrorID;
 			}
-			RspProductQryType1(ws, product_qry, products, error_id);
+			RspProductQryType1(conn, product_qry, products, error_id);
 		}
 
 		rsp_qry_instrument_caches_.erase(nRequestID);
@@ -747,30 +752,37 @@ void CTPTradeHandler::RunService()
 	std::thread th(&CTPTradeHandler::AsyncLoop, this);
 	th.detach();
 
-	auto loop_thread = std::thread([&] {
-		uws_hub_.onConnection([&](uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest req) {
-			ws_service_.onConnection(ws, req);
-		});
-		uws_hub_.onMessage([&](uWS::WebSocket<uWS::SERVER> *ws, char *message, size_t length, uWS::OpCode opCode) {
-			ws_service_.onMessage(ws, message, length, opCode);
-		});
-		uws_hub_.onDisconnection([&](uWS::WebSocket<uWS::SERVER> *ws, int code, char *message, size_t length) {
-			ws_service_.onDisconnection(ws, code, message, length);
-		});
-
-		// rest
-		uws_hub_.onHttpRequest([&](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t length, size_t remainingBytes) {
-			http_service_.onMessage(res, req, data, length, remainingBytes);
+	// every hub listens on the same port, the kernel spreads new connections over them
+	std::vector<std::thread> loop_threads;
+	for (int i = 0; i < ws_service_.Hubs(); i++) {
+		loop_threads.emplace_back([&, i] {
+			uWS::Hub &hub = ws_service_.Hub(i);
+			hub.onConnection([&, i](uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest req) {
+				ws_service_.onConnection(i, ws, req);
+			});
+			hub.onMessage([&](uWS::WebSocket<uWS::SERVER> *ws, char *message, size_t length, uWS::OpCode opCode) {
+				ws_service_.onMessage(ws, message, length, opCode);
+			});
+			hub.onDisconnection([&](uWS::WebSocket<uWS::SERVER> *ws, int code, char *message, size_t length) {
+				ws_service_.onDisconnection(ws, code, message, length);
+			});
+
+			// rest
+			hub.onHttpRequest([&](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t length, size_t remainingBytes) {
+				http_service_.onMessage(res, req, data, length, remainingBytes);
+			});
+
+			if (!hub.listen(conf_.trade_ip.c_str(), conf_.trade_port, nullptr, uS::ListenOptions::REUSE_PORT)) {
+				LOG(INFO) << "Failed to listen";
+				exit(-1);
+			}
+			hub.run();
 		});
+	}
 
-		if (!uws_hub_.listen(conf_.trade_ip.c_str(), conf_.trade_port, nullptr, uS::ListenOptions::REUSE_PORT)) {
-			LOG(INFO) << "Failed to listen";
-			exit(-1);
-		}
-		uws_hub_.run();
-	});
-
-	loop_thread.join();
+	for (auto &th : loop_threads) {
+		th.join();
+	}
 }
 
 void CTPTradeHandler::AsyncLoop()
@@ -901,6 +913,17 @@ void CTPTradeHandler::DoSettlementConfirm()
 	strncpy(confirm.InvestorID, conf_.user_id.c_str(), sizeof(confirm.InvestorID) - 1);
 	api_->ReqSettlementInfoConfirm(&confirm, req_id_++);
 }
+void CTPTradeHandler::DoQryInstruments()
+{
+	// no connection is cached for the request, responses only fill price ticks
+	CThostFtdcQryInstrumentField req = { 0 };
+	std::unique_lock<std::mutex> lock(req_mtx_);
+	int ret = api_->ReqQryInstrument(&req, req_id_++);
+	if (ret != 0)
+	{
+		LOG(WARNING) << "failed in ReqQryInstrument of price ticks, return " << ret;
+	}
+}
 
 void CTPTradeHandler::ConvertInsertOrderCommon2CTP(Order &order, CThostFtdcInputOrderField &req)
 {
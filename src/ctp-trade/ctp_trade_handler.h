@@ -6,6 +6,7 @@
 #include "ThostFtdcTraderApi.h"
 #include "rapidjson/writer.h"
 #include "rapidjson/stringbuffer.h"
+#include "muggle/cpp/tunnel/tunnel.hpp"
 
 #include "common/common_struct.h"
 #include "common/ws_service.h"
@@ -26,14 +27,14 @@ public:
 public:
 	////////////////////////////////////////
 	// trade service virtual function
-	virtual void InsertOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order) override;
-	virtual void CancelOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order) override;
-	virtual void QueryOrder(uWS::WebSocket<uWS::SERVER> *ws, OrderQuery &order_query) override;
-	virtual void QueryTrade(uWS::WebSocket<uWS::SERVER> *ws, TradeQuery &trade_query) override;
-	virtual void QueryPosition(uWS::WebSocket<uWS::SERVER> *ws, PositionQuery &position_query) override;
-	virtual void QueryPositionDetail(uWS::WebSocket<uWS::SERVER> *ws, PositionQuery &position_query) override;
-	virtual void QueryTradeAccount(uWS::WebSocket<uWS::SERVER> *ws, TradeAccountQuery &tradeaccount_query) override;
-	virtual void QueryProduct(uWS::WebSocket<uWS::SERVER> *ws, ProductQuery &query_product) override;
+	virtual void InsertOrder(WsConnHandle conn, Order &order) override;
+	virtual void CancelOrder(WsConnHandle conn, Order &order) override;
+	virtual void QueryOrder(WsConnHandle conn, OrderQuery &order_query) override;
+	virtual void QueryTrade(WsConnHandle conn, TradeQuery &trade_query) override;
+	virtual void QueryPosition(WsConnHandle conn, PositionQuery &position_query) override;
+	virtual void QueryPositionDetail(WsConnHandle conn, PositionQuery &position_query) override;
+	virtual void QueryTradeAccount(WsConnHandle conn, TradeAccountQuery &tradeaccount_query) override;
+	virtual void QueryProduct(WsConnHandle conn, ProductQuery &query_product) override;
 
 	////////////////////////////////////////
 	// spi virtual function
@@ -79,6 +80,7 @@ private:
 	void DoAuthenticate();
 	void DoLogin();
 	void DoSettlementConfirm();
+	void DoQryInstruments();
 
 	////////////////////////////////////////
 	// convert common struct to ctp struct
@@ -153,6 +153,8 @@ bool LoadConfig(const std::string &file_path, XTPQuoteConf &conf)
 				conf.default_sub_topics.push_back(std::move(quote));
 			}
 		}
+
+		LoadQuoteServiceConf(doc, conf.quote_service);
 	}
 	catch (std::exception e) {
 		LOG(ERROR) << e.what();
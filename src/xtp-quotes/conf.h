@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "common/common_struct.h"
+#include "common/quote_conf.h"
 
 using namespace babeltrader;
 
@@ -24,6 +25,7 @@ struct XTPQuoteConf
 	int sub_orderbook;
 	int sub_l2;
 	std::vector<Quote> default_sub_topics;
+	QuoteServiceConf quote_service;
 };
 
 bool LoadConfig(const std::string &file_path, XTPQuoteConf &conf);
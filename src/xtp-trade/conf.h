@@ -14,6 +14,9 @@ struct XTPTradeConf
 	std::string key;
 	std::string trade_ip;
 	int trade_port;
+	int ws_hubs;		// uWS hubs listening on trade port, one loop thread each
+	int ws_shards;		// ws request dispatch threads
+	int ws_query_rate;	// queries per second of each dispatch thread, 0 means no limit
 };
 
 bool LoadConfig(const std::string &file_path, XTPTradeConf &conf);
@@ -12,7 +12,7 @@ XTPTradeHandler::XTPTradeHandler(XTPTradeConf &conf)
 	, api_ready_(false)
 	, xtp_session_id_(0)
 	, conf_(conf)
-	, ws_service_(nullptr, this)
+	, ws_service_(nullptr, this, conf.ws_hubs, conf.ws_shards, conf.ws_query_rate)
 	, http_service_(nullptr, this)
 	, req_id_(1)
 	, order_ref_(1)
@@ -27,7 +27,7 @@ void XTPTradeHandler::run()
 	RunService();
 }
 
-void XTPTradeHandler::InsertOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order)
+void XTPTradeHandler::InsertOrder(WsConnHandle conn, Order &order)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -51,7 +51,7 @@ void XTPTradeHandler::InsertOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order)
 		ThrowXTPLastError("failed insert order");
 	}
 }
-void XTPTradeHandler::CancelOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order)
+void XTPTradeHandler::CancelOrder(WsConnHandle conn, Order &order)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -72,7 +72,7 @@ void XTPTradeHandler::CancelOrder(uWS::WebSocket<uWS::SERVER> *ws, Order &order)
 		ThrowXTPLastError("failed cancel order");
 	}
 }
-void XTPTradeHandler::QueryOrder(uWS::WebSocket<uWS::SERVER> *ws, OrderQuery &order_query)
+void XTPTradeHandler::QueryOrder(WsConnHandle conn, OrderQuery &order_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -90,7 +90,7 @@ void XTPTradeHandler::QueryOrder(uWS::WebSocket<uWS::SERVER> *ws, OrderQuery &or
 
 		OutputOrderQuery(order_xtp_id);
 
-		qry_cache_.CacheQryOrder(req_id_, ws, order_query);
+		qry_cache_.CacheQryOrder(req_id_, conn, order_query);
 
 		ret = api_->QueryOrderByXTPID(order_xtp_id, xtp_session_id_, req_id_++);
 	}
@@ -101,7 +101,7 @@ void XTPTradeHandler::QueryOrder(uWS::WebSocket<uWS::SERVER> *ws, OrderQuery &or
 
 		OutputOrderQuery(&req);
 
-		qry_cache_.CacheQryOrder(req_id_, ws, order_query);
+		qry_cache_.CacheQryOrder(req_id_, conn, order_query);
 
 		ret = api_->QueryOrders(&req, xtp_session_id_, req_id_++);
 	}
@@ -115,7 +115,7 @@ void XTPTradeHandler::QueryOrder(uWS::WebSocket<uWS::SERVER> *ws, OrderQuery &or
 		throw std::runtime_error(buf);
 	}
 }
-void XTPTradeHandler::QueryTrade(uWS::WebSocket<uWS::SERVER> *ws, TradeQuery &trade_query)
+void XTPTradeHandler::QueryTrade(WsConnHandle conn, TradeQuery &trade_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -133,7 +133,7 @@ void XTPTradeHandler::QueryTrade(uWS::WebSocket<uWS::SERVER> *ws, TradeQuery &tr
 
 		OutputTradeQuery(trade_xtp_id);
 
-		qry_cache_.CacheQryTrade(req_id_, ws, trade_query);
+		qry_cache_.CacheQryTrade(req_id_, conn, trade_query);
 
 		ret = api_->QueryTradesByXTPID(trade_xtp_id, xtp_session_id_, req_id_++);
 	}
@@ -144,7 +144,7 @@ void XTPTradeHandler::QueryTrade(uWS::WebSocket<uWS::SERVER> *ws, TradeQuery &tr
 
 		OutputTradeQuery(&req);
 
-		qry_cache_.CacheQryTrade(req_id_, ws, trade_query);
+		qry_cache_.CacheQryTrade(req_id_, conn, trade_query);
 
 		ret = api_->QueryTrades(&req, xtp_session_id_, req_id_++);
 	}
@@ -158,7 +158,7 @@ void XTPTradeHandler::QueryTrade(uWS::WebSocket<uWS::SERVER> *ws, TradeQuery &tr
 		throw std::runtime_error(buf);
 	}
 }
-void XTPTradeHandler::QueryPosition(uWS::WebSocket<uWS::SERVER> *ws, PositionQuery &position_query)
+void XTPTradeHandler::QueryPosition(WsConnHandle conn, PositionQuery &position_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -167,7 +167,7 @@ void XTPTradeHandler::QueryPosition(uWS::WebSocket<uWS::SERVER> *ws, PositionQue
 
 	OutputPositionQuery(position_query.symbol.c_str());
 
-	qry_cache_.CacheQryPosition(req_id_, ws, position_query);
+	qry_cache_.CacheQryPosition(req_id_, conn, position_query);
 
 	int ret = api_->QueryPosition(position_query.symbol.c_str(), xtp_session_id_, req_id_++);
 	if (ret != 0)
@@ -179,11 +179,11 @@ void XTPTradeHandler::QueryPosition(uWS::WebSocket<uWS::SERVER> *ws, PositionQue
 		throw std::runtime_error(buf);
 	}
 }
-void XTPTradeHandler::QueryPositionDetail(uWS::WebSocket<uWS::SERVER> *ws, PositionQuery &position_query)
+void XTPTradeHandler::QueryPositionDetail(WsConnHandle conn, PositionQuery &position_query)
 {
 	throw std::runtime_error("'QueryPositionDetail' not supported in xtp");
 }
-void XTPTradeHandler::QueryTradeAccount(uWS::WebSocket<uWS::SERVER> *ws, TradeAccountQuery &tradeaccount_query)
+void XTPTradeHandler::QueryTradeAccount(WsConnHandle conn, TradeAccountQuery &tradeaccount_query)
 {
 	if (api_ == nullptr || !api_ready_)
 	{
@@ -192,7 +192,7 @@ void XTPTradeHandler::QueryTradeAccount(uWS::WebSocket<uWS::SERVER> *ws, TradeAc
 
 	OutputAssetQuery(xtp_session_id_);
 
-	qry_cache_.CacheQryTradeAccount(req_id_, ws, tradeaccount_query);
+	qry_cache_.CacheQryTradeAccount(req_id_, conn, tradeaccount_query);
 
 	int ret = api_->QueryAsset(xtp_session_id_, req_id_++);
 	if (ret != 0)
@@ -204,7 +204,7 @@ void XTPTradeHandler::QueryTradeAccount(uWS::WebSocket<uWS::SERVER> *ws, TradeAc
 		throw std::runtime_error(buf);
 	}
 }
-void XTPTradeHandler::QueryProduct(uWS::WebSocket<uWS::SERVER> *ws, ProductQuery &query_product)
+void XTPTradeHandler::QueryProduct(WsConnHandle conn, ProductQuery &query_product)
 {
 	throw std::runtime_error("'QueryProduct' not supported in xtp");
 }
@@ -272,12 +272,12 @@ void XTPTradeHandler::OnQueryOrder(XTPQueryOrderRsp *order_info, XTPRI *error_in
 
 	if (is_last)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		OrderQuery order_qry;
-		qry_cache_.GetAndClearCacheQryOrder(request_id, &ws, &order_qry);
+		qry_cache_.GetAndClearCacheQryOrder(request_id, &conn, &order_qry);
 		std::vector<XTPQueryOrderRsp> &orders = rsp_qry_order_caches_[request_id];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<Order> common_orders;
 			std::vector<OrderStatusNotify> common_order_status;
@@ -294,7 +294,7 @@ void XTPTradeHandler::OnQueryOrder(XTPQueryOrderRsp *order_info, XTPRI *error_in
 			if (error_info) {
 				error_id = error_info->error_id;
 			}
-			RspOrderQry(ws, order_qry, common_orders, common_order_status, error_id);
+			RspOrderQry(conn, order_qry, common_orders, common_order_status, error_id);
 		}
 
 		rsp_qry_order_caches_.erase(request_id);
@@ -320,12 +320,12 @@ void XTPTradeHandler::OnQueryTrade(XTPQueryTradeRsp *trade_info, XTPRI *error_in
 
 	if (is_last)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		TradeQuery trade_qry;
-		qry_cache_.GetAndClearCacheQryTrade(request_id, &ws, &trade_qry);
+		qry_cache_.GetAndClearCacheQryTrade(request_id, &conn, &trade_qry);
 		std::vector<XTPQueryTradeRsp> &trades = rsp_qry_trade_caches_[request_id];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<Order> common_orders;
 			std::vector<OrderDealNotify> common_deals;
@@ -342,7 +342,7 @@ void XTPTradeHandler::OnQueryTrade(XTPQueryTradeRsp *trade_info, XTPRI *error_in
 			if (error_info) {
 				error_id = error_info->error_id;
 			}
-			RspTradeQry(ws, trade_qry, common_orders, common_deals, error_id);
+			RspTradeQry(conn, trade_qry, common_orders, common_deals, error_id);
 		}
 
 		rsp_qry_trade_caches_.erase(request_id);
@@ -368,12 +368,12 @@ void XTPTradeHandler::OnQueryPosition(XTPQueryStkPositionRsp *position, XTPRI *e
 
 	if (is_last)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		PositionQuery position_qry;
-		qry_cache_.GetAndCleanCacheQryPosition(request_id, &ws, &position_qry);
+		qry_cache_.GetAndCleanCacheQryPosition(request_id, &conn, &position_qry);
 		std::vector<XTPQueryStkPositionRsp> &xtp_positions = rsp_qry_position_caches_[request_id];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<PositionSummaryType2> positions;
 			for (XTPQueryStkPositionRsp &xtp_position : xtp_positions)
@@ -387,7 +387,7 @@ void XTPTradeHandler::OnQueryPosition(XTPQueryStkPositionRsp *position, XTPRI *e
 			if (error_info) {
 				error_id = error_info->error_id;
 			}
-			RspPositionQryType2(ws, position_qry, positions, error_id);
+			RspPositionQryType2(conn, position_qry, positions, error_id);
 		}
 
 		rsp_qry_position_caches_.erase(request_id);
@@ -413,12 +413,12 @@ void XTPTradeHandler::OnQueryAsset(XTPQueryAssetRsp *asset, XTPRI *error_info, i
 
 	if (is_last)
 	{
-		uWS::WebSocket<uWS::SERVER>* ws;
+		WsConnHandle conn = WS_CONN_INVALID;
 		TradeAccountQuery trade_account_qry;
-		qry_cache_.GetAndCleanCacheQryTradeAccount(request_id, &ws, &trade_account_qry);
+		qry_cache_.GetAndCleanCacheQryTradeAccount(request_id, &conn, &trade_account_qry);
 		std::vector<XTPQueryAssetRsp> &ctp_trade_accounts = rsp_qry_trade_account_caches_[request_id];
 
-		if (ws)
+		if (conn != WS_CONN_INVALID)
 		{
 			std::vector<TradeAccountType2> trade_accounts;
 			for (XTPQueryAssetRsp &xtp_trade_account : ctp_trade_accounts)
@@ -432,7 +432,7 @@ void XTPTradeHandler::OnQueryAsset(XTPQueryAssetRsp *asset, XTPRI *error_info, i
 			if (error_info) {
 				error_id = error_info->error_id;
 			}
-			RspTradeAccountQryType2(ws, trade_account_qry, trade_accounts, error_id);
+			RspTradeAccountQryType2(conn, trade_account_qry, trade_accounts, error_id);
 		}
 
 		rsp_qry_trade_account_caches_.erase(request_id);
@@ -483,30 +483,37 @@ void XTPTradeHandler::RunAPI()
 }
 void XTPTradeHandler::RunService()
 {
-	auto loop_thread = std::thread([&] {
-		uws_hub_.onConnection([&](uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest req) {
-			ws_service_.onConnection(ws, req);
-		});
-		uws_hub_.onMessage([&](uWS::WebSocket<uWS::SERVER> *ws, char *message, size_t length, uWS::OpCode opCode) {
-			ws_service_.onMessage(ws, message, length, opCode);
-		});
-		uws_hub_.onDisconnection([&](uWS::WebSocket<uWS::SERVER> *ws, int code, char *message, size_t length) {
-			ws_service_.onDisconnection(ws, code, message, length);
-		});
-
-		// rest
-		uws_hub_.onHttpRequest([&](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t length, size_t remainingBytes) {
-			http_service_.onMessage(res, req, data, length, remainingBytes);
+	// every hub listens on the same port, the kernel spreads new connections over them
+	std::vector<std::thread> loop_threads;
+	for (int i = 0; i < ws_service_.Hubs(); i++) {
+		loop_threads.emplace_back([&, i] {
+			uWS::Hub &hub = ws_service_.Hub(i);
+			hub.onConnection([&, i](uWS::WebSocket<uWS::SERVER> *ws, uWS::HttpRequest req) {
+				ws_service_.onConnection(i, ws, req);
+			});
+			hub.onMessage([&](uWS::WebSocket<uWS::SERVER> *ws, char *message, size_t length, uWS::OpCode opCode) {
+				ws_service_.onMessage(ws, message, length, opCode);
+			});
+			hub.onDisconnection([&](uWS::WebSocket<uWS::SERVER> *ws, int code, char *message, size_t length) {
+				ws_service_.onDisconnection(ws, code, message, length);
+			});
+
+			// rest
+			hub.onHttpRequest([&](uWS::HttpResponse *res, uWS::HttpRequest req, char *data, size_t length, size_t remainingBytes) {
+				http_service_.onMessage(res, req, data, length, remainingBytes);
+			});
+
+			if (!hub.listen(conf_.trade_ip.c_str(), conf_.trade_port, nullptr, uS::ListenOptions::REUSE_PORT)) {
+				LOG(INFO) << "Failed to listen";
+				exit(-1);
+			}
+			hub.run();
 		});
+	}
 
-		if (!uws_hub_.listen(conf_.trade_ip.c_str(), conf_.trade_port, nullptr, uS::ListenOptions::REUSE_PORT)) {
-			LOG(INFO) << "Failed to listen";
-			exit(-1);
-		}
-		uws_hub_.run();
-	});
-
-	loop_thread.join();
+	for (auto &th : loop_threads) {
+		th.join();
+	}
 }
 
 void XTPTradeHandler::Reconn()
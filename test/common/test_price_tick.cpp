@@ -0,0 +1,86 @@
+#include <float.h>
+#include <math.h>
+#include <string>
+
+#include "common/price_tick.h"
+#include "test_check.h"
+
+using namespace babeltrader;
+
+static PriceTick Tick(double tick)
+{
+	PriceTickTable table;
+	table.Set("rb", "", tick);
+	return table.Find("rb", "1901");
+}
+
+// printed price, "null" when WriteTickPrice refuses it
+static std::string Print(double price, const PriceTick &tick)
+{
+	char buf[32];
+	char *end = WriteTickPrice(buf, price, tick);
+	return end ? std::string(buf, end) : std::string("null");
+}
+
+static void TestDecimals()
+{
+	TEST_CHECK(PriceTickDecimals(1.0) == 0);
+	TEST_CHECK(PriceTickDecimals(5.0) == 0);
+	TEST_CHECK(PriceTickDecimals(0.2) == 1);
+	TEST_CHECK(PriceTickDecimals(0.01) == 2);
+	TEST_CHECK(PriceTickDecimals(0.0025) == 4);
+	TEST_CHECK(PriceTickDecimals(1e-7) == 7);
+	TEST_CHECK(PriceTickDecimals(0.0) == -1);
+	TEST_CHECK(PriceTickDecimals(-0.1) == -1);
+	TEST_CHECK(PriceTickDecimals(NAN) == -1);
+	TEST_CHECK(PriceTickDecimals(1e-12) == -1);
+}
+
+static void TestWrite()
+{
+	TEST_CHECK(Print(3512.2, Tick(0.2)) == "3512.2");
+	TEST_CHECK(Print(10.5, Tick(0.01)) == "10.50");
+	TEST_CHECK(Print(0.07, Tick(0.01)) == "0.07");
+	TEST_CHECK(Print(3512.0, Tick(1.0)) == "3512.0");
+	TEST_CHECK(Print(0.0, Tick(0.5)) == "0.0");
+	TEST_CHECK(Print(-1.5, Tick(0.5)) == "-1.5");
+	TEST_CHECK(Print(-0.05, Tick(0.01)) == "-0.05");
+
+	// binary noise of the double is rounded away
+	TEST_CHECK(Print(0.1 + 0.2, Tick(0.1)) == "0.3");
+	TEST_CHECK(Print(4182.199999999, Tick(0.2)) == "4182.2");
+}
+
+static void TestRefuse()
+{
+	TEST_CHECK(Print(1.0, PriceTick()) == "null");
+	TEST_CHECK(Print(NAN, Tick(0.01)) == "null");
+	TEST_CHECK(Print(INFINITY, Tick(0.01)) == "null");
+	TEST_CHECK(Print(-INFINITY, Tick(0.01)) == "null");
+	TEST_CHECK(Print(DBL_MAX, Tick(0.01)) == "null");
+	TEST_CHECK(Print(1e14, Tick(0.01)) == "null");
+}
+
+static void TestTable()
+{
+	PriceTickTable table;
+	uint64_t version = table.Version();
+	table.Set("rb", "", 1.0);
+	table.Set("rb", "1901", 0.5);
+	table.Set("cu", "", 0.0);
+	TEST_CHECK(table.Version() != version);
+
+	TEST_CHECK(table.Find("rb", "1901").decimals == 1);
+	TEST_CHECK(table.Find("rb", "1905").decimals == 0);
+	TEST_CHECK(table.Find("cu", "1901").decimals == -1);
+	TEST_CHECK(table.Find("ag", "1901").decimals == -1);
+}
+
+int main()
+{
+	TEST_RUN(TestDecimals);
+	TEST_RUN(TestWrite);
+	TEST_RUN(TestRefuse);
+	TEST_RUN(TestTable);
+	return TEST_RESULT();
+}
@@ -0,0 +1,98 @@
+#include <string.h>
+#include <string>
+
+#include "common/enum.h"
+#include "common/quote_binary.h"
+#include "test_check.h"
+
+using namespace babeltrader;
+
+static QuoteKline Kline1(const char *contract)
+{
+	QuoteKline msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.quote_type = QuoteBlockType_Kline;
+	msg.quote.market = Market_CTP;
+	msg.quote.info1 = QuoteInfo1_Kline;
+	msg.quote.info2 = QuoteInfo2_1Min;
+	strcpy(msg.quote.symbol, "rb");
+	strcpy(msg.quote.contract, contract);
+	msg.kline.ts = 1539755434500;
+	return msg;
+}
+
+static uint32_t FrameCount(const std::string &frame)
+{
+	QuoteBinFrameHead head;
+	memcpy(&head, frame.data(), sizeof(head));
+	return head.count;
+}
+
+static void TestIds()
+{
+	QuoteInstrumentTable table;
+	TEST_CHECK(table.GetId(Kline1("1901").quote) == 1);
+	TEST_CHECK(table.GetId(Kline1("1905").quote) == 2);
+	TEST_CHECK(table.GetId(Kline1("1901").quote) == 1);
+
+	std::string frame;
+	uint32_t max_id = 0;
+	table.Snapshot(frame, max_id);
+	TEST_CHECK(max_id == 2);
+	TEST_CHECK(FrameCount(frame) == 2);
+}
+
+static void TestAppend()
+{
+	QuoteInstrumentTable table;
+	table.GetId(Kline1("1901").quote);
+	table.GetId(Kline1("1905").quote);
+	table.GetId(Kline1("1909").quote);
+
+	// only the ids a connection misses
+	std::string frame;
+	table.Append(1, 3, frame);
+	TEST_CHECK(FrameCount(frame) == 2);
+	TEST_CHECK(QuoteBinMaxInstrumentId(frame.data(), frame.size()) == 3);
+
+	QuoteBinRecordHead head;
+	memcpy(&head, frame.data() + sizeof(QuoteBinFrameHead), sizeof(head));
+	TEST_CHECK(head.type == QuoteBinRecordType_Instrument);
+	TEST_CHECK(head.instrument_id == 2);
+
+	// nothing new, or ids not assigned yet
+	frame.clear();
+	table.Append(3, 3, frame);
+	TEST_CHECK(frame.empty());
+	table.Append(2, 10, frame);
+	TEST_CHECK(FrameCount(frame) == 1);
+}
+
+static void TestMaxInstrumentId()
+{
+	QuoteInstrumentTable table;
+	table.GetId(Kline1("1901").quote);
+	QuoteKline msg = Kline1("1905");
+
+	// quote records carry the id only, no instrument record inline
+	std::string rec, frame;
+	QuoteBinSerialize(table, (const QuoteBlockCommon*)&msg, rec, 7);
+	QuoteBinAppend(frame, rec.data(), rec.size());
+	TEST_CHECK(FrameCount(frame) == 2);
+	TEST_CHECK(QuoteBinMaxInstrumentId(frame.data(), frame.size()) == 2);
+
+	QuoteBinRecordHead head;
+	memcpy(&head, frame.data() + sizeof(QuoteBinFrameHead), sizeof(head));
+	TEST_CHECK(head.type == QuoteBinRecordType_Seq);
+
+	const std::string &schema = QuoteBinSchema();
+	TEST_CHECK(QuoteBinMaxInstrumentId(schema.data(), schema.size()) == 0);
+}
+
+int main()
+{
+	TEST_RUN(TestIds);
+	TEST_RUN(TestAppend);
+	TEST_RUN(TestMaxInstrumentId);
+	return TEST_RESULT();
+}
@@ -0,0 +1,155 @@
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "common/enum.h"
+#include "common/quote_replay.h"
+#include "test_check.h"
+
+using namespace babeltrader;
+
+static QuoteKline Kline1(int info2, int64_t ts)
+{
+	QuoteKline msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.quote_type = QuoteBlockType_Kline;
+	msg.quote.market = Market_CTP;
+	msg.quote.info1 = QuoteInfo1_Kline;
+	msg.quote.info2 = (uint8_t)info2;
+	strcpy(msg.quote.symbol, "rb");
+	strcpy(msg.quote.contract, "1901");
+	msg.kline.ts = ts;
+	return msg;
+}
+
+// same as QuoteTopicKey
+static std::string Topic()
+{
+	return std::string("rb1901.") + g_quote_info1[QuoteInfo1_Kline];
+}
+
+struct Replayed
+{
+	std::vector<uint64_t> seqs;
+	std::vector<int64_t> ts;
+	std::vector<int> info2s;
+
+	void operator()(const QuoteBlockCommon *msg, uint64_t seq)
+	{
+		seqs.push_back(seq);
+		ts.push_back(((const QuoteKline*)msg)->kline.ts);
+		info2s.push_back(msg->quote.info2);
+	}
+};
+
+static bool Replay(QuoteReplayTable &table, uint64_t seq, Replayed &out)
+{
+	return table.Replay(Topic(), seq, [&out](const QuoteBlockCommon *msg, uint64_t seq) { out(msg, seq); });
+}
+
+static void TestStamp()
+{
+	QuoteReplayTable table(4);
+	TEST_CHECK(table.LastSeq(Topic()) == 0);
+
+	for (int i = 1; i <= 3; i++) {
+		QuoteKline msg = Kline1(QuoteInfo2_1Min, i);
+		TEST_CHECK(table.Stamp((const QuoteBlockCommon*)&msg) == (uint64_t)i);
+	}
+	TEST_CHECK(table.LastSeq(Topic()) == 3);
+
+	// other topics count by themselves
+	QuoteKline other = Kline1(QuoteInfo2_1Min, 1);
+	strcpy(other.quote.contract, "1905");
+	TEST_CHECK(table.Stamp((const QuoteBlockCommon*)&other) == 1);
+	TEST_CHECK(table.LastSeq(Topic()) == 3);
+}
+
+static void TestReplayBoundaries()
+{
+	QuoteReplayTable table(4);
+	for (int i = 1; i <= 10; i++) {
+		QuoteKline msg = Kline1(QuoteInfo2_1Min, i * 100);
+		table.Stamp((const QuoteBlockCommon*)&msg);
+	}
+
+	// kept are (10 - 4, 10], a client at 6 misses nothing
+	Replayed out;
+	TEST_CHECK(Replay(table, 6, out));
+	TEST_CHECK(out.seqs == std::vector<uint64_t>({7, 8, 9, 10}));
+	TEST_CHECK(out.ts == std::vector<int64_t>({700, 800, 900, 1000}));
+
+	// one older than kept, nothing is called
+	out = Replayed();
+	TEST_CHECK(!Replay(table, 5, out));
+	TEST_CHECK(out.seqs.empty());
+	TEST_CHECK(!Replay(table, 0, out));
+	TEST_CHECK(out.seqs.empty());
+
+	// up to date
+	TEST_CHECK(Replay(table, 10, out));
+	TEST_CHECK(out.seqs.empty());
+
+	// from the future, e.g. seq of a previous run of the gateway
+	TEST_CHECK(!Replay(table, 11, out));
+	TEST_CHECK(out.seqs.empty());
+}
+
+static void TestReplayBeforeWrap()
+{
+	QuoteReplayTable table(4);
+	for (int i = 1; i <= 3; i++) {
+		QuoteKline msg = Kline1(QuoteInfo2_1Min, i);
+		table.Stamp((const QuoteBlockCommon*)&msg);
+	}
+
+	Replayed out;
+	TEST_CHECK(Replay(table, 0, out));
+	TEST_CHECK(out.seqs == std::vector<uint64_t>({1, 2, 3}));
+
+	// unknown topic has nothing after 0
+	out = Replayed();
+	TEST_CHECK(table.Replay("xx.kline", 0, [&out](const QuoteBlockCommon *msg, uint64_t seq) { out(msg, seq); }));
+	TEST_CHECK(out.seqs.empty());
+	TEST_CHECK(!table.Replay("xx.kline", 1, [&out](const QuoteBlockCommon *msg, uint64_t seq) { out(msg, seq); }));
+}
+
+static void TestSnapshot()
+{
+	QuoteReplayTable table(4);
+
+	// the 1h bar falls out of the replay ring long before the next one
+	QuoteKline hour = Kline1(QuoteInfo2_1Hour, 3600);
+	table.Stamp((const QuoteBlockCommon*)&hour);
+	for (int i = 1; i <= 10; i++) {
+		QuoteKline msg = Kline1(QuoteInfo2_1Min, i * 60);
+		table.Stamp((const QuoteBlockCommon*)&msg);
+	}
+
+	Replayed out;
+	table.Snapshot(Topic(), [&out](const QuoteBlockCommon *msg, uint64_t seq) { out(msg, seq); });
+	TEST_CHECK(out.seqs == std::vector<uint64_t>({1, 11}));
+	TEST_CHECK(out.info2s == std::vector<int>({QuoteInfo2_1Hour, QuoteInfo2_1Min}));
+	TEST_CHECK(out.ts == std::vector<int64_t>({3600, 600}));
+
+	// newer quote of an interval replaces its entry, order follows seq
+	hour.kline.ts = 7200;
+	table.Stamp((const QuoteBlockCommon*)&hour);
+	out = Replayed();
+	table.Snapshot(Topic(), [&out](const QuoteBlockCommon *msg, uint64_t seq) { out(msg, seq); });
+	TEST_CHECK(out.seqs == std::vector<uint64_t>({11, 12}));
+	TEST_CHECK(out.ts == std::vector<int64_t>({600, 7200}));
+
+	out = Replayed();
+	table.Snapshot("xx.kline", [&out](const QuoteBlockCommon *msg, uint64_t seq) { out(msg, seq); });
+	TEST_CHECK(out.seqs.empty());
+}
+
+int main()
+{
+	TEST_RUN(TestStamp);
+	TEST_RUN(TestReplayBoundaries);
+	TEST_RUN(TestReplayBeforeWrap);
+	TEST_RUN(TestSnapshot);
+	return TEST_RESULT();
+}
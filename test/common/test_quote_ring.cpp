@@ -0,0 +1,192 @@
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "common/quote_ring.h"
+#include "test_check.h"
+
+using namespace babeltrader;
+
+// record of len bytes, every byte is the low byte of id
+static bool WriteRec(QuoteRing &ring, uint32_t id, uint32_t len)
+{
+	std::string rec(len, (char)id);
+	memcpy(&rec[0], &id, len < sizeof(id) ? len : sizeof(id));
+	return ring.Write(rec.data(), len);
+}
+
+static bool ReadRec(QuoteRing &ring, uint32_t id, uint32_t len)
+{
+	uint32_t rec_len = 0;
+	const char *rec = (const char*)ring.Front(&rec_len);
+	if (rec == nullptr || rec_len != len) {
+		return false;
+	}
+
+	std::string expect(len, (char)id);
+	memcpy(&expect[0], &id, len < sizeof(id) ? len : sizeof(id));
+	bool same = memcmp(rec, expect.data(), len) == 0;
+	ring.Pop();
+	return same;
+}
+
+static void TestCapacity()
+{
+	QuoteRing ring(100);
+	QuoteRingStats stats;
+	ring.GetStats(stats);
+	TEST_CHECK(stats.capacity == 128);
+
+	QuoteRing small(1);
+	small.GetStats(stats);
+	TEST_CHECK(stats.capacity == QUOTE_RING_CACHE_LINE);
+}
+
+static void TestWrapPadding()
+{
+	// 40 bytes payload + 8 bytes head, two records fill 96 of 128 bytes
+	QuoteRing ring(128);
+	TEST_CHECK(WriteRec(ring, 1, 40));
+	TEST_CHECK(WriteRec(ring, 2, 40));
+	TEST_CHECK(ReadRec(ring, 1, 40));
+	TEST_CHECK(ReadRec(ring, 2, 40));
+
+	// 32 bytes left at the tail, the record goes to the start and the tail is padding
+	TEST_CHECK(WriteRec(ring, 3, 40));
+	QuoteRingStats stats;
+	ring.GetStats(stats);
+	TEST_CHECK(stats.depth_bytes == 32 + 48);
+	TEST_CHECK(stats.depth_records == 1);
+
+	TEST_CHECK(WriteRec(ring, 4, 40));
+	TEST_CHECK(ReadRec(ring, 3, 40));
+	TEST_CHECK(ReadRec(ring, 4, 40));
+
+	uint32_t len = 0;
+	TEST_CHECK(ring.Front(&len) == nullptr);
+	ring.GetStats(stats);
+	TEST_CHECK(stats.depth_bytes == 0);
+	TEST_CHECK(stats.depth_records == 0);
+	TEST_CHECK(stats.write_records == 4);
+	TEST_CHECK(stats.read_records == 4);
+	TEST_CHECK(stats.drop_records == 0);
+}
+
+static void TestWrapEmpty()
+{
+	// tail of 56 bytes can't take a 64 bytes record, the padding and the record
+	// together still fit once the ring is empty
+	for (int overflow = 0; overflow < QuoteRingOverflow_Max; overflow++) {
+		QuoteRing ring(128, overflow);
+		for (uint32_t i = 0; i < 3; i++) {
+			TEST_CHECK(WriteRec(ring, i, 16));
+			TEST_CHECK(ReadRec(ring, i, 16));
+		}
+		TEST_CHECK(WriteRec(ring, 3, 56));
+		TEST_CHECK(ReadRec(ring, 3, 56));
+
+		QuoteRingStats stats;
+		ring.GetStats(stats);
+		TEST_CHECK(stats.drop_records == 0);
+	}
+
+	// more than half the ring is refused, it may never fit
+	QuoteRing ring(128, QuoteRingOverflow_Block);
+	TEST_CHECK(!WriteRec(ring, 4, 57));
+	QuoteRingStats stats;
+	ring.GetStats(stats);
+	TEST_CHECK(stats.drop_records == 1);
+}
+
+static void TestDrop()
+{
+	QuoteRing ring(128, QuoteRingOverflow_Drop);
+	TEST_CHECK(WriteRec(ring, 1, 40));
+	TEST_CHECK(WriteRec(ring, 2, 40));
+	TEST_CHECK(!WriteRec(ring, 3, 40));
+
+	// empty and larger than half the ring are never taken
+	TEST_CHECK(!ring.Write("", 0));
+	TEST_CHECK(!WriteRec(ring, 4, 100));
+
+	QuoteRingStats stats;
+	ring.GetStats(stats);
+	TEST_CHECK(stats.drop_records == 3);
+	TEST_CHECK(stats.write_records == 2);
+
+	// space comes back after read, dropped records are gone
+	TEST_CHECK(ReadRec(ring, 1, 40));
+	TEST_CHECK(WriteRec(ring, 5, 40));
+	TEST_CHECK(ReadRec(ring, 2, 40));
+	TEST_CHECK(ReadRec(ring, 5, 40));
+}
+
+static void TestOrder()
+{
+	// fill and drain with varying sizes, so records and padding land everywhere
+	QuoteRing ring(256);
+	uint32_t next_write = 0, next_read = 0;
+	for (int round = 0; round < 200; round++) {
+		while (WriteRec(ring, next_write, 1 + next_write % 61)) {
+			next_write++;
+		}
+		while (next_read < next_write) {
+			if (!ReadRec(ring, next_read, 1 + next_read % 61)) {
+				TEST_CHECK(false);
+				return;
+			}
+			next_read++;
+		}
+	}
+
+	uint32_t len = 0;
+	TEST_CHECK(ring.Front(&len) == nullptr);
+	TEST_CHECK(next_read > 200);
+}
+
+static void TestBlock()
+{
+	QuoteRing ring(128, QuoteRingOverflow_Block);
+	const uint32_t cnt = 100;
+	std::thread producer([&ring, cnt]() {
+		for (uint32_t i = 0; i < cnt; i++) {
+			WriteRec(ring, i, 40);
+		}
+	});
+
+	// producer fills the ring and waits
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	QuoteRingStats stats;
+	ring.GetStats(stats);
+	TEST_CHECK(stats.depth_records == 2);
+
+	uint32_t i = 0;
+	while (i < cnt) {
+		// readable may be tail padding before a record not committed yet
+		uint32_t len = 0;
+		if (ring.Front(&len) == nullptr) {
+			ring.Wait(1);
+			continue;
+		}
+		TEST_CHECK(ReadRec(ring, i, 40));
+		i++;
+	}
+	producer.join();
+
+	ring.GetStats(stats);
+	TEST_CHECK(stats.block_records > 0);
+	TEST_CHECK(stats.drop_records == 0);
+	TEST_CHECK(stats.read_records == cnt);
+}
+
+int main()
+{
+	TEST_RUN(TestCapacity);
+	TEST_RUN(TestWrapPadding);
+	TEST_RUN(TestWrapEmpty);
+	TEST_RUN(TestDrop);
+	TEST_RUN(TestOrder);
+	TEST_RUN(TestBlock);
+	return TEST_RESULT();
+}
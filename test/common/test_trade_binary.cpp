@@ -0,0 +1,185 @@
+#include <string.h>
+#include <string>
+
+#include "common/err.h"
+#include "common/enum.h"
+#include "common/trade_binary.h"
+#include "test_check.h"
+
+using namespace babeltrader;
+
+static std::string InsertOrderMsg()
+{
+	TradeBinHead head;
+	memset(&head, 0, sizeof(head));
+	head.magic = TRADE_BIN_MAGIC;
+	head.version = TRADE_BIN_VERSION;
+	head.msg_type = TradeBinMsg_InsertOrder;
+	head.len = sizeof(TradeBinHead) + sizeof(TradeBinOrder);
+
+	TradeBinOrder order;
+	memset(&order, 0, sizeof(order));
+	strcpy(order.user_id, "weidaizi");
+	strcpy(order.client_order_id, "c-1");
+	strcpy(order.symbol, "rb");
+	strcpy(order.contract, "1901");
+	order.market = Market_CTP;
+	order.dir = OrderAction_Buy;
+	order.price = 3512 * TRADE_BIN_PRICE_SCALE + TRADE_BIN_PRICE_SCALE / 2;
+	order.amount = 2;
+	order.ts = 1539755434500;
+
+	std::string msg((const char*)&head, sizeof(head));
+	msg.append((const char*)&order, sizeof(order));
+	return msg;
+}
+
+static int Parse(const std::string &msg, uint8_t &msg_type, Order &order)
+{
+	return TradeBinParseRequest(msg.data(), msg.size(), msg_type, order);
+}
+
+static void TestParse()
+{
+	uint8_t msg_type = 0;
+	Order order;
+	TEST_CHECK(Parse(InsertOrderMsg(), msg_type, order) == BABELTRADER_OK);
+	TEST_CHECK(msg_type == TradeBinMsg_InsertOrder);
+	TEST_CHECK(order.user_id == "weidaizi");
+	TEST_CHECK(order.client_order_id == "c-1");
+	TEST_CHECK(order.symbol == "rb");
+	TEST_CHECK(order.contract == "1901");
+	TEST_CHECK(order.market == "ctp");
+	TEST_CHECK(order.dir == "buy");
+	TEST_CHECK(order.price == 3512.5);
+	TEST_CHECK(order.amount == 2);
+	TEST_CHECK(order.ts == 1539755434500);
+}
+
+static void TestSize()
+{
+	uint8_t msg_type = 0;
+	Order order;
+	std::string msg = InsertOrderMsg();
+
+	// shorter than head
+	TEST_CHECK(TradeBinParseRequest(msg.data(), sizeof(TradeBinHead) - 1, msg_type, order) == BABELTRADER_ERR_WSREQ_FAILED_PARSE);
+	TEST_CHECK(TradeBinParseRequest(msg.data(), 0, msg_type, order) == BABELTRADER_ERR_WSREQ_FAILED_PARSE);
+
+	// frame cut, head.len no longer matches
+	TEST_CHECK(TradeBinParseRequest(msg.data(), msg.size() - 1, msg_type, order) == BABELTRADER_ERR_WSREQ_FAILED_PARSE);
+
+	// trailing bytes
+	std::string longer = msg + std::string(1, '\0');
+	TEST_CHECK(Parse(longer, msg_type, order) == BABELTRADER_ERR_WSREQ_FAILED_PARSE);
+
+	// head.len agrees with the frame, but the body is not an order
+	std::string short_body = msg.substr(0, sizeof(TradeBinHead) + 8);
+	TradeBinHead head;
+	memcpy(&head, short_body.data(), sizeof(head));
+	head.len = (uint32_t)short_body.size();
+	memcpy(&short_body[0], &head, sizeof(head));
+	TEST_CHECK(Parse(short_body, msg_type, order) == BABELTRADER_ERR_WSREQ_FAILED_PARSE);
+}
+
+static void TestHead()
+{
+	uint8_t msg_type = 0;
+	Order order;
+	TradeBinHead head;
+
+	std::string bad_magic = InsertOrderMsg();
+	memcpy(&head, bad_magic.data(), sizeof(head));
+	head.magic = 0x4254;
+	memcpy(&bad_magic[0], &head, sizeof(head));
+	TEST_CHECK(Parse(bad_magic, msg_type, order) == BABELTRADER_ERR_WSREQ_FAILED_PARSE);
+
+	std::string bad_version = InsertOrderMsg();
+	memcpy(&head, bad_version.data(), sizeof(head));
+	head.version = TRADE_BIN_VERSION + 1;
+	memcpy(&bad_version[0], &head, sizeof(head));
+	TEST_CHECK(Parse(bad_version, msg_type, order) == BABELTRADER_ERR_WSREQ_FAILED_PARSE);
+
+	// pushes are not requests, msg_type is still given back for the error reply
+	std::string push = InsertOrderMsg();
+	memcpy(&head, push.data(), sizeof(head));
+	head.msg_type = TradeBinMsg_ConfirmOrder;
+	memcpy(&push[0], &head, sizeof(head));
+	TEST_CHECK(Parse(push, msg_type, order) == BABELTRADER_ERR_WSREQ_NOT_HANDLE);
+	TEST_CHECK(msg_type == TradeBinMsg_ConfirmOrder);
+
+	std::string cancel = InsertOrderMsg();
+	memcpy(&head, cancel.data(), sizeof(head));
+	head.msg_type = TradeBinMsg_CancelOrder;
+	memcpy(&cancel[0], &head, sizeof(head));
+	TEST_CHECK(Parse(cancel, msg_type, order) == BABELTRADER_OK);
+	TEST_CHECK(msg_type == TradeBinMsg_CancelOrder);
+}
+
+static void TestStringCut()
+{
+	// a field without zero is cut at its length
+	std::string msg = InsertOrderMsg();
+	TradeBinOrder bin;
+	memcpy(&bin, msg.data() + sizeof(TradeBinHead), sizeof(bin));
+	memset(bin.symbol, 'x', sizeof(bin.symbol));
+	memcpy(&msg[sizeof(TradeBinHead)], &bin, sizeof(bin));
+
+	uint8_t msg_type = 0;
+	Order order;
+	TEST_CHECK(Parse(msg, msg_type, order) == BABELTRADER_OK);
+	TEST_CHECK(order.symbol.size() <= TRADE_BIN_SYMBOL_LEN);
+	TEST_CHECK(order.contract == "1901");
+}
+
+static void TestDirRoundTrip()
+{
+	// ctp orders carry action and position together
+	const char *dirs[] = {
+		"buy", "sell", "open_long", "open_short", "close_long", "close_short",
+		"closetoday_long", "closetoday_short", "closehistory_long", "closehistory_short",
+		"forceclose_long", "forceclose_short"
+	};
+	for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+		Order src;
+		src.user_id = "weidaizi";
+		src.market = "ctp";
+		src.symbol = "rb";
+		src.contract = "1901";
+		src.dir = dirs[i];
+
+		std::string msg;
+		TradeBinSerializeConfirmOrder(src, 0, msg);
+		TEST_CHECK(msg.size() == sizeof(TradeBinHead) + sizeof(TradeBinOrder));
+
+		// the same body is a valid request
+		TradeBinHead head;
+		memcpy(&head, msg.data(), sizeof(head));
+		head.msg_type = TradeBinMsg_InsertOrder;
+		memcpy(&msg[0], &head, sizeof(head));
+
+		uint8_t msg_type = 0;
+		Order order;
+		TEST_CHECK(Parse(msg, msg_type, order) == BABELTRADER_OK);
+		TEST_CHECK(order.dir == dirs[i]);
+	}
+
+	Order src;
+	src.dir = "closetoday_short";
+	std::string msg;
+	TradeBinSerializeConfirmOrder(src, 0, msg);
+	TradeBinOrder bin;
+	memcpy(&bin, msg.data() + sizeof(TradeBinHead), sizeof(bin));
+	TEST_CHECK(bin.dir == OrderAction_CloseToday);
+	TEST_CHECK(bin.position_dir == OrderDir_Short);
+}
+
+int main()
+{
+	TEST_RUN(TestParse);
+	TEST_RUN(TestSize);
+	TEST_RUN(TestHead);
+	TEST_RUN(TestStringCut);
+	TEST_RUN(TestDirRoundTrip);
+	return TEST_RESULT();
+}
@@ -0,0 +1,128 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common/ws_conn_table.h"
+#include "test_check.h"
+
+using namespace babeltrader;
+
+// the table never touches sockets, any distinct address works
+static uWS::WebSocket<uWS::SERVER>* FakeWs(int i)
+{
+	static char sockets[16];
+	return (uWS::WebSocket<uWS::SERVER>*)&sockets[i];
+}
+
+static void TestPin()
+{
+	WsConnTable table;
+	WsConnHandle conn = table.Add(FakeWs(1), WsConnFlag_BinOrder | (3u << WS_CONN_HUB_SHIFT));
+	TEST_CHECK(conn != WS_CONN_INVALID);
+	TEST_CHECK(table.Size() == 1);
+	TEST_CHECK(table.PeekFlags(conn) & WsConnFlag_BinOrder);
+	TEST_CHECK(WsConnHub(table.PeekFlags(conn)) == 3);
+
+	uint32_t flags = 0;
+	TEST_CHECK(table.Pin(conn, &flags) == FakeWs(1));
+	TEST_CHECK(flags == (WsConnFlag_BinOrder | (3u << WS_CONN_HUB_SHIFT)));
+	table.Unpin(conn);
+
+	{
+		WsConnRef ref(table, conn);
+		TEST_CHECK(ref);
+		TEST_CHECK(ref.ws() == FakeWs(1));
+	}
+
+	TEST_CHECK(table.Pin(WS_CONN_INVALID) == nullptr);
+	TEST_CHECK(table.PeekFlags(WS_CONN_INVALID) == 0);
+}
+
+static void TestRemove()
+{
+	WsConnTable table;
+	WsConnHandle conn = table.Add(FakeWs(1), 0);
+	table.Remove(conn);
+	TEST_CHECK(table.Size() == 0);
+	TEST_CHECK(table.Pin(conn) == nullptr);
+	TEST_CHECK(table.PeekFlags(conn) == 0);
+
+	WsConnRef ref(table, conn);
+	TEST_CHECK(!ref);
+
+	// a second remove of the same handle is ignored
+	table.Remove(conn);
+	TEST_CHECK(table.Size() == 0);
+}
+
+static void TestGeneration()
+{
+	WsConnTable table;
+	WsConnHandle old_conn = table.Add(FakeWs(1), WsConnFlag_BinOrder);
+	table.Remove(old_conn);
+
+	// the slot is reused with a new generation, the old handle stays dead
+	WsConnHandle conn = table.Add(FakeWs(2), 0);
+	TEST_CHECK(conn != old_conn);
+	TEST_CHECK((conn & 0xFFFFFFFFull) == (old_conn & 0xFFFFFFFFull));
+	TEST_CHECK(table.Pin(old_conn) == nullptr);
+	TEST_CHECK(table.PeekFlags(old_conn) == 0);
+
+	// removing by the old handle leaves the new connection alone
+	table.Remove(old_conn);
+	TEST_CHECK(table.Size() == 1);
+	TEST_CHECK(table.Pin(conn) == FakeWs(2));
+	table.Unpin(conn);
+}
+
+static void TestRemoveWaitsPin()
+{
+	WsConnTable table;
+	WsConnHandle conn = table.Add(FakeWs(1), 0);
+	TEST_CHECK(table.Pin(conn) == FakeWs(1));
+
+	std::atomic<bool> removed(false);
+	std::thread th([&]() {
+		table.Remove(conn);
+		removed.store(true);
+	});
+
+	// no new pins once remove started, the old one holds it
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	TEST_CHECK(!removed.load());
+	TEST_CHECK(table.Pin(conn) == nullptr);
+
+	table.Unpin(conn);
+	th.join();
+	TEST_CHECK(removed.load());
+	TEST_CHECK(table.Size() == 0);
+}
+
+static void TestForEach()
+{
+	WsConnTable table;
+	std::vector<WsConnHandle> conns;
+	for (int i = 0; i < 4; i++) {
+		conns.push_back(table.Add(FakeWs(i), (uint32_t)i << WS_CONN_HUB_SHIFT));
+	}
+	table.Remove(conns[1]);
+
+	int cnt = 0;
+	table.ForEach([&](WsConnHandle conn, uWS::WebSocket<uWS::SERVER> *ws, uint32_t flags) {
+		TEST_CHECK(conn != conns[1]);
+		TEST_CHECK(ws == FakeWs(WsConnHub(flags)));
+		cnt++;
+	});
+	TEST_CHECK(cnt == 3);
+}
+
+int main()
+{
+	TEST_RUN(TestPin);
+	TEST_RUN(TestRemove);
+	TEST_RUN(TestGeneration);
+	TEST_RUN(TestRemoveWaitsPin);
+	TEST_RUN(TestForEach);
+	return TEST_RESULT();
+}
@@ -0,0 +1,25 @@
+#ifndef BABELTRADER_TEST_CHECK_H_
+#define BABELTRADER_TEST_CHECK_H_
+
+#include <stdio.h>
+
+// minimal checks for unit tests, a failed check is reported and the test goes on,
+// main returns TEST_RESULT() so ctest sees the failure
+static int g_test_failed = 0;
+
+#define TEST_CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		g_test_failed++; \
+	} \
+} while (0)
+
+#define TEST_RUN(fn) do { \
+	int failed = g_test_failed; \
+	fn(); \
+	fprintf(stderr, "%s %s\n", failed == g_test_failed ? "ok  " : "FAIL", #fn); \
+} while (0)
+
+#define TEST_RESULT() (g_test_failed == 0 ? 0 : 1)
+
+#endif